@@ -7,7 +7,26 @@
 
 const char *WIFI_SSID = "";
 const char *WIFI_PASSWORD = "";
-const char *serverUrl = "http://192.168.1.200/sensor"; // Your first ESP's IP
+// Aggregators in order of preference; the next one takes over when a POST fails
+const char *serverUrls[] = {"http://192.168.1.200/sensor", "http://192.168.1.201/sensor"};
+const int SERVER_COUNT = sizeof(serverUrls) / sizeof(serverUrls[0]);
+int currentServer = 0;
+uint32_t sendSeq = 0; // lets the aggregator drop copies sent during failover
+
+// Touch interrupt state - the ISR fires while the pad reads below threshold
+volatile bool touchPending = false;
+volatile unsigned long touchEdgesCaptured = 0;
+unsigned long touchEdgesSent = 0;
+bool touchActive = false;
+
+void IRAM_ATTR onTouch()
+{
+    if (!touchPending)
+    {
+        touchPending = true;
+        touchEdgesCaptured++;
+    }
+}
 
 // Generate a unique client ID using the ESP's MAC address
 String getUniqueClientId()
@@ -38,6 +57,37 @@ void setup()
     Serial.println(WiFi.localIP());
     Serial.print("Client ID: ");
     Serial.println(getUniqueClientId());
+
+    touchAttachInterrupt(TOUCH_PIN, onTouch, TOUCH_THRESHOLD);
+    sendSeq = esp_random(); // a restart must not land inside the aggregator's dedup window
+}
+
+void sendTouchValue(int touchValue, int sensorValue)
+{
+    String clientId = getUniqueClientId();
+    String postData = "clientId=" + clientId + "&value=" + String(sensorValue) + "&seq=" + String(++sendSeq);
+
+    // Try each aggregator once, starting with the one that last answered
+    for (int attempt = 0; attempt < SERVER_COUNT; attempt++)
+    {
+        HTTPClient http;
+        http.setTimeout(1000);
+        http.begin(serverUrls[currentServer]);
+        http.addHeader("Content-Type", "application/x-www-form-urlencoded");
+        int httpResponseCode = http.POST(postData);
+        http.end();
+
+        if (httpResponseCode == 200)
+        {
+            Serial.printf("Touch: %d, Value: %d (edges %lu/%lu)\n", touchValue, sensorValue, touchEdgesSent, touchEdgesCaptured);
+            return;
+        }
+
+        Serial.printf("Error %d from %s: %s\n", httpResponseCode, serverUrls[currentServer], HTTPClient::errorToString(httpResponseCode).c_str());
+        if (httpResponseCode > 0 && httpResponseCode < 500)
+            return; // rejected, not unreachable
+        currentServer = (currentServer + 1) % SERVER_COUNT;
+    }
 }
 
 void loop()
@@ -45,35 +95,34 @@ void loop()
     static unsigned long lastUpdate = 0;
     unsigned long currentMillis = millis();
 
+    if (WiFi.status() == WL_CONNECTED)
+    {
+        // A press caught by the interrupt is sent at once instead of on the next poll
+        if (touchPending && !touchActive)
+        {
+            touchActive = true;
+            touchEdgesSent++;
+            sendTouchValue(touchRead(TOUCH_PIN), 1);
+            lastUpdate = currentMillis;
+        }
+        else if (touchActive && touchRead(TOUCH_PIN) >= TOUCH_THRESHOLD)
+        {
+            // Release has no interrupt; detect it on the fast path too
+            touchActive = false;
+            touchPending = false;
+            sendTouchValue(touchRead(TOUCH_PIN), 0);
+            lastUpdate = currentMillis;
+        }
+    }
+
     if (currentMillis - lastUpdate >= 100)
     {
         if (WiFi.status() == WL_CONNECTED)
         {
-            HTTPClient http;
-
             // Read touch sensor
             int touchValue = touchRead(TOUCH_PIN);
             int sensorValue = (touchValue < TOUCH_THRESHOLD) ? 1 : 0;
-
-            // Send data to server
-            http.begin(serverUrl);
-            http.addHeader("Content-Type", "application/x-www-form-urlencoded");
-
-            String clientId = getUniqueClientId();
-            String postData = "clientId=" + clientId + "&value=" + String(sensorValue);
-
-            int httpResponseCode = http.POST(postData);
-
-            if (httpResponseCode == 200)
-            {
-                Serial.printf("Touch: %d, Value: %d\n", touchValue, sensorValue);
-            }
-            else
-            {
-                Serial.printf("Error %d: %s\n", httpResponseCode, http.errorToString(httpResponseCode).c_str());
-            }
-
-            http.end();
+            sendTouchValue(touchValue, sensorValue);
         }
         else
         {
@@ -0,0 +1,41 @@
+#ifndef ADMISSION_CONTROL_H
+#define ADMISSION_CONTROL_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "response_arena.h"
+
+// Per-sender token buckets for the ingest routes, so one client flooding
+// /sensor cannot starve the others. Each sender may burst ADMISSION_BURST
+// requests and sustain ADMISSION_RATE per second. Tokens are kept in
+// thousandths, so refilling is one multiply by elapsed ms. Used from the
+// server task only.
+class AdmissionControl
+{
+private:
+    struct Bucket
+    {
+        uint32_t ip;
+        uint32_t milliTokens;
+        uint32_t refilledAt;
+        uint32_t lastUsed;
+        uint32_t admitted;
+        uint32_t rejected;
+    };
+
+    Bucket buckets[MAX_TRACKED_SENSORS];
+    uint32_t rejectedCount;
+
+    Bucket *findOrRecycle(uint32_t ip, uint32_t now);
+
+public:
+    AdmissionControl();
+
+    // Takes one token; on false, retryAfterMs is when the next one is due
+    bool admit(uint32_t ip, uint32_t now, uint32_t &retryAfterMs);
+
+    uint32_t getRejectedCount() const { return rejectedCount; }
+    void writeJSON(JsonWriter &json) const; // senders that were rejected at least once
+};
+
+#endif // ADMISSION_CONTROL_H
@@ -0,0 +1,61 @@
+#ifndef BINARY_WRITER_H
+#define BINARY_WRITER_H
+
+#include <Arduino.h>
+
+enum class BinaryFormat : uint8_t
+{
+    Cbor,   // RFC 8949, application/cbor
+    MsgPack // application/msgpack
+};
+
+// CBOR or MessagePack into a caller's buffer, with the same key/value calls
+// as JsonWriter so one template can emit either. Maps and arrays carry
+// their item count up front; floats go out as 32-bit IEEE, and fixed()
+// sends a fixed-point value as an integer when it has no decimals and as a
+// float otherwise. Output that does not fit marks the writer as overflowed.
+class BinaryWriter
+{
+private:
+    BinaryFormat format;
+    uint8_t *buf;
+    size_t capacity;
+    size_t len;
+    bool overflowed;
+
+    void put(uint8_t byte);
+    void put(const void *data, size_t length);
+    void putBigEndian(uint32_t v, size_t bytes);
+    void cborHead(uint8_t major, uint32_t v);
+    void container(uint8_t cborMajor, uint8_t fixBase, uint8_t wide16, size_t count);
+
+public:
+    BinaryWriter(BinaryFormat format, uint8_t *buffer, size_t capacity);
+
+    BinaryWriter &beginObject(size_t count);
+    BinaryWriter &endObject() { return *this; }
+    BinaryWriter &beginArray(size_t count);
+    BinaryWriter &endArray() { return *this; }
+    BinaryWriter &key(const char *name) { return value(name); }
+
+    BinaryWriter &value(const char *text);
+    BinaryWriter &value(long number);
+    BinaryWriter &value(unsigned long number);
+    BinaryWriter &value(int number) { return value((long)number); }
+    BinaryWriter &value(unsigned number) { return value((unsigned long)number); }
+    BinaryWriter &value(float number, int decimals = 0); // decimals only matter to JSON
+    BinaryWriter &value(bool flag);
+    BinaryWriter &fixed(int32_t scaled, uint8_t decimals); // integer when decimals is 0, else float
+    BinaryWriter &ip(uint32_t address);
+    BinaryWriter &ipKey(uint32_t address) { return ip(address); }
+
+    template <typename T>
+    BinaryWriter &field(const char *name, T v) { return key(name).value(v); }
+
+    bool ok() const { return !overflowed; }
+    const uint8_t *data() const { return buf; }
+    size_t length() const { return len; }
+    const char *contentType() const;
+};
+
+#endif // BINARY_WRITER_H
@@ -15,8 +15,15 @@ extern const IPAddress DNS_SERVER;
 
 // Hardware pin definitions
 #define RGB_LED_PIN 48
+#define TOUCH_PIN 13
 #define NUM_PIXELS 1
 
+// Status LED animation
+#define LED_FRAME_INTERVAL 20   // Animation step; the strip is written only on change
+#define LED_BLINK_PERIOD 1000   // Connecting
+#define LED_BREATHE_PERIOD 2000 // Waiting to retry WiFi
+#define LED_FLASH_DURATION 150  // Touch flash fade-out
+
 // Server configuration
 #define WEB_SERVER_PORT 80
 #define OTA_PASSWORD "admin"
@@ -25,6 +32,137 @@ extern const IPAddress DNS_SERVER;
 // Timing constants
 #define RECONNECT_INTERVAL 10000   // 10 seconds
 #define SENSOR_UPDATE_INTERVAL 200 // 200ms
-#define CONNECTION_TIMEOUT 20      // 20 attempts (10 seconds)
+
+// loop() job scheduler (timer wheel)
+#define SCHED_MAX_JOBS 16
+#define SCHED_WIFI_INTERVAL 50       // WiFi events, reconnect timers and OTA
+#define SCHED_INGEST_INTERVAL 5      // Samples queued by the server task are applied this often
+#define SCHED_GATEWAY_INTERVAL 50    // Gateway socket service; frames still go every GATEWAY_INTERVAL
+#define SCHED_METRICS_INTERVAL 30000 // Scheduler stats on Serial
+#define SCHED_HEAP_INTERVAL 1000     // Free heap and largest block sampled this often
+
+// WiFi connection state machine
+#define WIFI_FAST_CONNECT_TIMEOUT 3000 // Cached channel/BSSID attempt before falling back to a scan
+#define WIFI_LEASE_CHECK_TIME 300      // Wait for ARP answers before trusting a cached lease
+#define WIFI_FULL_CONNECT_TIMEOUT 10000
+#define WIFI_RETRY_MIN_INTERVAL 500    // First retry; doubles up to RECONNECT_INTERVAL
+#define WIFI_EVENT_QUEUE_SIZE 8        // Must be a power of two
+
+// HTTP server configuration
+#define HTTP_MAX_CONNECTIONS 8      // Sockets multiplexed by the server task
+#define HTTP_RX_BUFFER_SIZE 1536    // Request line, headers and form body per connection
+#define HTTP_UPLOAD_BUFLEN 1436     // Multipart upload chunk handed to upload handlers
+#define HTTP_TX_CHUNK_SIZE 1436     // File bytes sent per socket write
+#define HTTP_ARENA_SIZE 4096        // Scratch for building one response; reset after every request
+#define HTTP_MAX_STREAMS 2          // Chunked /list and large /sensorData responses in flight, per kind
+#define HTTP_IDLE_TIMEOUT 5000      // Close idle keep-alive connections after 5 seconds
+#define HTTP_POLL_INTERVAL 50       // select() timeout in ms
+#define HTTP_SERVER_STACK_SIZE 8192 // Handlers run on this task
+#define HTTP_SERVER_PRIORITY 2
+#define HTTP_SERVER_CORE 0 // Arduino loop() runs on core 1
+
+// Adaptive uplink pacing (client mode)
+#define RATE_MAX_INTERVAL 5000      // Slowest periodic send when congested (ms)
+#define RATE_ADDITIVE_STEP 50       // Interval change per healthy or slow reply (ms)
+#define RATE_RTT_TARGET 150         // Smoothed RTT above which clients ease off (ms)
+#define RATE_BACKPRESSURE_LIMIT 50  // Aggregator hint (% busy) that triggers backoff
+#define RATE_WEAK_RSSI -75          // Below this the minimum interval doubles (dBm)
+#define UPLINK_HTTP_TIMEOUT 1000    // Per-POST timeout so a stalled AP cannot block loop() (ms)
+#define BACKPRESSURE_QUEUE_PERCENT 25 // Ingest fill level at which the aggregator starts hinting
+
+// Multi-destination uplink
+#define UPLINK_MAX_DESTINATIONS 4
+#define UPLINK_FAIL_THRESHOLD 2     // Consecutive failures before an aggregator is marked down
+#define UPLINK_DOWN_RETRY 5000      // A down aggregator is probed again after this long (ms)
+#define UPLINK_HEDGE_ENABLED 0      // 1: give the primary only UPLINK_HEDGE_BUDGET before trying the next
+#define UPLINK_HEDGE_BUDGET 150     // ms
+#define DEDUP_WINDOW 64             // Sequence numbers remembered per sender (max 64)
+
+// Per-sender admission control on /sensor and /sensorBatch (aggregator)
+#define ADMISSION_ENABLED 1
+#define ADMISSION_RATE 20  // Sustained requests per second per sender; clients need about 5 plus touch edges
+#define ADMISSION_BURST 10 // Requests a sender may send back to back
+
+// Offline store-and-forward (client mode)
+#define OFFLINE_RAM_SAMPLES 256          // Samples held in RAM before spilling to flash
+#define OFFLINE_SPILL_FILE "/offline.dat"
+#define OFFLINE_FLASH_MAX_BYTES 65536    // Spill file budget; older overflow is dropped
+#define OFFLINE_BATCH_SIZE 32            // Samples per /sensorBatch POST (fits HTTP_RX_BUFFER_SIZE)
+
+// Low-power client mode
+#define POWER_MODE_ALWAYS_ON 0
+#define POWER_MODE_MODEM_SLEEP 1 // Radio sleeps between DTIM beacons, CPU idles
+#define POWER_MODE_LIGHT_SLEEP 2 // Automatic light sleep; needs CONFIG_PM_ENABLE
+#define POWER_MODE POWER_MODE_ALWAYS_ON
+#define POWER_HEARTBEAT_INTERVAL 5000 // Unchanged state is still sent this often
+#define POWER_BATTERY_DELTA 1.0f      // Battery percent change that triggers a send
+
+// Current-draw model (mA). Rough ESP32 (nodemcu-32s) figures; calibrate with a meter.
+#define POWER_MA_AWAKE 45.0f            // CPU running, radio in modem sleep
+#define POWER_MA_SEND 130.0f            // Average over a POST exchange
+#define POWER_MA_IDLE_ALWAYS_ON 45.0f
+#define POWER_MA_IDLE_MODEM_SLEEP 20.0f
+#define POWER_MA_IDLE_LIGHT_SLEEP 2.5f
+#define POWER_SEND_ACTIVE_MS 40         // Radio time per POST
+#define POWER_MODEL_EVENTS_PER_HOUR 60  // Touch edges assumed by the boot estimate
+
+// Touch capture configuration
+#define TOUCH_DEBOUNCE_US 20000    // Minimum spacing between accepted edges (20 ms)
+#define TOUCH_EVENT_QUEUE_SIZE 16  // Edges buffered between ISR and loop() (power of two)
+
+// Sensor ingest configuration
+#define MAX_TRACKED_SENSORS 32 // Sender slots in the aggregator table
+#define INGEST_QUEUE_SIZE 64   // Pending samples between handlers and consumer (power of two)
+#define INGEST_BATCH_SIZE 16   // Samples applied per seqlock write section
+
+// Gateway mode: push changed table entries upstream over one TCP connection
+#define GATEWAY_ENABLED 0
+#define GATEWAY_HOST "192.168.1.10"
+#define GATEWAY_PORT 9100
+#define GATEWAY_INTERVAL 500           // ms between frames
+#define GATEWAY_BATTERY_DELTA 0.5f     // Battery percent change that counts as changed
+#define GATEWAY_FULL_REFRESH 10000     // ms between full frames
+#define GATEWAY_RECONNECT_INTERVAL 2000
+
+// UDP multicast of the sensor table for LAN listeners
+#define MULTICAST_ENABLED 0
+#define MULTICAST_GROUP "239.255.42.1"
+#define MULTICAST_PORT 9101
+#define MULTICAST_INTERVAL 200         // ms between datagrams
+#define MULTICAST_BATTERY_DELTA 0.5f   // Battery percent change that counts as changed
+#define MULTICAST_FULL_REFRESH 2000    // ms between full frames, for late joiners and lost datagrams
+#define MULTICAST_TTL 1
+
+// Binary sensor table export over a dedicated UART (COBS frames with CRC)
+#define UART_EXPORT_ENABLED 0
+#define UART_EXPORT_BAUD 921600
+#define UART_EXPORT_TX_PIN 17          // Serial2 defaults; Serial keeps the log
+#define UART_EXPORT_RX_PIN 16
+#define UART_EXPORT_INTERVAL 20        // ms between frames
+#define UART_EXPORT_BATTERY_DELTA 0.1f // Battery percent change that counts as changed
+#define UART_EXPORT_FULL_REFRESH 1000  // ms between full frames, so a host can attach at any time
+
+// Slotted transmission (TDMA) for periodic client sends
+#define TDMA_ENABLED 1          // 0: aggregator hands out no slots, clients send unscheduled
+#define TDMA_SLOT_COUNT 16      // One per clientId (0-15)
+#define TDMA_SLOT_WIDTH 12      // ms; a frame is TDMA_SLOT_COUNT slots
+#define TDMA_GUARD_TIME 3       // ms left idle at the end of each slot for clock error
+#define TDMA_SLOT_LEASE 5000    // ms a slot stays reserved after its owner's last send
+
+// Per-sensor link and activity statistics (/sensorStats)
+#define STATS_GAP_FACTOR 3      // A live inter-arrival this many times the mean counts as a gap
+#define STATS_GAP_MIN_SAMPLES 8 // Inter-arrivals averaged before gaps are judged
+#define STATS_SLOPE_SPAN 60000  // ms of capture time between battery slope samples
+
+// Traffic capture for replay (tools/capture_replay.py)
+#define CAPTURE_ENABLED 0           // 1: /capture can record raw /sensor and /sensorBatch requests
+#define CAPTURE_FILE "/capture.bin"
+#define CAPTURE_MAX_BYTES 262144    // Recording stops growing at this size
+#define CAPTURE_BUFFER_SIZE 2048    // RAM block written to flash at once
+#define CAPTURE_REPLAY_HEADER 0     // 1: X-Replay-From overrides the sender IP (replay targets only, never in production)
+
+// Latency instrumentation
+#define LATENCY_BUCKETS 16        // Log2 histogram buckets, last one is >= 16 s
+#define CLOCK_SYNC_RTT_SLACK 20   // Extra ms over 2x best RTT before a sync sample is ignored
 
 #endif // CONFIG_H
\ No newline at end of file
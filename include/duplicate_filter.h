@@ -0,0 +1,39 @@
+#ifndef DUPLICATE_FILTER_H
+#define DUPLICATE_FILTER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Drops repeated uplink sequence numbers per sender, so a client that
+// retries or fails over after an ack was lost is applied once. Keeps a
+// sliding bitmap of the last DEDUP_WINDOW numbers. A number far below the
+// window is taken as a client reboot. Used from the server task only.
+class DuplicateFilter
+{
+private:
+    struct Sender
+    {
+        uint32_t ip;
+        uint32_t highestSeq;
+        uint64_t seen; // bit n: highestSeq - n was accepted
+        uint32_t lastUsed;
+    };
+
+    Sender senders[MAX_TRACKED_SENSORS];
+    uint32_t useCounter;
+    uint32_t duplicateCount;
+
+    Sender *find(uint32_t ip);
+
+public:
+    DuplicateFilter();
+
+    // Checked before queueing; record() only once the sample was accepted,
+    // so a 503 does not turn the client's retry into a "duplicate"
+    bool isDuplicate(uint32_t ip, uint32_t seq);
+    void record(uint32_t ip, uint32_t seq);
+
+    uint32_t getDuplicateCount() const { return duplicateCount; }
+};
+
+#endif // DUPLICATE_FILTER_H
@@ -0,0 +1,72 @@
+#ifndef FORM_PARSER_H
+#define FORM_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sensor_schema.h"
+
+// Bits set in SensorForm::fields for each key that was present
+#define FORM_FIELD_CLIENT_ID 0x01
+#define FORM_FIELD_CAPTURED_AT 0x10
+#define FORM_FIELD_SENT_AT 0x20
+#define FORM_FIELD_RTT 0x40
+#define FORM_FIELD_SEQ 0x80
+
+// Decoded /sensor body. Numbers are fixed-point so no float parsing is needed.
+// Channels left out of the body read as 0.
+struct SensorForm
+{
+    char clientId[SENSOR_CLIENT_ID_LEN];
+    int32_t channels[SENSOR_CHANNEL_COUNT]; // value * 10^decimals, see sensor_schema.h
+    uint32_t capturedAt;          // client millis() when the value was read
+    uint32_t sentAt;              // client millis() when the POST started
+    uint32_t rttMs;               // client-measured round trip of its previous POST
+    uint32_t seq;                 // per-client sequence number for duplicate suppression
+    uint8_t fields;
+};
+
+// /sensorBatch body: clientId, sentAt, rtt, seq and a samples list of
+// "capturedAt,<each channel in schema order>" entries separated by ';'
+struct SensorBatchForm
+{
+    char clientId[SENSOR_CLIENT_ID_LEN];
+    uint32_t sentAt;
+    uint32_t rttMs;
+    uint32_t seq;
+    uint8_t fields;
+    const char *samples; // points into the request body
+    size_t samplesLength;
+};
+
+struct BatchEntry
+{
+    uint32_t capturedAt;
+    int32_t channels[SENSOR_CHANNEL_COUNT];
+};
+
+enum class FormResult : uint8_t
+{
+    Ok,
+    Missing,
+    Invalid
+};
+
+// Single-pass application/x-www-form-urlencoded parsing straight from the
+// request buffer. Nothing is copied to the heap; malformed input is rejected
+// at the first bad byte.
+class FormParser
+{
+public:
+    static FormResult parseSensorForm(const char *body, size_t length, SensorForm &out);
+    static FormResult parseSensorBatch(const char *body, size_t length, SensorBatchForm &out);
+    // Returns Missing at the end of the list
+    static FormResult nextBatchEntry(const char *&cursor, const char *end, BatchEntry &out);
+    static FormResult findInt(const char *data, size_t length, const char *key, int32_t &out);
+
+    static bool parseInt(const char *text, size_t length, int32_t &out);
+    static bool parseUint32(const char *text, size_t length, uint32_t &out);
+    static bool parseFixed(const char *text, size_t length, uint8_t decimals, int32_t &out);
+    static bool decodeValue(const char *text, size_t length, char *out, size_t outSize);
+};
+
+#endif // FORM_PARSER_H
@@ -0,0 +1,55 @@
+#ifndef GATEWAY_UPLINK_H
+#define GATEWAY_UPLINK_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "sensor_frame.h"
+
+// Gateway mode: every GATEWAY_INTERVAL the changed table entries are packed
+// into one SensorFrame and pushed over a persistent TCP connection, each
+// frame prefixed with its u16 little-endian length. The socket is
+// non-blocking; if the upstream host falls behind, frames are skipped and
+// the next one is sent full.
+class GatewayUplink
+{
+private:
+    enum LinkState : uint8_t
+    {
+        LINK_DOWN,
+        LINK_CONNECTING,
+        LINK_UP
+    };
+
+    SensorFrameEncoder encoder;
+    int fd;
+    LinkState state;
+    uint32_t lastFrameAt;
+    uint32_t lastConnectAt;
+
+    uint8_t tx[2 + SENSOR_FRAME_MAX_SIZE];
+    size_t txLen;
+    size_t txOffset;
+
+    uint32_t framesSent;
+    uint32_t framesSkipped;
+    uint32_t bytesSent;
+    uint32_t connectCount;
+
+    void startConnect(uint32_t now);
+    void closeLink();
+    bool checkConnected();
+    bool flush();
+
+public:
+    GatewayUplink();
+
+    void poll(uint32_t now, const SensorManager &manager); // call from loop()
+
+    bool isConnected() const { return state == LINK_UP; }
+    uint32_t getFramesSent() const { return framesSent; }
+    uint32_t getFramesSkipped() const { return framesSkipped; }
+    uint32_t getBytesSent() const { return bytesSent; }
+    uint32_t getConnectCount() const { return connectCount; }
+};
+
+#endif // GATEWAY_UPLINK_H
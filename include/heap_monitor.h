@@ -0,0 +1,31 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+#include "response_arena.h"
+
+// Tracks heap fragmentation: total free bytes against the largest block a
+// single malloc can still get. Free memory can stay flat while the largest
+// block shrinks, so both are kept along with their lows since boot.
+// sample() runs as a scheduler job; the fields are read by the server task
+// and may be one sample apart.
+class HeapMonitor
+{
+private:
+    uint32_t freeBytes;
+    uint32_t largestBlock;
+    uint32_t minFree;
+    uint32_t minLargest;
+    uint16_t fragmentation;      // per mille of free memory not in the largest block
+    uint16_t worstFragmentation;
+    uint32_t samples;
+
+public:
+    HeapMonitor();
+
+    void sample();
+    void printStats() const;
+    void writeJSON(JsonWriter &json) const;
+};
+
+#endif // HEAP_MONITOR_H
@@ -0,0 +1,231 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <IPAddress.h>
+#include "config.h"
+
+enum class HttpMethod : uint8_t
+{
+    Get,
+    Post,
+    Any
+};
+
+// Same status names as the Arduino WebServer so upload handlers port unchanged
+enum HttpUploadStatus
+{
+    UPLOAD_FILE_START,
+    UPLOAD_FILE_WRITE,
+    UPLOAD_FILE_END,
+    UPLOAD_FILE_ABORTED
+};
+
+struct HttpUpload
+{
+    HttpUploadStatus status;
+    String filename;
+    size_t totalSize;   // bytes received so far for this file
+    size_t currentSize; // bytes valid in buf for this callback
+    uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+#define HTTP_NO_ROUTE -1
+#define HTTP_CHUNKED ((size_t)-1) // response length not known up front
+
+// FNV-1a over the method and path, usable in case labels. A router can
+// switch on it, so duplicate keys fail to compile, and one memcmp then
+// confirms the match.
+constexpr uint32_t httpRouteKey(const char *path, uint32_t hash)
+{
+    return *path ? httpRouteKey(path + 1, (hash ^ (uint8_t)*path) * 16777619u) : hash;
+}
+
+constexpr uint32_t httpRouteKey(HttpMethod method, const char *path)
+{
+    return httpRouteKey(path, 2166136261u ^ (uint32_t)method);
+}
+
+inline uint32_t httpRouteKey(HttpMethod method, const char *path, size_t pathLen)
+{
+    uint32_t hash = 2166136261u ^ (uint32_t)method;
+    for (size_t i = 0; i < pathLen; i++)
+        hash = (hash ^ (uint8_t)path[i]) * 16777619u;
+    return hash;
+}
+
+// Response body produced piece by piece as the socket drains, for bodies
+// that are too large to build up front. The server asks for the next piece
+// only when the previous one has gone out, so memory stays at one chunk.
+class HttpBodySource
+{
+public:
+    virtual ~HttpBodySource() {}
+
+    // Fills up to capacity bytes; 0 ends the body
+    virtual size_t read(char *buf, size_t capacity) = 0;
+    // Checked when read() returns 0: true if the body could not be
+    // completed. The connection is then closed without the final chunk,
+    // so the client sees a broken transfer rather than a short body.
+    virtual bool failed() const { return false; }
+    // Called once, when the body ended or the connection closed
+    virtual void end() {}
+};
+
+// Route lookup and dispatch, implemented by the application. Routes are
+// small integers chosen by the router; the server only stores them.
+class HttpRouter
+{
+public:
+    virtual ~HttpRouter() {}
+
+    // Returns the route for this request, or HTTP_NO_ROUTE
+    virtual int match(HttpMethod method, const char *path, size_t pathLen) const = 0;
+    virtual bool acceptsUpload(int route) const = 0;
+    virtual void handle(int route) = 0; // HTTP_NO_ROUTE: not found
+    virtual void handleUpload(int route) = 0;
+};
+
+// Event-driven HTTP/1.1 server. A single task multiplexes every open socket
+// with select(): requests are parsed incrementally, responses are queued in
+// per-connection send buffers, and files are streamed as sockets drain, so a
+// slow download never stalls other clients. Connections are kept alive.
+//
+// Handlers run on the server task and use the WebServer-style accessors
+// below, which always refer to the request currently being dispatched.
+class AsyncHttpServer
+{
+private:
+    enum ConnState : uint8_t
+    {
+        CONN_FREE,
+        CONN_READ_HEADERS,
+        CONN_READ_BODY,
+        CONN_READ_UPLOAD,
+        CONN_SENDING
+    };
+
+    enum UploadState : uint8_t
+    {
+        UPLOAD_SEEK_BOUNDARY,
+        UPLOAD_AFTER_BOUNDARY,
+        UPLOAD_PART_HEADERS,
+        UPLOAD_PART_DATA,
+        UPLOAD_DONE
+    };
+
+    enum FlushResult : uint8_t
+    {
+        FLUSH_DONE,
+        FLUSH_PENDING,
+        FLUSH_ERROR
+    };
+
+    struct Connection
+    {
+        int fd;
+        ConnState state;
+        IPAddress remoteIP;
+        unsigned long lastActivity;
+
+        // Receive side: request line + headers + form body must fit
+        char rx[HTTP_RX_BUFFER_SIZE];
+        size_t rxLen;
+        size_t headerLen; // bytes up to and including the blank line
+        size_t contentLength;
+        size_t bodyReceived;
+
+        // Parsed request line, pointing into rx
+        HttpMethod method;
+        const char *path;
+        size_t pathLen;
+        const char *query;
+        size_t queryLen;
+        bool keepAlive;
+        bool http11; // chunked responses allowed
+        bool isMultipart;
+        int route; // from the router, HTTP_NO_ROUTE if none
+
+        // Multipart upload parsing
+        UploadState uploadState;
+        char boundary[72]; // "\r\n--" + boundary token
+        size_t boundaryLen;
+        bool fileOpen;
+
+        // Send side
+        String tx;
+        size_t txOffset;
+        File file;
+        bool streaming;
+        HttpBodySource *source; // chunked body still being produced
+        bool responded;
+    };
+
+    uint16_t port;
+    int listenFd;
+    HttpRouter *router;
+    Connection connections[HTTP_MAX_CONNECTIONS];
+    Connection *current;
+    String currentUri;
+    String extraHeaders;
+    HttpUpload uploadData;
+    Connection *uploadOwner; // only one multipart upload at a time
+
+    static void taskEntry(void *arg);
+    void run();
+    void acceptConnections();
+    void resetRequest(Connection &conn);
+    void closeConnection(Connection &conn);
+    void receive(Connection &conn);
+    void pump(Connection &conn);
+    bool processInput(Connection &conn);
+    bool parseHeaders(Connection &conn);
+    bool processUpload(Connection &conn);
+    void deliverUploadData(Connection &conn, const char *data, size_t len);
+    void consumeBody(Connection &conn, size_t len);
+    void finishRequest(Connection &conn);
+    void bindRequest(Connection &conn);
+    void sendError(Connection &conn, int code, const char *message);
+    FlushResult flush(Connection &conn);
+    void readChunk(Connection &conn);
+    void endSource(Connection &conn);
+    void startResponse(Connection &conn, int code, const char *contentType, size_t contentLength);
+    bool findArg(const char *data, size_t len, const char *name, String *value) const;
+
+public:
+    explicit AsyncHttpServer(uint16_t port);
+
+    void begin(); // Open the listening socket and start the server task
+
+    void setRouter(HttpRouter *router);
+
+    // Request accessors - valid inside a handler
+    const String &uri() const { return currentUri; }
+    HttpMethod method() const;
+    IPAddress remoteIP() const;
+    bool hasArg(const char *name) const;
+    String arg(const char *name) const;
+    String header(const char *name) const;
+    bool findHeader(const char *name, const char *&value, size_t &valueLen) const; // points into the request
+    const char *body() const;  // raw request body, not NUL-terminated
+    size_t bodyLength() const; // 0 for multipart uploads
+    const char *query() const; // raw query string, not NUL-terminated
+    size_t queryLength() const;
+    HttpUpload &upload() { return uploadData; }
+
+    // Response - the first response per request wins
+    bool responded() const { return current && current->responded; }
+    void sendHeader(const char *name, const char *value);
+    void sendHeader(const char *name, const String &value) { sendHeader(name, value.c_str()); }
+    void send(int code, const char *contentType, const String &content);
+    void send(int code, const char *contentType, const char *content, size_t length);
+    size_t streamFile(File &file, const char *contentType); // takes ownership of file
+    // Chunked transfer encoding (HTTP/1.0: body until close). The server calls
+    // source->end() when done; until then the source must stay valid.
+    bool sendChunked(int code, const char *contentType, HttpBodySource *source);
+
+    static const char *statusText(int code);
+};
+
+#endif // HTTP_SERVER_H
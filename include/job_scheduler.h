@@ -0,0 +1,76 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define SCHED_WHEEL_BITS 6
+#define SCHED_WHEEL_SIZE (1 << SCHED_WHEEL_BITS)
+#define SCHED_WHEEL_LEVELS 3 // 1 ms, 64 ms and 4.096 s slots; longer waits are re-cascaded
+
+typedef void (*SchedulerJob)(uint32_t now);
+
+enum class JobMode : uint8_t
+{
+    FixedRate, // deadlines stay on the period grid; skipped periods count as misses
+    FixedDelay // next deadline is one period after the run finished
+};
+
+// Cooperative scheduler for loop(): jobs sit in a hierarchical timer wheel
+// keyed by deadline in ms, so a tick only touches the jobs due in it, and
+// the loop task sleeps until the next deadline in between. A touch edge
+// notifies the task and ends the sleep early. Tracks per-job lateness and
+// misses and the share of time spent idle. Loop task only.
+class JobScheduler
+{
+private:
+    struct Job
+    {
+        SchedulerJob run;
+        const char *name;
+        uint32_t periodMs;
+        uint32_t deadline;
+        uint32_t nextDelay; // set by runNextIn() during the run
+        JobMode mode;
+        int8_t next;        // next job in the same wheel slot
+        bool overridden;
+
+        // Since the last resetStats()
+        uint32_t runs;
+        uint32_t misses;
+        uint32_t totalLateMs;
+        uint32_t maxLateMs;
+        uint32_t maxRunUs;
+    };
+
+    Job jobs[SCHED_MAX_JOBS];
+    uint8_t jobCount;
+    int8_t wheel[SCHED_WHEEL_LEVELS][SCHED_WHEEL_SIZE];
+    uint32_t wheelTime; // next tick to process
+
+    uint32_t windowStartUs;
+    uint32_t idleUs;
+
+    void insert(int id);
+    void cascade(int level, uint32_t tick);
+    void runSlot(uint32_t tick, uint32_t now);
+
+public:
+    JobScheduler();
+
+    // Returns the job id, or -1 when SCHED_MAX_JOBS are registered
+    int add(const char *name, SchedulerJob job, uint32_t periodMs, JobMode mode, uint32_t firstDelayMs = 0);
+    // From inside a job: run it next after delayMs instead of its period
+    void runNextIn(int id, uint32_t delayMs);
+
+    void run(uint32_t now); // runs every job due by now
+    uint32_t msUntilNext(uint32_t now) const;
+    void idle(uint32_t now);           // sleeps until the next deadline or a task notification
+    void recordIdle(uint32_t idleTimeUs); // sleep taken elsewhere, e.g. PowerManager::idle
+
+    float getIdlePercent() const;
+    void printStats() const;
+    void resetStats();
+};
+
+#endif // JOB_SCHEDULER_H
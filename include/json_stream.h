@@ -0,0 +1,112 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include "http_server.h"
+#include "response_arena.h"
+#include "sensor_manager.h"
+
+// A JSON array or object sent with chunked encoding, one item at a time.
+// Each read() packs as many whole items as fit in the chunk, so memory is
+// one chunk regardless of how many items there are. Streams live in small
+// fixed pools; active marks one as taken until the server calls end().
+class JsonStream : public HttpBodySource
+{
+private:
+    enum Stage : uint8_t
+    {
+        STAGE_OPEN,
+        STAGE_ITEMS,
+        STAGE_CLOSE,
+        STAGE_DONE,
+        STAGE_FAILED // an item did not fit a whole chunk
+    };
+
+    Stage stage;
+    char opening;
+    char closing;
+    bool hasItems;
+
+protected:
+    void start(char opening, char closing);
+
+    // Writes the current item; false once there are none left
+    virtual bool writeItem(JsonWriter &json) = 0;
+    virtual void nextItem() = 0;
+    virtual void release() {}
+
+public:
+    bool active;
+
+    JsonStream() : stage(STAGE_DONE), opening(0), closing(0), hasItems(false), active(false) {}
+
+    size_t read(char *buf, size_t capacity) override;
+    bool failed() const override { return stage == STAGE_FAILED; }
+    void end() override;
+};
+
+// /list: SPIFFS entries as [{"name":...,"size":...}], walked while sending
+class FileListStream : public JsonStream
+{
+private:
+    File root;
+    File file;
+    uint32_t remaining;
+
+protected:
+    bool writeItem(JsonWriter &json) override;
+    void nextItem() override;
+    void release() override;
+
+public:
+    bool begin(uint32_t offset, uint32_t limit); // limit 0: all
+};
+
+// /sensorData, /sensorStats or /latency for tables too large for the
+// response arena
+class SensorTableStream : public JsonStream
+{
+private:
+    enum Content : uint8_t
+    {
+        CONTENT_VALUES,
+        CONTENT_STATS,
+        CONTENT_LATENCY
+    };
+
+    SensorTable snapshot;
+    union // taken with snapshot
+    {
+        SensorStats stats[MAX_TRACKED_SENSORS];
+        SensorLatency latency[MAX_TRACKED_SENSORS];
+    };
+    Content content;
+    uint8_t index;
+
+protected:
+    bool writeItem(JsonWriter &json) override;
+    void nextItem() override { index++; }
+
+public:
+    void begin(const SensorTable &table);
+    void beginStats(const SensorTable &table, const SensorManager &from);
+    void beginLatency(const SensorTable &table, const SensorManager &from); // server task only
+};
+
+// Takes a free stream from a pool, or nullptr when all are sending
+template <typename T, size_t N>
+T *claimStream(T (&pool)[N])
+{
+    for (T &stream : pool)
+    {
+        if (!stream.active)
+        {
+            stream.active = true;
+            return &stream;
+        }
+    }
+    return nullptr;
+}
+
+#endif // JSON_STREAM_H
@@ -0,0 +1,87 @@
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "lockfree_queue.h"
+
+struct SensorSample;
+struct SensorTable;
+class JsonWriter;
+
+// Log2 buckets: bucket 0 holds 0 ms, bucket i holds [2^(i-1), 2^i) ms and
+// the last bucket everything above
+struct LatencyHistogram
+{
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t maxMs;
+    uint64_t sumMs;
+
+    void record(uint32_t ms);
+    uint32_t percentile(uint8_t pct) const; // upper bound of the bucket holding pct
+};
+
+// NTP-style offset of a client clock relative to ours. Each sample gives
+// offset = receivedAt - sentAt - rtt/2 using the round trip the client
+// measured on its previous POST; samples with a round trip far above the
+// best seen recently are ignored, the rest are smoothed.
+struct ClockSync
+{
+    int32_t offsetMs; // add to a client timestamp to get our millis()
+    uint16_t bestRttMs;
+    uint16_t samples;
+
+    void update(uint32_t receivedAt, uint32_t sentAt, uint32_t rttMs);
+};
+
+// What the ingest consumer keeps per sender
+struct IngestLatency
+{
+    ClockSync clock;
+    LatencyHistogram captureToIngest;
+    uint32_t generation; // bumped by resetSlot()
+};
+
+// One sender's figures, copied out for a response
+struct SensorLatency
+{
+    ClockSync clock;
+    LatencyHistogram captureToIngest;
+    LatencyHistogram ingestToPush;
+};
+
+// Per-sender latency instrumentation. Capture->ingest is recorded by the
+// ingest consumer and published per slot through a seqlock, so the server
+// task on the other core copies a consistent offset and histogram.
+// Ingest->push belongs to the server task, which records it when
+// /sensorData is served. A slot handed to a new sender bumps its
+// generation, and the server task clears its side of that slot when it
+// sees the change.
+class LatencyTracker
+{
+private:
+    Seqlock<IngestLatency> ingest[MAX_TRACKED_SENSORS];
+
+    // Server task only
+    LatencyHistogram ingestToPush[MAX_TRACKED_SENSORS];
+    uint32_t lastPushedIngest[MAX_TRACKED_SENSORS];
+    uint32_t pushGeneration[MAX_TRACKED_SENSORS]; // generation ingestToPush belongs to
+
+    static void writeHistogram(JsonWriter &json, const LatencyHistogram &histogram);
+
+public:
+    LatencyTracker();
+
+    // Ingest consumer side
+    void resetSlot(int slot);
+    void recordIngest(int slot, const SensorSample &sample, uint32_t ingestedAt);
+    uint32_t toLocalTime(int slot, const SensorSample &sample) const; // capture time on our clock
+
+    // Server task side
+    void recordPush(const SensorTable &snapshot, uint32_t now);
+    SensorLatency get(int slot) const;
+    static void writeJSON(JsonWriter &json, const SensorLatency &l); // the members of one sender's object
+};
+
+#endif // LATENCY_TRACKER_H
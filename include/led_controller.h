@@ -3,23 +3,70 @@
 
 #include <Adafruit_NeoPixel.h>
 
+// One point of a pattern: brightness level (0-255) of the pattern's color
+// from atMs until the next keyframe
+struct LedKeyframe
+{
+    uint16_t atMs;
+    uint8_t level;
+};
+
+struct LedPattern
+{
+    const LedKeyframe *frames;
+    uint8_t count;
+    uint16_t periodMs;
+    bool smooth;  // interpolate between keyframes instead of stepping
+    bool looping; // false: plays once, then the base pattern shows again
+};
+
+// Non-blocking LED animation. Indicators pick a pattern and return at once;
+// update(), run as a scheduler job every LED_FRAME_INTERVAL, works out the
+// color for the current time and writes the strip only when that color
+// differs from what it last wrote. A one-shot overlay (the touch flash)
+// blends over the base pattern until it finishes.
 class LEDController
 {
 private:
+    struct Animation
+    {
+        const LedPattern *pattern;
+        uint8_t red;
+        uint8_t green;
+        uint8_t blue;
+        uint32_t startedAt;
+    };
+
     Adafruit_NeoPixel pixel;
-    int currentRed;
-    int currentGreen;
-    int currentBlue;
+    Animation base;
+    Animation overlay;
+    bool overlayActive;
+    uint32_t shownColor;
+    bool shown; // shownColor is on the strip
+
+    uint32_t framesWritten;
+    uint32_t framesUnchanged;
+
+    void start(Animation &animation, const LedPattern &pattern, int red, int green, int blue);
+    void setBase(const LedPattern &pattern, int red, int green, int blue);
+    static int levelAt(const LedPattern &pattern, uint32_t elapsed); // -1 once a one-shot ended
 
 public:
     LEDController();
     void init();
+    void update(uint32_t now);
+
     void setColor(int red, int green, int blue);
     void setConnectingIndicator();
     void setConnectedIndicator();
     void setDisconnectedIndicator();
+    void setRetryIndicator();
     void setSensorIndicator(int sensorValue);
+    void flashTouch();
     void getCurrentColor(int &red, int &green, int &blue);
+
+    uint32_t getFramesWritten() const { return framesWritten; }
+    uint32_t getFramesUnchanged() const { return framesUnchanged; }
 };
 
-#endif // LED_CONTROLLER_H
\ No newline at end of file
+#endif // LED_CONTROLLER_H
@@ -0,0 +1,152 @@
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Bounded lock-free multi-producer / single-consumer ring.
+// Each cell carries a sequence number so producers on either core (or an ISR)
+// can claim slots with a single CAS and never block the consumer.
+template <typename T, size_t Capacity>
+class MpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Queue items must be trivially copyable");
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    Cell cells[Capacity];
+    std::atomic<size_t> head; // next slot to claim (producers)
+    std::atomic<size_t> tail; // next slot to consume; only the consumer stores it
+
+public:
+    MpscQueue() : head(0), tail(0)
+    {
+        for (size_t i = 0; i < Capacity; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Safe from any task or core. Returns false when the ring is full.
+    bool push(const T &item)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & (Capacity - 1)];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.item = item;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Single consumer only.
+    bool pop(T &item)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Cell &cell = cells[pos & (Capacity - 1)];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+            return false; // empty (or producer still writing)
+
+        item = cell.item;
+        cell.sequence.store(pos + Capacity, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Approximate fill level, for diagnostics and backpressure decisions.
+    // Safe from any task; the two counters are read without a common snapshot.
+    size_t size() const
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_relaxed);
+        return h >= t ? h - t : 0;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+};
+
+// Single-writer sequence lock. The writer updates the value in place between
+// beginWrite()/endWrite(); readers copy it out and retry if a write overlapped.
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock value must be trivially copyable");
+
+private:
+    std::atomic<uint32_t> sequence;
+    T value;
+
+public:
+    Seqlock() : sequence(0), value() {}
+
+    // Writer side - only the owning task may call these.
+    T &beginWrite()
+    {
+        sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return value;
+    }
+
+    void endWrite()
+    {
+        sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    // The writer can always read its own value without retrying.
+    const T &writerView() const { return value; }
+
+    // Reader side - safe from any task or core.
+    void read(T &out) const
+    {
+        readBytes(&out, &value, sizeof(T));
+    }
+
+    // Copies out a single member, for readers that need one field
+    template <typename M>
+    M read(M T::*member) const
+    {
+        M out;
+        readBytes(&out, &(value.*member), sizeof(M));
+        return out;
+    }
+
+private:
+    void readBytes(void *out, const void *from, size_t length) const
+    {
+        uint32_t before, after;
+        do
+        {
+            before = sequence.load(std::memory_order_acquire);
+            memcpy(out, from, length);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+    }
+};
+
+#endif // LOCKFREE_QUEUE_H
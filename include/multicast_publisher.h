@@ -0,0 +1,34 @@
+#ifndef MULTICAST_PUBLISHER_H
+#define MULTICAST_PUBLISHER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "sensor_frame.h"
+
+// Publishes the sensor table as SensorFrame datagrams to a UDP multicast
+// group at a fixed rate, so any number of LAN listeners cost the device one
+// send per tick. Deltas go out every MULTICAST_INTERVAL; a full frame every
+// MULTICAST_FULL_REFRESH lets new listeners (and ones that lost a datagram)
+// resync.
+class MulticastPublisher
+{
+private:
+    SensorFrameEncoder encoder;
+    int fd;
+    uint32_t lastPublishAt;
+    uint8_t frame[SENSOR_FRAME_MAX_SIZE];
+
+    uint32_t datagramsSent;
+    uint32_t sendErrors;
+
+public:
+    MulticastPublisher();
+
+    bool begin();
+    void poll(uint32_t now, const SensorManager &manager); // call from loop()
+
+    uint32_t getDatagramsSent() const { return datagramsSent; }
+    uint32_t getSendErrors() const { return sendErrors; }
+};
+
+#endif // MULTICAST_PUBLISHER_H
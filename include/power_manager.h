@@ -0,0 +1,77 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+enum class PowerMode : uint8_t
+{
+    AlwaysOn = POWER_MODE_ALWAYS_ON,
+    ModemSleep = POWER_MODE_MODEM_SLEEP,
+    LightSleep = POWER_MODE_LIGHT_SLEEP
+};
+
+// Send policy for battery clients: report when the state changes or the
+// heartbeat expires, and idle otherwise. Pure logic on caller-supplied
+// timestamps, so it can be stepped through a host simulation as is.
+class DutyCycle
+{
+private:
+    uint32_t heartbeatMs;
+    uint32_t lastSendAt;
+    int lastTouch;
+    float lastBatteryPercent;
+    bool haveSent;
+
+public:
+    explicit DutyCycle(uint32_t heartbeatMs);
+
+    bool isSendDue(uint32_t now, int touchValue, float batteryPercent) const;
+    void onSent(uint32_t now, int touchValue, float batteryPercent);
+    uint32_t idleBudget(uint32_t now) const; // ms until the heartbeat is due
+};
+
+// Puts the radio (and with LightSleep the CPU) to sleep between sends while
+// keeping the association, and wakes on the touch interrupt or the
+// heartbeat. Also keeps a running charge estimate from the current model.
+class PowerManager
+{
+private:
+    PowerMode mode;
+    DutyCycle cycle;
+    TaskHandle_t loopTask;
+    uint8_t wakePin;
+    bool lightSleepActive; // false if the build lacks power management
+
+    // Accounting for the current model
+    uint32_t lastAccountAt;
+    uint64_t awakeMs;
+    uint64_t idleMs;
+    uint32_t sendCount;
+
+    void account(uint32_t now, bool idle);
+
+public:
+    explicit PowerManager(PowerMode mode);
+
+    void begin(uint8_t touchPin); // call from setup() on the loop task
+    bool isLowPower() const { return mode != PowerMode::AlwaysOn; }
+    TaskHandle_t getLoopTask() const { return loopTask; }
+
+    bool isSendDue(uint32_t now, int touchValue, float batteryPercent) const;
+    void onSent(uint32_t now, int touchValue, float batteryPercent);
+
+    // Sleeps until the heartbeat (or holdMs, if the caller cannot send before
+    // then anyway), or until a touch edge notifies the loop task. Never
+    // longer than limitMs, the time until other work is due.
+    void idle(uint32_t now, uint32_t holdMs, uint32_t limitMs);
+
+    float getConsumedMah() const;
+    const char *getModeName() const { return modeName(mode); }
+
+    static const char *modeName(PowerMode mode);
+    // Average draw for a mode, heartbeat and touch rate, from the config figures
+    static float estimateAverageMa(PowerMode mode, uint32_t heartbeatMs, uint32_t eventsPerHour);
+};
+
+#endif // POWER_MANAGER_H
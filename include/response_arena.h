@@ -0,0 +1,92 @@
+#ifndef RESPONSE_ARENA_H
+#define RESPONSE_ARENA_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Bump allocator for building one HTTP response. Handlers take their scratch
+// strings from here instead of the heap, and the router resets it once the
+// handler returns (send() has copied the body by then), so request traffic
+// never leaves holes in the heap. Used from the server task only.
+class ResponseArena
+{
+private:
+    alignas(4) char storage[HTTP_ARENA_SIZE];
+    size_t used;
+    size_t highWater;
+    uint32_t overflows;
+    bool writerOpen;
+
+    friend class JsonWriter;
+    char *open(size_t &capacity); // rest of the arena, for one writer at a time
+    void close(size_t length, bool overflowed);
+
+public:
+    ResponseArena();
+
+    void *alloc(size_t size);                     // nullptr when the arena is full
+    const char *format(const char *format, ...); // "" when it does not fit
+    void reset();
+
+    size_t getUsed() const { return used; }
+    size_t getHighWater() const { return highWater; }
+    uint32_t getOverflows() const { return overflows; }
+};
+
+// Appends JSON into a response arena, or into a caller's buffer. Commas and
+// quoting are handled here, so handlers only name keys and values. Output
+// that does not fit marks the writer as overflowed; callers check ok()
+// before sending.
+class JsonWriter
+{
+private:
+    ResponseArena *arena; // nullptr when writing into a caller's buffer
+    char *buf;
+    size_t capacity;
+    size_t len;
+    bool overflowed;
+    bool attached; // holds the arena open
+    bool afterKey;
+    uint8_t depth;
+    uint32_t hasItems; // bit per nesting level
+
+    void put(char c);
+    void put(const char *text, size_t length);
+    void separate();
+    void open(char bracket);
+    void close(char bracket);
+
+public:
+    explicit JsonWriter(ResponseArena &arena);
+    JsonWriter(char *buffer, size_t capacity);
+    ~JsonWriter();
+
+    JsonWriter &beginObject() { open('{'); return *this; }
+    JsonWriter &beginObject(size_t) { return beginObject(); } // counted, like BinaryWriter
+    JsonWriter &endObject() { close('}'); return *this; }
+    JsonWriter &beginArray() { open('['); return *this; }
+    JsonWriter &endArray() { close(']'); return *this; }
+    JsonWriter &key(const char *name);
+
+    JsonWriter &value(const char *text); // escaped
+    // One overload per integer type, whichever of them uint32_t and size_t are
+    JsonWriter &value(long number);
+    JsonWriter &value(unsigned long number);
+    JsonWriter &value(int number) { return value((long)number); }
+    JsonWriter &value(unsigned number) { return value((unsigned long)number); }
+    JsonWriter &value(float number, int decimals);
+    JsonWriter &value(bool flag);
+    JsonWriter &fixed(int32_t scaled, uint8_t decimals); // scaled / 10^decimals, no float rounding
+    JsonWriter &ip(uint32_t address);    // dotted quad string
+    JsonWriter &ipKey(uint32_t address); // dotted quad as a key
+    JsonWriter &raw(const char *json, size_t length);
+
+    template <typename T>
+    JsonWriter &field(const char *name, T v) { return key(name).value(v); }
+
+    bool ok() const { return !overflowed; }
+    const char *c_str() const { return buf; }
+    size_t length() const { return len; }
+};
+
+#endif // RESPONSE_ARENA_H
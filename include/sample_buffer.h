@@ -0,0 +1,45 @@
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "sensor_schema.h"
+
+// Compact local reading kept while the uplink is down
+struct BufferedSample
+{
+    uint32_t capturedAt;                    // millis() when read
+    int32_t channels[SENSOR_CHANNEL_COUNT]; // fixed-point, full width: batteryVoltage mV exceeds int16
+};
+
+// Bounded store-and-forward buffer. Samples live in a RAM ring; when it
+// fills, the oldest half is appended to a SPIFFS spill file. Replay is
+// oldest first: the spill file, then RAM.
+class SampleBuffer
+{
+private:
+    BufferedSample ring[OFFLINE_RAM_SAMPLES];
+    size_t head;  // oldest sample in the ring
+    size_t count; // samples in the ring
+    size_t spilledBytes;
+    size_t replayOffset; // bytes of the spill file already replayed
+    uint32_t droppedCount;
+
+    void spillOldest(size_t n);
+
+public:
+    SampleBuffer();
+
+    void begin(); // discards a spill file left by a previous boot (its timestamps are meaningless now)
+    void add(const BufferedSample &sample);
+
+    // Copies up to max of the oldest samples; commit() removes them once delivered
+    size_t peek(BufferedSample *out, size_t max);
+    void commit(size_t n);
+
+    bool isEmpty() const { return count == 0 && replayOffset >= spilledBytes; }
+    size_t size() const { return count + (spilledBytes - replayOffset) / sizeof(BufferedSample); }
+    uint32_t getDroppedCount() const { return droppedCount; }
+};
+
+#endif // SAMPLE_BUFFER_H
@@ -0,0 +1,37 @@
+#ifndef SEND_RATE_CONTROLLER_H
+#define SEND_RATE_CONTROLLER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// AIMD pacing for the periodic uplink. Healthy replies shave a fixed step
+// off the send interval; timeouts, 429 and 5xx replies, slow replies or an
+// aggregator backpressure hint double it. Other 4xx replies leave it alone. A weak RSSI raises the floor. Touch edges
+// bypass the controller and are always sent at once.
+class SendRateController
+{
+private:
+    uint32_t minIntervalMs;
+    uint32_t intervalMs;
+    uint32_t smoothedRttMs;
+    int8_t lastRssi;
+    int lastBackpressure;
+    uint32_t backoffCount;
+
+    uint32_t floorInterval() const;
+
+public:
+    explicit SendRateController(uint32_t minInterval);
+
+    bool isDue(uint32_t now, uint32_t lastSend) const { return now - lastSend >= intervalMs; }
+    void onResult(int httpCode, uint32_t rttMs, int8_t rssi, int backpressure);
+
+    uint32_t getInterval() const { return intervalMs; }
+    uint32_t getSmoothedRtt() const { return smoothedRttMs; }
+    uint32_t getBackoffCount() const { return backoffCount; }
+
+    // Reads the "bp=" hint from an aggregator reply, -1 if absent
+    static int parseBackpressure(const String &reply);
+};
+
+#endif // SEND_RATE_CONTROLLER_H
@@ -0,0 +1,51 @@
+#ifndef SENSOR_FRAME_H
+#define SENSOR_FRAME_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "sensor_manager.h"
+
+// Binary table export shared by the upstream gateway, multicast and UART
+// streams. Little-endian, fixed-point, no padding:
+//
+//   header: magic u16 "SF" | version u8 | flags u8 | seq u32 | millis u32 | count u8
+//   entry:  ip u32 | one 16-bit value per channel, schema order |
+//           age ms u16 (since ingest, saturating) | id length u8 | id bytes
+//
+// Version 1 channels: touch i16 | battery mV u16 | battery % x10 u16
+#define SENSOR_FRAME_MAGIC 0x4653 // "SF" on the wire
+#define SENSOR_FRAME_VERSION 1
+#define SENSOR_FRAME_FULL 0x01 // all entries; receivers replace their table
+#define SENSOR_FRAME_HEADER_SIZE 13
+#define SENSOR_FRAME_ENTRY_MAX (7 + 2 * SENSOR_CHANNEL_COUNT + SENSOR_CLIENT_ID_LEN)
+#define SENSOR_FRAME_MAX_SIZE (SENSOR_FRAME_HEADER_SIZE + MAX_TRACKED_SENSORS * SENSOR_FRAME_ENTRY_MAX)
+
+// Builds frames holding only the entries that changed since they were last
+// sent. A full frame goes out first, whenever a sender disappears, and every
+// fullRefreshMs so receivers that join late catch up.
+class SensorFrameEncoder
+{
+private:
+    SensorTable lastSent; // what the receivers hold
+    uint32_t seq;
+    uint32_t lastFullAt;
+    bool forceFull;
+    int32_t changeThreshold[SENSOR_CHANNEL_COUNT];
+    uint32_t fullRefreshMs;
+
+    bool hasChanged(const SensorTable &table, int slot) const;
+    void remember(const SensorTable &table, int slot, int into);
+    static size_t encodeEntry(const SensorTable &table, int slot, uint32_t now, uint8_t *out);
+
+public:
+    // batteryDelta (percent) overrides the schema threshold of BatteryPercent
+    SensorFrameEncoder(float batteryDelta, uint32_t fullRefreshMs);
+
+    void requestFull() { forceFull = true; } // e.g. after a reconnect
+
+    // Returns the frame length, or 0 when nothing changed
+    size_t encode(const SensorTable &table, uint32_t now, uint8_t *out);
+    uint32_t getSequence() const { return seq; }
+};
+
+#endif // SENSOR_FRAME_H
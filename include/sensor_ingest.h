@@ -0,0 +1,59 @@
+#ifndef SENSOR_INGEST_H
+#define SENSOR_INGEST_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"
+#include "lockfree_queue.h"
+#include "sensor_manager.h"
+
+// Bits in SensorSample::timing for the optional client timestamps
+#define SAMPLE_TIMING_SENT_AT 0x01
+#define SAMPLE_TIMING_CAPTURED_AT 0x02
+#define SAMPLE_TIMING_RTT 0x04
+#define SAMPLE_TIMING_REPLAY 0x08 // buffered while offline, may arrive out of order
+#define SAMPLE_TIMING_SEQ 0x10    // seq is set (on the first sample of a batch only)
+
+// One decoded /sensor POST, as handed from the network side to the consumer
+struct SensorSample
+{
+    uint32_t ip;
+    char clientId[SENSOR_CLIENT_ID_LEN];
+    int32_t channels[SENSOR_CHANNEL_COUNT]; // fixed-point, see sensor_schema.h
+
+    // Timing: receivedAt is our millis(); the rest are on the client clock
+    uint32_t receivedAt;
+    uint32_t capturedAt;
+    uint32_t sentAt;
+    uint32_t rttMs; // round trip of the client's previous POST
+    uint32_t seq;   // client's request sequence number
+    uint8_t timing;
+};
+
+// Decouples request handling from SensorManager: any number of producers
+// (HTTP handlers, on either core) push samples, and a single consumer
+// applies them in batches.
+class SensorIngest
+{
+private:
+    MpscQueue<SensorSample, INGEST_QUEUE_SIZE> queue;
+    std::atomic<uint32_t> acceptedCount;
+    std::atomic<uint32_t> droppedCount;
+    uint32_t appliedCount; // consumer only
+
+public:
+    SensorIngest();
+
+    // Producer side - returns false if the queue is full and the sample was dropped
+    bool push(const SensorSample &sample);
+
+    // Consumer side - applies up to maxSamples queued samples, returns how many
+    size_t drain(SensorManager &manager, size_t maxSamples = INGEST_QUEUE_SIZE);
+
+    size_t pending() const { return queue.size(); }
+    uint32_t getAcceptedCount() const { return acceptedCount.load(std::memory_order_relaxed); }
+    uint32_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+    uint32_t getAppliedCount() const { return appliedCount; }
+};
+
+#endif // SENSOR_INGEST_H
@@ -1,37 +1,87 @@
 #ifndef SENSOR_MANAGER_H
 #define SENSOR_MANAGER_H
 
-#include <map>
-#include <string>
 #include <Arduino.h>
+#include "config.h"
+#include "lockfree_queue.h"
+#include "touch_events.h"
+#include "latency_tracker.h"
+#include "sensor_stats.h"
+#include "response_arena.h"
+#include "binary_writer.h"
+#include "sensor_schema.h"
 
-struct SensorData
+#define SENSOR_CHANNEL_KEY_MAX 14 // Longest channel key, so entry sizes can be bounded
+// Worst-case CBOR/MessagePack bytes for one table entry: ip key, map head,
+// clientId, then a key and a 5-byte number per channel
+#define SENSOR_BINARY_ENTRY_MAX (42 + SENSOR_CHANNEL_COUNT * (6 + SENSOR_CHANNEL_KEY_MAX))
+// /localSensorData: ip, the channels and SENSOR_LOCAL_FIELDS numbered fields
+// (clientId and the touch edge counters) with keys up to SENSOR_LOCAL_KEY_MAX
+#define SENSOR_LOCAL_FIELDS 4
+#define SENSOR_LOCAL_KEY_MAX 18
+#define SENSOR_BINARY_LOCAL_MAX \
+    (22 + SENSOR_LOCAL_FIELDS * (6 + SENSOR_LOCAL_KEY_MAX) + SENSOR_CHANNEL_COUNT * (6 + SENSOR_CHANNEL_KEY_MAX))
+
+struct SensorSample;
+
+// Fixed-size table so readers on another core can take a consistent copy.
+// Slots are assigned on first contact and stay stable until cleared. Stored
+// column by column, so a scan over one channel (every sender's touch state,
+// say) reads contiguous memory.
+struct SensorTable
 {
-    String clientId;
-    int touchValue;
-    float batteryVoltage;
-    float batteryPercent;
+    uint8_t count;
+    uint32_t ip[MAX_TRACKED_SENSORS];         // Sender IPv4 address, used as the key
+    uint32_t ingestedAt[MAX_TRACKED_SENSORS]; // millis() when the last sample was applied
+    uint32_t sampleTime[MAX_TRACKED_SENSORS]; // capture time of the shown value, on our clock
+    int32_t channels[SENSOR_CHANNEL_COUNT][MAX_TRACKED_SENSORS]; // fixed-point, see sensor_schema.h
+    char clientId[MAX_TRACKED_SENSORS][SENSOR_CLIENT_ID_LEN];
+
+    int find(uint32_t address) const; // slot index, or -1
 };
 
 class SensorManager
 {
 private:
-    std::map<String, SensorData> sensorDataMap;
+    Seqlock<SensorTable> table;
+    TouchEventCapture touchEvents;
+    LatencyTracker latency;
+    SensorStatsTracker stats;
+
+    int findOrAddSlot(SensorTable &t, uint32_t ip);
 
 public:
     void begin(); // Initialize sensor pins
-    void updateSensorData(const String &senderIP, const String &clientId, int touchValue, float batteryVoltage, float batteryPercent);
-    String getSensorDataJSON() const;
-    const std::map<String, SensorData> &getAllSensorData() const;
+
+    // Writer side - call only from the ingest consumer (the loop task)
+    void applySamples(const SensorSample *samples, size_t count);
     void clearSensorData();
+
+    // Reader side - safe from any task
+    void getSnapshot(SensorTable &out) const;
+    // Writer is JsonWriter or BinaryWriter; instantiated for both in the .cpp
+    template <typename Writer>
+    static void writeSensorTable(Writer &out, const SensorTable &snapshot);
+    template <typename Writer>
+    static void writeSensor(Writer &out, const SensorTable &snapshot, int slot); // one "ip":{...} member
+    void recordDashboardPush(const SensorTable &snapshot); // server task only
+    void writeStatsTable(JsonWriter &out, const SensorTable &snapshot) const;
+    void writeSensorStats(JsonWriter &out, const SensorTable &snapshot, int slot) const; // one "ip":{...} member
+    static void writeSensorStats(JsonWriter &out, const SensorTable &snapshot, const SensorStats &slotStats, int slot);
+    void getStatsSnapshot(SensorStats *out, int count) const; // slots 0..count-1
+    // Latency: server task only, like recordDashboardPush()
+    void writeLatencyTable(JsonWriter &out, const SensorTable &snapshot) const;
+    static void writeSensorLatency(JsonWriter &out, const SensorTable &snapshot, const SensorLatency &slotLatency, int slot);
+    void getLatencySnapshot(SensorLatency *out, int count) const; // slots 0..count-1
     bool hasSensorData() const;
-    String getFormattedSensorData() const;
-    String getFormattedSensorData(int minSensors) const;
     // Add for client mode:
     int getLocalTouchValue() const;
     float getLocalBatteryVoltage() const;
     float getLocalBatteryPercent() const;
-    String getLocalSensorDataJSON() const;
+    void readLocalChannels(int32_t (&out)[SENSOR_CHANNEL_COUNT]) const;
+    TouchEventCapture &getTouchEvents() { return touchEvents; }
+    template <typename Writer>
+    void writeLocalSensorData(Writer &out) const;
 };
 
-#endif // SENSOR_MANAGER_H
\ No newline at end of file
+#endif // SENSOR_MANAGER_H
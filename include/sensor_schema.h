@@ -0,0 +1,65 @@
+#ifndef SENSOR_SCHEMA_H
+#define SENSOR_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SENSOR_CLIENT_ID_LEN 16 // clientId as sent, terminator included
+
+// Channels every sender reports. Each row drives the client POST, /sensor
+// and /sensorBatch parsing, the aggregator table, JSON/CBOR/MessagePack
+// output and the binary frames, in this order:
+//
+//   CH(id, form and JSON key, decimals stored, frame change threshold)
+//
+// Values are fixed-point everywhere: value * 10^decimals in an int32_t.
+// The threshold (in stored units) is how far a value must move before the
+// frame encoders resend it; 0 never triggers a resend on its own. Frames
+// carry each channel as 16 bits, so a new row needs a SENSOR_FRAME_VERSION
+// bump and matching changes in tools/.
+#define SENSOR_CHANNELS(CH)                    \
+    CH(Touch, "touch", 0, 1)                   \
+    CH(BatteryVoltage, "batteryVoltage", 3, 0) \
+    CH(BatteryPercent, "batteryPercent", 1, 5)
+
+#define SENSOR_CHANNEL_ENUM(id, key, decimals, change) SENSOR_CHANNEL_##id,
+enum SensorChannel : uint8_t
+{
+    SENSOR_CHANNELS(SENSOR_CHANNEL_ENUM)
+    SENSOR_CHANNEL_COUNT
+};
+#undef SENSOR_CHANNEL_ENUM
+
+struct SensorChannelInfo
+{
+    const char *key;
+    uint8_t keyLen;
+    uint8_t decimals;
+    int32_t scale;  // 10^decimals
+    int32_t change; // frame resend threshold, stored units
+};
+
+constexpr int32_t sensorChannelScale(uint8_t decimals)
+{
+    return decimals == 0 ? 1 : 10 * sensorChannelScale(decimals - 1);
+}
+
+#define SENSOR_CHANNEL_INFO_ROW(id, key, decimals, change) \
+    {key, sizeof(key) - 1, decimals, sensorChannelScale(decimals), change},
+constexpr SensorChannelInfo SENSOR_CHANNEL_INFO[SENSOR_CHANNEL_COUNT] = {SENSOR_CHANNELS(SENSOR_CHANNEL_INFO_ROW)};
+#undef SENSOR_CHANNEL_INFO_ROW
+
+// Fixed-point conversions for code that still deals in floats (local ADC
+// readings, the power manager, Serial output)
+inline int32_t sensorChannelFromFloat(uint8_t channel, float value)
+{
+    float scaled = value * SENSOR_CHANNEL_INFO[channel].scale;
+    return (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+inline float sensorChannelToFloat(uint8_t channel, int32_t value)
+{
+    return (float)value / SENSOR_CHANNEL_INFO[channel].scale;
+}
+
+#endif // SENSOR_SCHEMA_H
@@ -0,0 +1,81 @@
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "lockfree_queue.h"
+#include "sensor_schema.h"
+
+struct SensorSample;
+class JsonWriter;
+
+// Welford's running mean and variance, O(1) per value
+struct RunningStats
+{
+    uint32_t count;
+    float mean;
+    float m2; // sum of squared differences from the mean
+
+    void add(float x);
+    float variance() const { return count > 1 ? m2 / (count - 1) : 0.0f; }
+};
+
+// Link and activity statistics for one sender. Arrivals use our clock;
+// touch and battery use the capture time of each applied value.
+struct SensorStats
+{
+    // Live arrivals (replayed batches arrive in bursts and are left out)
+    RunningStats interArrival; // ms
+    float jitterMs;            // smoothed change in transit time, RFC 3550 style
+    uint32_t received;         // all samples, replayed ones included
+    uint32_t lastArrival;
+    int32_t lastTransit; // receivedAt - sentAt of the previous live sample
+    uint32_t timingGaps; // live inter-arrivals above STATS_GAP_FACTOR x mean
+
+    // Sequence numbers
+    uint32_t highestSeq;
+    // Numbers skipped; a late arrival takes its number back. A jump of
+    // DEDUP_WINDOW or more either way is a restart and is not counted.
+    uint32_t lost;
+    uint32_t reordered; // arrived below the highest seen
+
+    // Touch activity
+    uint32_t presses;
+    uint32_t pressStart;
+    uint32_t pressTotalMs;
+    uint32_t pressMaxMs;
+    uint32_t pressesTimed; // releases with a known press start
+
+    // Battery discharge: percent per hour between samples STATS_SLOPE_SPAN apart
+    uint32_t batteryAnchorAt;
+    int32_t batteryAnchor;
+    float batteryPerHour; // smoothed; negative while discharging
+    uint16_t slopeSamples;
+
+    uint8_t flags;
+};
+
+// Per-slot statistics owned by SensorManager. Updated by the ingest
+// consumer and published per slot through a seqlock, so the server task on
+// the other core always copies one sender's numbers from a single update.
+// Streamed responses copy them with the table snapshot, so a slot reused
+// while sending cannot show another sender's numbers.
+class SensorStatsTracker
+{
+private:
+    Seqlock<SensorStats> stats[MAX_TRACKED_SENSORS];
+
+public:
+    // Ingest consumer side
+    void resetSlot(int slot);
+    void recordArrival(int slot, const SensorSample &sample);
+    // Only for values that became the shown value, in capture order
+    void recordValue(int slot, const int32_t (&channels)[SENSOR_CHANNEL_COUNT], uint32_t sampleTime);
+
+    // Server task side: the members of one sender's object
+    SensorStats get(int slot) const; // consistent copy
+    void writeJSON(JsonWriter &json, int slot) const { writeJSON(json, get(slot)); }
+    static void writeJSON(JsonWriter &json, const SensorStats &s);
+};
+
+#endif // SENSOR_STATS_H
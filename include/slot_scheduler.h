@@ -0,0 +1,82 @@
+#ifndef SLOT_SCHEDULER_H
+#define SLOT_SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "response_arena.h"
+
+#define TDMA_FRAME_MS (TDMA_SLOT_COUNT * TDMA_SLOT_WIDTH)
+
+// Aggregator side: hands out transmit slots, preferring slot == clientId, and
+// counts how well arrivals line up with them. Slots are frames of the
+// aggregator's millis() clock, so the epoch is shared through the "t=" field
+// of every ack. Used from the server task only.
+class SlotAllocator
+{
+private:
+    struct Slot
+    {
+        uint32_t ip;
+        uint32_t lastSeen;
+    };
+
+    Slot slots[TDMA_SLOT_COUNT];
+    uint32_t lastWindow; // slot-width window of the previous arrival
+    uint32_t lastWindowIp;
+
+    uint32_t arrivals;
+    uint32_t onSlot;
+    uint32_t collisions; // arrivals sharing a window with another sender
+    uint32_t reassignments;
+
+public:
+    SlotAllocator();
+
+    // Returns the slot for this sender, or -1 when every slot is leased
+    int assign(uint32_t ip, int preferred, uint32_t now);
+    void recordArrival(uint32_t ip, int slot, uint32_t now);
+
+    void writeJSON(JsonWriter &json, uint32_t now) const;
+};
+
+// Client side: tracks the aggregator clock from acks and opens a send
+// window once per frame, inside our slot
+class SlotScheduler
+{
+private:
+    int slot; // -1 until the aggregator assigns one
+    uint32_t frameMs;
+    uint32_t slotWidthMs;
+    int32_t offsetMs; // aggregator time - local time
+    uint32_t bestRttMs;
+
+    // Counters for comparing against unscheduled sending
+    uint32_t sends;
+    uint32_t acks;
+    uint32_t retries; // sends that followed a failed one
+    uint32_t totalAckMs;
+    bool lastFailed;
+
+public:
+    SlotScheduler();
+
+    bool isScheduled() const { return slot >= 0; }
+    // Periodic send gate: interval elapsed (within half a frame) and inside our slot
+    bool isDue(uint32_t now, uint32_t lastSend, uint32_t intervalMs) const;
+    uint32_t msUntilSlot(uint32_t now) const;
+    // How long until isDue() can next be true
+    uint32_t msUntilDue(uint32_t now, uint32_t lastSend, uint32_t intervalMs) const;
+
+    void onAck(const String &reply, uint32_t sentAt, uint32_t rttMs);
+    void onFailure();
+
+    int getSlot() const { return slot; }
+    uint32_t getSendCount() const { return sends; }
+    uint32_t getRetryCount() const { return retries; }
+    uint32_t getAverageAckMs() const { return acks ? totalAckMs / acks : 0; }
+
+    // Reads ";key=<number>" from an aggregator reply, fallback if absent
+    static long parseField(const String &reply, const char *key, long fallback);
+};
+
+#endif // SLOT_SCHEDULER_H
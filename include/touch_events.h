@@ -0,0 +1,50 @@
+#ifndef TOUCH_EVENTS_H
+#define TOUCH_EVENTS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"
+#include "lockfree_queue.h"
+
+struct TouchEvent
+{
+    uint32_t timestampUs; // micros() at the accepted edge
+    uint8_t level;        // pin level after the edge
+};
+
+// Captures touch edges from a GPIO interrupt so presses shorter than the
+// send interval are not lost. The ISR debounces and queues timestamped
+// edges; loop() pops them and sends each one right away.
+class TouchEventCapture
+{
+private:
+    MpscQueue<TouchEvent, TOUCH_EVENT_QUEUE_SIZE> queue;
+    uint8_t pin;
+    portMUX_TYPE edgeLock; // ISR and poll() both record edges
+    volatile uint32_t lastEdgeUs;
+    volatile uint8_t lastLevel;
+    std::atomic<uint32_t> capturedCount;
+    std::atomic<uint32_t> droppedCount;
+    uint32_t sentCount; // loop task only
+    TaskHandle_t wakeTask;
+
+    static void handleInterrupt(void *arg);
+    void recordEdge(uint8_t level, uint32_t now);
+
+public:
+    TouchEventCapture();
+
+    void begin(uint8_t touchPin);
+    void setWakeTask(TaskHandle_t task) { wakeTask = task; } // notified on every accepted edge
+
+    // Consumer side - also catches a release that landed inside the debounce window
+    bool poll(TouchEvent &event);
+    void markSent() { sentCount++; }
+
+    int currentLevel() const { return lastLevel; }
+    uint32_t getCapturedCount() const { return capturedCount.load(std::memory_order_relaxed); }
+    uint32_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+    uint32_t getSentCount() const { return sentCount; }
+};
+
+#endif // TOUCH_EVENTS_H
@@ -0,0 +1,50 @@
+#ifndef TRAFFIC_CAPTURE_H
+#define TRAFFIC_CAPTURE_H
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include "config.h"
+#include "response_arena.h"
+
+// Raw /sensor and /sensorBatch requests recorded to SPIFFS so incidents can
+// be replayed with tools/capture_replay.py. Little-endian, no padding:
+//
+//   header: magic u16 "TC" | version u8 | flags u8 | started millis u32
+//   record: offset ms u32 (since start) | source ip u32 | kind u8 |
+//           body length u16 | body bytes (the form exactly as received)
+#define CAPTURE_MAGIC 0x4354 // "TC" on the wire
+#define CAPTURE_VERSION 1
+#define CAPTURE_HEADER_SIZE 8
+#define CAPTURE_RECORD_HEADER_SIZE 11
+#define CAPTURE_KIND_SENSOR 1       // POST /sensor
+#define CAPTURE_KIND_SENSOR_BATCH 2 // POST /sensorBatch
+
+// Records are collected in RAM and written a block at a time, so flash is
+// touched once every few dozen requests. Server task only.
+class TrafficCapture
+{
+private:
+    File file;
+    uint8_t buffer[CAPTURE_BUFFER_SIZE];
+    size_t buffered;
+    uint32_t bytes; // in the file, buffered included
+    uint32_t startedAt;
+    uint32_t stoppedAt;
+    uint32_t records;
+    uint32_t dropped; // over CAPTURE_MAX_BYTES or failed writes
+    bool active;
+
+    bool flush();
+
+public:
+    TrafficCapture();
+
+    bool start(uint32_t now); // replaces any previous capture
+    void stop();
+    void record(uint32_t now, uint32_t ip, uint8_t kind, const char *body, size_t length);
+
+    bool isActive() const { return active; }
+    void writeJSON(JsonWriter &json, uint32_t now) const;
+};
+
+#endif // TRAFFIC_CAPTURE_H
@@ -0,0 +1,45 @@
+#ifndef UART_EXPORT_H
+#define UART_EXPORT_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "sensor_frame.h"
+
+// CRC-16/CCITT-FALSE trailer plus COBS overhead and the 0x00 delimiter
+#define UART_EXPORT_MAX_ENCODED (SENSOR_FRAME_MAX_SIZE + 2 + (SENSOR_FRAME_MAX_SIZE + 2) / 254 + 2)
+
+// Streams the sensor table to a serially attached host as SensorFrames, each
+// followed by a little-endian CRC-16 and COBS-encoded, so 0x00 only ever
+// appears as the frame delimiter. The UART driver's transmit ring holds two
+// encoded frames and is drained by interrupt: one frame goes out while the
+// next is queued, and the loop never waits on the wire. If the ring has no
+// room for a frame it is skipped and the next one is sent full.
+class UartExport
+{
+private:
+    HardwareSerial &port;
+    SensorFrameEncoder encoder;
+    uint32_t lastFrameAt;
+    uint8_t frame[SENSOR_FRAME_MAX_SIZE + 2];
+    uint8_t encoded[UART_EXPORT_MAX_ENCODED];
+
+    uint32_t framesSent;
+    uint32_t framesSkipped;
+    uint32_t bytesSent;
+
+public:
+    explicit UartExport(HardwareSerial &port);
+
+    void begin();
+    void poll(uint32_t now, const SensorManager &manager); // call from loop()
+
+    uint32_t getFramesSent() const { return framesSent; }
+    uint32_t getFramesSkipped() const { return framesSkipped; }
+    uint32_t getBytesSent() const { return bytesSent; }
+
+    static uint16_t crc16(const uint8_t *data, size_t len);
+    // Returns the encoded length including the trailing 0x00
+    static size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out);
+};
+
+#endif // UART_EXPORT_H
@@ -0,0 +1,59 @@
+#ifndef UPLINK_ROUTER_H
+#define UPLINK_ROUTER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// What one attempt says about a destination's health
+enum class UplinkOutcome : uint8_t
+{
+    Answered,    // any reply but a failing 5xx; 429 and 503 are load, not faults
+    Failed,      // transport error or a 5xx other than 503
+    HedgeExpired // no reply within the hedge budget; slow, not necessarily down
+};
+
+// Health tracking over a list of aggregators. The first healthy entry in
+// list order is the primary; a destination is marked down after
+// UPLINK_FAIL_THRESHOLD consecutive failures and probed again once
+// UPLINK_DOWN_RETRY has passed. Hedge expiries are counted on their own
+// and never mark a destination down.
+class UplinkRouter
+{
+private:
+    struct Destination
+    {
+        const char *host;
+        uint8_t consecutiveFailures;
+        bool down;
+        uint32_t downSince;
+        uint32_t successes;
+        uint32_t failures;
+        uint32_t hedgeExpiries;
+        uint32_t smoothedRttMs;
+    };
+
+    Destination destinations[UPLINK_MAX_DESTINATIONS];
+    size_t count;
+    int lastPrimary;
+    uint32_t failoverCount;
+    uint32_t hedgeCount;
+
+    bool isUsable(const Destination &d, uint32_t now) const;
+
+public:
+    UplinkRouter(const char *const *hosts, size_t hostCount);
+
+    // Index of the destination to try first, then the next one after it; -1 if none
+    int primary(uint32_t now);
+    int next(int after, uint32_t now) const;
+
+    void onResult(int index, UplinkOutcome outcome, uint32_t rttMs, uint32_t now);
+    static UplinkOutcome classify(int httpCode, bool hedged, uint32_t elapsedMs);
+
+    const char *getHost(int index) const { return destinations[index].host; }
+    size_t size() const { return count; }
+    uint32_t getFailoverCount() const { return failoverCount; }
+    uint32_t getHedgeCount() const { return hedgeCount; }
+};
+
+#endif // UPLINK_ROUTER_H
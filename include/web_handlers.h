@@ -1,39 +1,83 @@
 #ifndef WEB_HANDLERS_H
 #define WEB_HANDLERS_H
 
-#include <WebServer.h>
+#include "http_server.h"
 #include <SPIFFS.h>
 #include "sensor_manager.h"
+#include "sensor_ingest.h"
+#include "slot_scheduler.h"
+#include "duplicate_filter.h"
+#include "admission_control.h"
+#include "response_arena.h"
+#include "heap_monitor.h"
+#include "json_stream.h"
+#include "traffic_capture.h"
 
-class WebHandlers
+class WebHandlers : public HttpRouter
 {
 private:
-    WebServer *server;
+    AsyncHttpServer *server;
     SensorManager *sensorManager;
+    SensorIngest *sensorIngest;
     int *clientIdPtr; // Store pointer to clientId for cleaner access
+    SlotAllocator slotAllocator;
+    DuplicateFilter duplicates;
+    AdmissionControl admission;
+    ResponseArena arena; // response scratch, reset after each request
+    HeapMonitor *heapMonitor;
+    FileListStream listStreams[HTTP_MAX_STREAMS];
+    SensorTableStream tableStreams[HTTP_MAX_STREAMS];
+#if CAPTURE_ENABLED
+    TrafficCapture capture;
+#endif
 
     // Helper methods
-    String getContentType(String filename);
-    bool sendFile(String path);
-    bool isValidFileExtension(String filename);
-    void sendJsonResponse(bool success, String message = "", String data = "");
+    bool sendFile(const char *path);
+    void sendJson(const JsonWriter &json);
+    void sendJsonResponse(bool success, const char *message);
+    void sendStreamsBusy();
+    bool acceptsBinary(BinaryFormat &format);
+    void sendBinary(const BinaryWriter &out);
+    void sendSensorAck(uint32_t ip, const char *clientId);
+    bool admitSender(uint32_t ip);
+    uint32_t senderIP() const;
+    void captureRequest(uint32_t ip, uint8_t kind);
 
 public:
-    WebHandlers(WebServer *webServer, SensorManager *sensorMgr);
+    WebHandlers(AsyncHttpServer *webServer, SensorManager *sensorMgr, SensorIngest *ingest);
 
     // Core functionality
     void setupRoutes(int &clientId);
+    void setHeapMonitor(HeapMonitor *monitor) { heapMonitor = monitor; }
+
+    // HttpRouter: dispatch from the constexpr route table
+    int match(HttpMethod method, const char *path, size_t pathLen) const override;
+    bool acceptsUpload(int route) const override;
+    void handle(int route) override;
+    void handleUpload(int route) override;
 
     // Route handlers - grouped by functionality
     void handleRoot();
     void handleStaticFile();
+    void handleNotFound();
 
     // Sensor data handlers
     void handleSensorData();
+    void handleSensorBatch();
     void handleGetSensorData();
     void handleGetLocalSensorData();
+    void handleGetLatency();
+    void handleGetSensorStats();
+    void handleGetSlots();
+    void handleGetIngestStats();
+    void handleGetHeap();
     void handleSensorDataPage();
     void handleSetClientId();
+#if CAPTURE_ENABLED
+    void handleGetCapture();
+    void handleCaptureControl();
+    void handleGetCaptureFile();
+#endif
 
     // File management handlers
     void handleUpload();
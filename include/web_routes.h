@@ -0,0 +1,53 @@
+#ifndef WEB_ROUTES_H
+#define WEB_ROUTES_H
+
+#include "http_server.h"
+
+#if CAPTURE_ENABLED
+#define WEB_CAPTURE_ROUTES(ROUTE)                                                             \
+    ROUTE(CaptureStatus, Get, "/capture", &WebHandlers::handleGetCapture, nullptr)            \
+    ROUTE(CaptureControl, Post, "/capture", &WebHandlers::handleCaptureControl, nullptr)      \
+    ROUTE(CaptureFile, Get, "/capture.bin", &WebHandlers::handleGetCaptureFile, nullptr)
+#else
+#define WEB_CAPTURE_ROUTES(ROUTE)
+#endif
+
+// One line per route: id, method, path, handler, multipart upload handler.
+// The handlers are only named here; web_handlers.cpp is the one place that
+// expands them, so the table also builds without WebHandlers.
+#define WEB_ROUTE_TABLE(ROUTE)                                                                      \
+    ROUTE(Root, Get, "/", &WebHandlers::handleRoot, nullptr)                                        \
+    ROUTE(SensorPage, Get, "/sensorpage", &WebHandlers::handleSensorDataPage, nullptr)              \
+    ROUTE(UploadPage, Get, "/upload", &WebHandlers::handleUpload, nullptr)                          \
+    ROUTE(FirmwarePage, Get, "/firmware", &WebHandlers::handleFirmware, nullptr)                    \
+    ROUTE(Sensor, Post, "/sensor", &WebHandlers::handleSensorData, nullptr)                         \
+    ROUTE(SensorBatch, Post, "/sensorBatch", &WebHandlers::handleSensorBatch, nullptr)              \
+    ROUTE(SensorData, Get, "/sensorData", &WebHandlers::handleGetSensorData, nullptr)               \
+    ROUTE(LocalSensorData, Get, "/localSensorData", &WebHandlers::handleGetLocalSensorData, nullptr) \
+    ROUTE(IngestStats, Get, "/ingestStats", &WebHandlers::handleGetIngestStats, nullptr)            \
+    ROUTE(Heap, Get, "/heap", &WebHandlers::handleGetHeap, nullptr)                                 \
+    ROUTE(Slots, Get, "/slots", &WebHandlers::handleGetSlots, nullptr)                              \
+    ROUTE(Latency, Get, "/latency", &WebHandlers::handleGetLatency, nullptr)                        \
+    ROUTE(SensorStats, Get, "/sensorStats", &WebHandlers::handleGetSensorStats, nullptr)            \
+    ROUTE(SetClientId, Post, "/setClientId", &WebHandlers::handleSetClientId, nullptr)              \
+    ROUTE(Upload, Post, "/upload", nullptr, &WebHandlers::handleFileUpload)                         \
+    ROUTE(Delete, Post, "/delete", &WebHandlers::handleDeleteFile, nullptr)                         \
+    ROUTE(List, Get, "/list", &WebHandlers::handleListFiles, nullptr)                               \
+    ROUTE(FirmwareUpdate, Post, "/firmwareUpdate", &WebHandlers::handleFirmwareUpdate, nullptr)     \
+    WEB_CAPTURE_ROUTES(ROUTE)
+
+enum WebRouteId : uint8_t
+{
+#define WEB_ROUTE_ID(id, m, path, handler, upload) WEB_ROUTE_##id,
+    WEB_ROUTE_TABLE(WEB_ROUTE_ID)
+#undef WEB_ROUTE_ID
+    WEB_ROUTE_COUNT
+};
+
+// Route for a request, or HTTP_NO_ROUTE. Switches on httpRouteKey() with a
+// case per table line, so a repeated method + path, or two routes whose
+// keys collide, does not compile; one memcmp then rejects other paths that
+// share a route's key.
+int webRouteMatch(HttpMethod method, const char *path, size_t pathLen);
+
+#endif // WEB_ROUTES_H
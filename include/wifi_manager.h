@@ -3,22 +3,99 @@
 
 #include <WiFi.h>
 #include <ArduinoOTA.h>
+#include "config.h"
+#include "lockfree_queue.h"
 
+class LEDController;
+
+enum class WiFiState : uint8_t
+{
+    Idle,
+    Connecting,
+    Connected,
+    Backoff
+};
+
+// Last good association, reused to skip the scan and DHCP on the next connect
+struct WiFiCache
+{
+    uint32_t magic;
+    uint8_t channel;
+    uint8_t bssid[6];
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+// Non-blocking station manager. WiFi events are queued from the event task
+// and applied in handleConnection(); connects try the cached channel, BSSID
+// and lease first and fall back to a full scan with DHCP. A cached lease is
+// only used once an ARP check finds the gateway and nobody else on its
+// address.
 class WiFiManager
 {
 private:
-    unsigned long lastReconnectAttempt;
+    struct EventRecord
+    {
+        uint8_t id; // WIFI_EVENT_* below
+        uint8_t reason;
+        uint8_t channel;
+        uint8_t bssid[6];
+        unsigned long at; // millis() on the event task; older than attemptStart is stale
+    };
+
+    MpscQueue<EventRecord, WIFI_EVENT_QUEUE_SIZE> events;
+    WiFiState state;
+    LEDController *statusLed; // optional; shows the state
+    WiFiCache cache;
+    bool cacheValid;
+    bool fastAttempt;   // current attempt uses the cache
+    bool leaseCheck;    // fast attempt got its IP; waiting on the ARP check
+    bool otaReady;
+    bool everConnected;
+    uint8_t pendingChannel;
+    uint8_t pendingBssid[6];
+    unsigned long attemptStart;
+    unsigned long leaseCheckAt;
+    unsigned long outageStart; // cold boot or link loss
+    unsigned long retryAt;
+    unsigned long backoff;
+
+    // Metrics
+    unsigned long bootConnectMs;
+    unsigned long lastReconnectMs;
+    uint32_t reconnectCount;
+    uint32_t fastConnectCount;
+    uint32_t fullConnectCount;
 
     void setupOTA();
     void printWiFiStatus();
+    void onEvent(WiFiEvent_t event, WiFiEventInfo_t info);
+    void loadCache();
+    void saveCache();
+    void startAttempt(bool useCache);
+    void startLeaseCheck();
+    void finishLeaseCheck();
+    void onConnected();
+    void onAttemptFailed();
+    void setState(WiFiState next);
 
 public:
     WiFiManager();
 
-    bool init();
+    void setStatusLed(LEDController *led); // call before init()
+    void init(); // starts connecting and returns immediately
     void handleConnection();
     bool isConnected();
     void printConnectionInfo();
+
+    WiFiState getState() const { return state; }
+    unsigned long getBootConnectMs() const { return bootConnectMs; }
+    unsigned long getLastReconnectMs() const { return lastReconnectMs; }
+    uint32_t getReconnectCount() const { return reconnectCount; }
+    uint32_t getFastConnectCount() const { return fastConnectCount; }
+    uint32_t getFullConnectCount() const { return fullConnectCount; }
 };
 
-#endif // WIFI_MANAGER_H
\ No newline at end of file
+#endif // WIFI_MANAGER_H
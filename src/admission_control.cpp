@@ -0,0 +1,72 @@
+#include "admission_control.h"
+
+#define ADMISSION_FULL_BUCKET ((uint32_t)ADMISSION_BURST * 1000)
+
+AdmissionControl::AdmissionControl() : rejectedCount(0)
+{
+    memset(buckets, 0, sizeof(buckets));
+}
+
+AdmissionControl::Bucket *AdmissionControl::findOrRecycle(uint32_t ip, uint32_t now)
+{
+    Bucket *oldest = &buckets[0];
+    for (int i = 0; i < MAX_TRACKED_SENSORS; i++)
+    {
+        if (buckets[i].ip == ip)
+            return &buckets[i];
+        if (buckets[i].ip == 0 || (oldest->ip != 0 && now - buckets[i].lastUsed > now - oldest->lastUsed))
+            oldest = &buckets[i];
+    }
+
+    // New sender (or one idle long enough to be evicted) starts with a full bucket
+    memset(oldest, 0, sizeof(Bucket));
+    oldest->ip = ip;
+    oldest->milliTokens = ADMISSION_FULL_BUCKET;
+    oldest->refilledAt = now;
+    return oldest;
+}
+
+bool AdmissionControl::admit(uint32_t ip, uint32_t now, uint32_t &retryAfterMs)
+{
+    Bucket *bucket = findOrRecycle(ip, now);
+    bucket->lastUsed = now;
+
+    // ADMISSION_RATE per second is ADMISSION_RATE thousandths per ms
+    uint32_t elapsed = now - bucket->refilledAt;
+    if (elapsed > ADMISSION_FULL_BUCKET / ADMISSION_RATE)
+        elapsed = ADMISSION_FULL_BUCKET / ADMISSION_RATE; // full anyway; avoids overflow
+    bucket->milliTokens += elapsed * ADMISSION_RATE;
+    if (bucket->milliTokens > ADMISSION_FULL_BUCKET)
+        bucket->milliTokens = ADMISSION_FULL_BUCKET;
+    bucket->refilledAt = now;
+
+    if (bucket->milliTokens >= 1000)
+    {
+        bucket->milliTokens -= 1000;
+        bucket->admitted++;
+        return true;
+    }
+
+    retryAfterMs = (1000 - bucket->milliTokens + ADMISSION_RATE - 1) / ADMISSION_RATE;
+    bucket->rejected++;
+    rejectedCount++;
+    return false;
+}
+
+void AdmissionControl::writeJSON(JsonWriter &json) const
+{
+    json.beginArray();
+    for (int i = 0; i < MAX_TRACKED_SENSORS; i++)
+    {
+        const Bucket &bucket = buckets[i];
+        if (bucket.ip == 0 || bucket.rejected == 0)
+            continue;
+        json.beginObject()
+            .key("ip")
+            .ip(bucket.ip)
+            .field("admitted", bucket.admitted)
+            .field("rejected", bucket.rejected)
+            .endObject();
+    }
+    json.endArray();
+}
@@ -0,0 +1,206 @@
+#include "binary_writer.h"
+
+BinaryWriter::BinaryWriter(BinaryFormat format, uint8_t *buffer, size_t capacity)
+    : format(format), buf(buffer), capacity(capacity), len(0), overflowed(buffer == nullptr)
+{
+}
+
+const char *BinaryWriter::contentType() const
+{
+    return format == BinaryFormat::Cbor ? "application/cbor" : "application/msgpack";
+}
+
+void BinaryWriter::put(uint8_t byte)
+{
+    put(&byte, 1);
+}
+
+void BinaryWriter::put(const void *data, size_t length)
+{
+    if (overflowed || len + length > capacity)
+    {
+        overflowed = true;
+        return;
+    }
+    memcpy(buf + len, data, length);
+    len += length;
+}
+
+void BinaryWriter::putBigEndian(uint32_t v, size_t bytes)
+{
+    uint8_t out[4];
+    for (size_t i = 0; i < bytes; i++)
+        out[i] = v >> (8 * (bytes - 1 - i));
+    put(out, bytes);
+}
+
+// Major type in the top three bits, then the shortest argument encoding
+void BinaryWriter::cborHead(uint8_t major, uint32_t v)
+{
+    major <<= 5;
+    if (v < 24)
+    {
+        put(major | v);
+    }
+    else if (v <= 0xFF)
+    {
+        put(major | 24);
+        put((uint8_t)v);
+    }
+    else if (v <= 0xFFFF)
+    {
+        put(major | 25);
+        putBigEndian(v, 2);
+    }
+    else
+    {
+        put(major | 26);
+        putBigEndian(v, 4);
+    }
+}
+
+void BinaryWriter::container(uint8_t cborMajor, uint8_t fixBase, uint8_t wide16, size_t count)
+{
+    if (format == BinaryFormat::Cbor)
+    {
+        cborHead(cborMajor, count);
+    }
+    else if (count < 16)
+    {
+        put(fixBase | count);
+    }
+    else
+    {
+        put(wide16);
+        putBigEndian(count, 2);
+    }
+}
+
+BinaryWriter &BinaryWriter::beginObject(size_t count)
+{
+    container(5, 0x80, 0xDE, count);
+    return *this;
+}
+
+BinaryWriter &BinaryWriter::beginArray(size_t count)
+{
+    container(4, 0x90, 0xDC, count);
+    return *this;
+}
+
+BinaryWriter &BinaryWriter::value(const char *text)
+{
+    size_t n = strlen(text);
+    if (format == BinaryFormat::Cbor)
+    {
+        cborHead(3, n);
+    }
+    else if (n < 32)
+    {
+        put(0xA0 | n);
+    }
+    else if (n <= 0xFF)
+    {
+        put(0xD9);
+        put((uint8_t)n);
+    }
+    else
+    {
+        put(0xDA);
+        putBigEndian(n, 2);
+    }
+    put(text, n);
+    return *this;
+}
+
+BinaryWriter &BinaryWriter::value(unsigned long number)
+{
+    uint32_t v = number;
+    if (format == BinaryFormat::Cbor)
+        cborHead(0, v);
+    else if (v < 128)
+        put((uint8_t)v);
+    else if (v <= 0xFF)
+    {
+        put(0xCC);
+        put((uint8_t)v);
+    }
+    else if (v <= 0xFFFF)
+    {
+        put(0xCD);
+        putBigEndian(v, 2);
+    }
+    else
+    {
+        put(0xCE);
+        putBigEndian(v, 4);
+    }
+    return *this;
+}
+
+BinaryWriter &BinaryWriter::value(long number)
+{
+    if (number >= 0)
+        return value((unsigned long)number);
+
+    if (format == BinaryFormat::Cbor)
+    {
+        cborHead(1, (uint32_t)(-1 - number));
+    }
+    else if (number >= -32)
+    {
+        put((uint8_t)(int8_t)number);
+    }
+    else if (number >= -128)
+    {
+        put(0xD0);
+        put((uint8_t)(int8_t)number);
+    }
+    else if (number >= -32768)
+    {
+        put(0xD1);
+        putBigEndian((uint16_t)(int16_t)number, 2);
+    }
+    else
+    {
+        put(0xD2);
+        putBigEndian((uint32_t)(int32_t)number, 4);
+    }
+    return *this;
+}
+
+BinaryWriter &BinaryWriter::value(float number, int)
+{
+    uint32_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    put(format == BinaryFormat::Cbor ? 0xFA : 0xCA);
+    putBigEndian(bits, 4);
+    return *this;
+}
+
+BinaryWriter &BinaryWriter::value(bool flag)
+{
+    if (format == BinaryFormat::Cbor)
+        put(flag ? 0xF5 : 0xF4);
+    else
+        put(flag ? 0xC3 : 0xC2);
+    return *this;
+}
+
+BinaryWriter &BinaryWriter::fixed(int32_t scaled, uint8_t decimals)
+{
+    if (decimals == 0)
+        return value((long)scaled);
+    float divisor = 1.0f;
+    for (uint8_t i = 0; i < decimals; i++)
+        divisor *= 10.0f;
+    return value(scaled / divisor);
+}
+
+BinaryWriter &BinaryWriter::ip(uint32_t address)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (unsigned)(address & 0xFF), (unsigned)((address >> 8) & 0xFF),
+             (unsigned)((address >> 16) & 0xFF), (unsigned)(address >> 24));
+    return value(text);
+}
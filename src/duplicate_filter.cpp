@@ -0,0 +1,74 @@
+#include "duplicate_filter.h"
+
+DuplicateFilter::DuplicateFilter() : useCounter(0), duplicateCount(0)
+{
+    memset(senders, 0, sizeof(senders));
+}
+
+DuplicateFilter::Sender *DuplicateFilter::find(uint32_t ip)
+{
+    for (int i = 0; i < MAX_TRACKED_SENSORS; i++)
+    {
+        if (senders[i].ip == ip && senders[i].seen)
+            return &senders[i];
+    }
+    return nullptr;
+}
+
+bool DuplicateFilter::isDuplicate(uint32_t ip, uint32_t seq)
+{
+    Sender *sender = find(ip);
+    if (!sender || (int32_t)(seq - sender->highestSeq) > 0)
+        return false;
+
+    uint32_t age = sender->highestSeq - seq;
+    if (age >= DEDUP_WINDOW)
+        return false; // far behind the window: the client restarted its counter
+
+    if (sender->seen & ((uint64_t)1 << age))
+    {
+        duplicateCount++;
+        return true;
+    }
+    return false;
+}
+
+void DuplicateFilter::record(uint32_t ip, uint32_t seq)
+{
+    Sender *sender = find(ip);
+    useCounter++;
+    if (!sender)
+    {
+        // Recycle the least recently used entry
+        sender = &senders[0];
+        for (int i = 1; i < MAX_TRACKED_SENSORS; i++)
+        {
+            if (senders[i].lastUsed < sender->lastUsed)
+                sender = &senders[i];
+        }
+        sender->ip = ip;
+        sender->highestSeq = seq;
+        sender->seen = 1;
+        sender->lastUsed = useCounter;
+        return;
+    }
+    sender->lastUsed = useCounter;
+
+    if ((int32_t)(seq - sender->highestSeq) > 0)
+    {
+        uint32_t shift = seq - sender->highestSeq;
+        sender->seen = shift >= 64 ? 0 : sender->seen << shift;
+        sender->seen |= 1;
+        sender->highestSeq = seq;
+        return;
+    }
+
+    uint32_t age = sender->highestSeq - seq;
+    if (age >= DEDUP_WINDOW)
+    {
+        sender->highestSeq = seq;
+        sender->seen = 1;
+        return;
+    }
+    sender->seen |= (uint64_t)1 << age;
+}
@@ -0,0 +1,287 @@
+#include "form_parser.h"
+#include <string.h>
+
+#define FORM_MAX_DIGITS 9 // keeps every accepted value inside int32_t
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool keyEquals(const char *key, size_t keyLen, const char *expected)
+{
+    return strlen(expected) == keyLen && memcmp(key, expected, keyLen) == 0;
+}
+
+static int findChannel(const char *key, size_t keyLen)
+{
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        const SensorChannelInfo &info = SENSOR_CHANNEL_INFO[ch];
+        if (info.keyLen == keyLen && memcmp(key, info.key, keyLen) == 0)
+            return ch;
+    }
+    return -1;
+}
+
+bool FormParser::parseInt(const char *text, size_t length, int32_t &out)
+{
+    return parseFixed(text, length, 0, out);
+}
+
+// Full-range unsigned parse for millis() timestamps
+bool FormParser::parseUint32(const char *text, size_t length, uint32_t &out)
+{
+    if (length == 0 || length > 10)
+        return false;
+    uint64_t value = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+            return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    if (value > 0xFFFFFFFFULL)
+        return false;
+    out = (uint32_t)value;
+    return true;
+}
+
+// Parses "[-]digits[.digits]" into value * 10^decimals. Extra fraction
+// digits are truncated; anything else is rejected.
+bool FormParser::parseFixed(const char *text, size_t length, uint8_t decimals, int32_t &out)
+{
+    size_t i = 0;
+    bool negative = false;
+    if (i < length && (text[i] == '-' || text[i] == '+'))
+    {
+        negative = text[i] == '-';
+        i++;
+    }
+
+    int32_t value = 0;
+    size_t digits = 0;
+    while (i < length && text[i] >= '0' && text[i] <= '9')
+    {
+        if (++digits > (size_t)(FORM_MAX_DIGITS - decimals))
+            return false;
+        value = value * 10 + (text[i] - '0');
+        i++;
+    }
+
+    uint8_t fraction = 0;
+    if (i < length && text[i] == '.')
+    {
+        i++;
+        while (i < length && text[i] >= '0' && text[i] <= '9')
+        {
+            if (fraction < decimals)
+            {
+                value = value * 10 + (text[i] - '0');
+                fraction++;
+            }
+            digits++;
+            i++;
+        }
+    }
+
+    if (digits == 0 || i != length)
+        return false;
+    for (; fraction < decimals; fraction++)
+        value *= 10;
+
+    out = negative ? -value : value;
+    return true;
+}
+
+// Percent/plus decoding into a fixed buffer; fails if it would not fit
+bool FormParser::decodeValue(const char *text, size_t length, char *out, size_t outSize)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = text[i];
+        if (c == '+')
+            c = ' ';
+        else if (c == '%')
+        {
+            if (i + 2 >= length)
+                return false;
+            int hi = hexDigit(text[i + 1]);
+            int lo = hexDigit(text[i + 2]);
+            if (hi < 0 || lo < 0)
+                return false;
+            c = (char)(hi * 16 + lo);
+            i += 2;
+        }
+        if (n + 1 >= outSize)
+            return false;
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+FormResult FormParser::parseSensorForm(const char *body, size_t length, SensorForm &out)
+{
+    memset(&out, 0, sizeof(out));
+
+    const char *end = body + length;
+    const char *pair = body;
+    while (pair < end)
+    {
+        const char *amp = (const char *)memchr(pair, '&', end - pair);
+        const char *pairEnd = amp ? amp : end;
+        const char *eq = (const char *)memchr(pair, '=', pairEnd - pair);
+        if (!eq)
+            return FormResult::Invalid;
+
+        const char *value = eq + 1;
+        size_t keyLen = eq - pair;
+        size_t valueLen = pairEnd - value;
+        bool ok = true;
+
+        int channel = findChannel(pair, keyLen);
+        if (channel >= 0)
+        {
+            ok = parseFixed(value, valueLen, SENSOR_CHANNEL_INFO[channel].decimals, out.channels[channel]);
+        }
+        else if (keyEquals(pair, keyLen, "clientId"))
+        {
+            ok = decodeValue(value, valueLen, out.clientId, sizeof(out.clientId));
+            out.fields |= FORM_FIELD_CLIENT_ID;
+        }
+        else if (keyEquals(pair, keyLen, "capturedAt"))
+        {
+            ok = parseUint32(value, valueLen, out.capturedAt);
+            out.fields |= FORM_FIELD_CAPTURED_AT;
+        }
+        else if (keyEquals(pair, keyLen, "sentAt"))
+        {
+            ok = parseUint32(value, valueLen, out.sentAt);
+            out.fields |= FORM_FIELD_SENT_AT;
+        }
+        else if (keyEquals(pair, keyLen, "rtt"))
+        {
+            ok = parseUint32(value, valueLen, out.rttMs);
+            out.fields |= FORM_FIELD_RTT;
+        }
+        else if (keyEquals(pair, keyLen, "seq"))
+        {
+            ok = parseUint32(value, valueLen, out.seq);
+            out.fields |= FORM_FIELD_SEQ;
+        }
+        // Unknown keys are skipped so older clients keep working
+
+        if (!ok)
+            return FormResult::Invalid;
+        pair = pairEnd + 1;
+    }
+
+    return (out.fields & FORM_FIELD_CLIENT_ID) ? FormResult::Ok : FormResult::Missing;
+}
+
+FormResult FormParser::parseSensorBatch(const char *body, size_t length, SensorBatchForm &out)
+{
+    memset(&out, 0, sizeof(out));
+
+    const char *end = body + length;
+    const char *pair = body;
+    while (pair < end)
+    {
+        const char *amp = (const char *)memchr(pair, '&', end - pair);
+        const char *pairEnd = amp ? amp : end;
+        const char *eq = (const char *)memchr(pair, '=', pairEnd - pair);
+        if (!eq)
+            return FormResult::Invalid;
+
+        const char *value = eq + 1;
+        size_t keyLen = eq - pair;
+        size_t valueLen = pairEnd - value;
+        bool ok = true;
+
+        if (keyEquals(pair, keyLen, "clientId"))
+        {
+            ok = decodeValue(value, valueLen, out.clientId, sizeof(out.clientId));
+            out.fields |= FORM_FIELD_CLIENT_ID;
+        }
+        else if (keyEquals(pair, keyLen, "sentAt"))
+        {
+            ok = parseUint32(value, valueLen, out.sentAt);
+            out.fields |= FORM_FIELD_SENT_AT;
+        }
+        else if (keyEquals(pair, keyLen, "rtt"))
+        {
+            ok = parseUint32(value, valueLen, out.rttMs);
+            out.fields |= FORM_FIELD_RTT;
+        }
+        else if (keyEquals(pair, keyLen, "seq"))
+        {
+            ok = parseUint32(value, valueLen, out.seq);
+            out.fields |= FORM_FIELD_SEQ;
+        }
+        else if (keyEquals(pair, keyLen, "samples"))
+        {
+            out.samples = value;
+            out.samplesLength = valueLen;
+        }
+
+        if (!ok)
+            return FormResult::Invalid;
+        pair = pairEnd + 1;
+    }
+
+    if (!(out.fields & FORM_FIELD_CLIENT_ID) || !(out.fields & FORM_FIELD_SENT_AT) || !out.samples)
+        return FormResult::Missing;
+    return FormResult::Ok;
+}
+
+FormResult FormParser::nextBatchEntry(const char *&cursor, const char *end, BatchEntry &out)
+{
+    if (cursor >= end)
+        return FormResult::Missing;
+
+    const char *semi = (const char *)memchr(cursor, ';', end - cursor);
+    const char *entryEnd = semi ? semi : end;
+
+    // capturedAt, then one field per channel
+    const char *p = cursor;
+    for (int i = 0; i <= SENSOR_CHANNEL_COUNT; i++)
+    {
+        const char *comma = i < SENSOR_CHANNEL_COUNT ? (const char *)memchr(p, ',', entryEnd - p) : entryEnd;
+        if (!comma)
+            return FormResult::Invalid;
+        bool ok = i == 0 ? parseUint32(p, comma - p, out.capturedAt)
+                         : parseFixed(p, comma - p, SENSOR_CHANNEL_INFO[i - 1].decimals, out.channels[i - 1]);
+        if (!ok)
+            return FormResult::Invalid;
+        p = comma + 1;
+    }
+
+    cursor = semi ? semi + 1 : end;
+    return FormResult::Ok;
+}
+
+FormResult FormParser::findInt(const char *data, size_t length, const char *key, int32_t &out)
+{
+    size_t keyLen = strlen(key);
+    const char *end = data + length;
+    const char *pair = data;
+    while (pair < end)
+    {
+        const char *amp = (const char *)memchr(pair, '&', end - pair);
+        const char *pairEnd = amp ? amp : end;
+        const char *eq = (const char *)memchr(pair, '=', pairEnd - pair);
+
+        if (eq && (size_t)(eq - pair) == keyLen && memcmp(pair, key, keyLen) == 0)
+            return parseInt(eq + 1, pairEnd - eq - 1, out) ? FormResult::Ok : FormResult::Invalid;
+        pair = pairEnd + 1;
+    }
+    return FormResult::Missing;
+}
@@ -0,0 +1,143 @@
+#include "gateway_uplink.h"
+#include <lwip/sockets.h>
+#include <errno.h>
+
+GatewayUplink::GatewayUplink()
+    : encoder(GATEWAY_BATTERY_DELTA, GATEWAY_FULL_REFRESH), fd(-1), state(LINK_DOWN), lastFrameAt(0),
+      lastConnectAt(0), txLen(0), txOffset(0), framesSent(0), framesSkipped(0), bytesSent(0), connectCount(0)
+{
+}
+
+void GatewayUplink::startConnect(uint32_t now)
+{
+    lastConnectAt = now;
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return;
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(GATEWAY_PORT);
+    addr.sin_addr.s_addr = inet_addr(GATEWAY_HOST);
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+        state = LINK_UP;
+    else if (errno == EINPROGRESS)
+        state = LINK_CONNECTING;
+    else
+        closeLink();
+
+    if (state == LINK_UP)
+    {
+        connectCount++;
+        encoder.requestFull();
+    }
+}
+
+void GatewayUplink::closeLink()
+{
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    state = LINK_DOWN;
+    txLen = 0;
+    txOffset = 0;
+}
+
+// Completes a non-blocking connect once the socket turns writable
+bool GatewayUplink::checkConnected()
+{
+    fd_set writeSet;
+    FD_ZERO(&writeSet);
+    FD_SET(fd, &writeSet);
+    struct timeval timeout = {0, 0};
+    if (select(fd + 1, nullptr, &writeSet, nullptr, &timeout) <= 0)
+        return false;
+
+    int error = 0;
+    socklen_t len = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+    if (error != 0)
+    {
+        closeLink();
+        return false;
+    }
+
+    state = LINK_UP;
+    connectCount++;
+    encoder.requestFull(); // a fresh receiver has no table yet
+    Serial.printf("[GATEWAY] Connected to %s:%d\n", GATEWAY_HOST, GATEWAY_PORT);
+    return true;
+}
+
+bool GatewayUplink::flush()
+{
+    while (txOffset < txLen)
+    {
+        ssize_t sent = send(fd, tx + txOffset, txLen - txOffset, 0);
+        if (sent > 0)
+        {
+            txOffset += sent;
+            bytesSent += sent;
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return false;
+        Serial.println("[GATEWAY] Upstream connection lost");
+        closeLink();
+        return false;
+    }
+    txLen = 0;
+    txOffset = 0;
+    return true;
+}
+
+void GatewayUplink::poll(uint32_t now, const SensorManager &manager)
+{
+    if (state == LINK_DOWN)
+    {
+        if (now - lastConnectAt >= GATEWAY_RECONNECT_INTERVAL)
+            startConnect(now);
+        return;
+    }
+    if (state == LINK_CONNECTING)
+    {
+        if (!checkConnected())
+        {
+            if (state == LINK_CONNECTING && now - lastConnectAt >= GATEWAY_RECONNECT_INTERVAL)
+                closeLink(); // connect timed out
+            return;
+        }
+    }
+
+    // Finish a partially sent frame before building the next one
+    if (txLen)
+        flush();
+    if (state != LINK_UP || now - lastFrameAt < GATEWAY_INTERVAL)
+        return;
+    lastFrameAt = now;
+
+    if (txLen)
+    {
+        // Upstream still draining the previous frame; resync with a full one later
+        framesSkipped++;
+        encoder.requestFull();
+        return;
+    }
+
+    SensorTable snapshot;
+    manager.getSnapshot(snapshot);
+    size_t len = encoder.encode(snapshot, now, tx + 2);
+    if (len == 0)
+        return; // nothing changed this tick
+    tx[0] = len & 0xFF;
+    tx[1] = len >> 8;
+    txLen = len + 2;
+    txOffset = 0;
+    framesSent++;
+    flush();
+}
@@ -0,0 +1,42 @@
+#include "heap_monitor.h"
+
+HeapMonitor::HeapMonitor()
+    : freeBytes(0), largestBlock(0), minFree(UINT32_MAX), minLargest(UINT32_MAX), fragmentation(0),
+      worstFragmentation(0), samples(0)
+{
+}
+
+void HeapMonitor::sample()
+{
+    freeBytes = ESP.getFreeHeap();
+    largestBlock = ESP.getMaxAllocHeap();
+    fragmentation = freeBytes ? 1000 - (uint64_t)largestBlock * 1000 / freeBytes : 0;
+
+    if (freeBytes < minFree)
+        minFree = freeBytes;
+    if (largestBlock < minLargest)
+        minLargest = largestBlock;
+    if (fragmentation > worstFragmentation)
+        worstFragmentation = fragmentation;
+    samples++;
+}
+
+void HeapMonitor::printStats() const
+{
+    Serial.printf("[HEAP] free %u (min %u), largest block %u (min %u), fragmentation %u.%u%% (worst %u.%u%%)\n",
+                  (unsigned)freeBytes, (unsigned)minFree, (unsigned)largestBlock, (unsigned)minLargest,
+                  fragmentation / 10, fragmentation % 10, worstFragmentation / 10, worstFragmentation % 10);
+}
+
+void HeapMonitor::writeJSON(JsonWriter &json) const
+{
+    json.beginObject()
+        .field("free", freeBytes)
+        .field("largestBlock", largestBlock)
+        .field("minFree", samples ? minFree : 0)
+        .field("minLargestBlock", samples ? minLargest : 0)
+        .field("fragmentationPermille", fragmentation)
+        .field("worstFragmentationPermille", worstFragmentation)
+        .field("samples", samples)
+        .endObject();
+}
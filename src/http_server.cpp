@@ -0,0 +1,968 @@
+#include "http_server.h"
+#include <lwip/sockets.h>
+#include <errno.h>
+
+static const char *findBytes(const char *haystack, size_t len, const char *needle, size_t needleLen)
+{
+    if (needleLen == 0 || len < needleLen)
+        return nullptr;
+    for (size_t i = 0; i + needleLen <= len; i++)
+    {
+        if (haystack[i] == needle[0] && memcmp(haystack + i, needle, needleLen) == 0)
+            return haystack + i;
+    }
+    return nullptr;
+}
+
+static bool equalsIgnoreCase(const char *a, size_t aLen, const char *b)
+{
+    size_t bLen = strlen(b);
+    return aLen == bLen && strncasecmp(a, b, aLen) == 0;
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+AsyncHttpServer::AsyncHttpServer(uint16_t port)
+    : port(port), listenFd(-1), router(nullptr), current(nullptr), uploadOwner(nullptr)
+{
+    for (Connection &conn : connections)
+    {
+        conn.fd = -1;
+        conn.state = CONN_FREE;
+        conn.rxLen = 0;
+    }
+}
+
+// ========================= SETUP =========================
+
+void AsyncHttpServer::setRouter(HttpRouter *router)
+{
+    this->router = router;
+}
+
+void AsyncHttpServer::begin()
+{
+    listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenFd < 0)
+    {
+        Serial.println("[HTTP] Cannot create socket");
+        return;
+    }
+
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, HTTP_MAX_CONNECTIONS) < 0)
+    {
+        Serial.printf("[HTTP] Cannot listen on port %u\n", port);
+        close(listenFd);
+        listenFd = -1;
+        return;
+    }
+    fcntl(listenFd, F_SETFL, O_NONBLOCK);
+
+    xTaskCreatePinnedToCore(taskEntry, "http_server", HTTP_SERVER_STACK_SIZE, this,
+                            HTTP_SERVER_PRIORITY, nullptr, HTTP_SERVER_CORE);
+}
+
+void AsyncHttpServer::taskEntry(void *arg)
+{
+    static_cast<AsyncHttpServer *>(arg)->run();
+}
+
+// ========================= EVENT LOOP =========================
+
+void AsyncHttpServer::run()
+{
+    for (;;)
+    {
+        fd_set readSet, writeSet;
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+        FD_SET(listenFd, &readSet);
+        int maxFd = listenFd;
+
+        for (Connection &conn : connections)
+        {
+            if (conn.state == CONN_FREE)
+                continue;
+            if (conn.state == CONN_SENDING)
+                FD_SET(conn.fd, &writeSet);
+            else if (conn.rxLen < HTTP_RX_BUFFER_SIZE)
+                FD_SET(conn.fd, &readSet);
+            if (conn.fd > maxFd)
+                maxFd = conn.fd;
+        }
+
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = HTTP_POLL_INTERVAL * 1000;
+        int ready = select(maxFd + 1, &readSet, &writeSet, nullptr, &timeout);
+        if (ready < 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(HTTP_POLL_INTERVAL));
+            continue;
+        }
+
+        if (ready > 0 && FD_ISSET(listenFd, &readSet))
+            acceptConnections();
+
+        for (Connection &conn : connections)
+        {
+            if (conn.state == CONN_FREE)
+                continue;
+            if (ready > 0 && FD_ISSET(conn.fd, &readSet))
+                receive(conn);
+            else if (ready > 0 && FD_ISSET(conn.fd, &writeSet))
+                pump(conn);
+
+            // Read the clock after the I/O above, which may have moved lastActivity past it
+            if (conn.state != CONN_FREE && millis() - conn.lastActivity > HTTP_IDLE_TIMEOUT)
+                closeConnection(conn);
+        }
+    }
+}
+
+void AsyncHttpServer::acceptConnections()
+{
+    for (;;)
+    {
+        struct sockaddr_in addr;
+        socklen_t addrLen = sizeof(addr);
+        int fd = accept(listenFd, (struct sockaddr *)&addr, &addrLen);
+        if (fd < 0)
+            return;
+
+        Connection *slot = nullptr;
+        for (Connection &conn : connections)
+        {
+            if (conn.state == CONN_FREE)
+            {
+                slot = &conn;
+                break;
+            }
+        }
+        if (!slot)
+        {
+            static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            ::send(fd, busy, sizeof(busy) - 1, 0);
+            close(fd);
+            continue;
+        }
+
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        slot->fd = fd;
+        slot->remoteIP = IPAddress((uint32_t)addr.sin_addr.s_addr);
+        slot->rxLen = 0;
+        slot->lastActivity = millis();
+        resetRequest(*slot);
+    }
+}
+
+void AsyncHttpServer::resetRequest(Connection &conn)
+{
+    conn.state = CONN_READ_HEADERS;
+    conn.headerLen = 0;
+    conn.contentLength = 0;
+    conn.bodyReceived = 0;
+    conn.path = nullptr;
+    conn.pathLen = 0;
+    conn.query = nullptr;
+    conn.queryLen = 0;
+    conn.keepAlive = false;
+    conn.http11 = false;
+    conn.isMultipart = false;
+    conn.route = HTTP_NO_ROUTE;
+    conn.boundaryLen = 0;
+    conn.fileOpen = false;
+    conn.tx = "";
+    conn.txOffset = 0;
+    conn.streaming = false;
+    conn.source = nullptr;
+    conn.responded = false;
+}
+
+void AsyncHttpServer::closeConnection(Connection &conn)
+{
+    if (uploadOwner == &conn)
+    {
+        if (conn.fileOpen)
+        {
+            bindRequest(conn);
+            uploadData.status = UPLOAD_FILE_ABORTED;
+            uploadData.currentSize = 0;
+            router->handleUpload(conn.route);
+            current = nullptr;
+        }
+        uploadOwner = nullptr;
+    }
+    if (conn.streaming)
+        conn.file.close();
+    endSource(conn);
+    if (current == &conn)
+        current = nullptr;
+
+    close(conn.fd);
+    conn.fd = -1;
+    conn.state = CONN_FREE;
+    conn.rxLen = 0;
+    conn.streaming = false;
+    conn.tx = String(); // release the send buffer
+}
+
+void AsyncHttpServer::receive(Connection &conn)
+{
+    ssize_t n = recv(conn.fd, conn.rx + conn.rxLen, HTTP_RX_BUFFER_SIZE - conn.rxLen, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        closeConnection(conn);
+        return;
+    }
+    if (n < 0)
+        return;
+
+    conn.rxLen += n;
+    conn.lastActivity = millis();
+    pump(conn);
+}
+
+// Drives a connection as far as the buffered input and socket allow.
+// Handles pipelined keep-alive requests without waiting for another event.
+void AsyncHttpServer::pump(Connection &conn)
+{
+    for (;;)
+    {
+        if (conn.state == CONN_SENDING)
+        {
+            FlushResult result = flush(conn);
+            if (result == FLUSH_ERROR)
+            {
+                closeConnection(conn);
+                return;
+            }
+            if (result == FLUSH_PENDING)
+                return;
+
+            if (!conn.keepAlive)
+            {
+                closeConnection(conn);
+                return;
+            }
+            resetRequest(conn);
+        }
+
+        if (!processInput(conn))
+            return;
+    }
+}
+
+// ========================= REQUEST PARSING =========================
+
+bool AsyncHttpServer::processInput(Connection &conn)
+{
+    switch (conn.state)
+    {
+    case CONN_READ_HEADERS:
+        return parseHeaders(conn);
+
+    case CONN_READ_BODY:
+        if (conn.rxLen - conn.headerLen < conn.contentLength)
+            return false;
+        finishRequest(conn);
+        return true;
+
+    case CONN_READ_UPLOAD:
+        return processUpload(conn);
+
+    default:
+        return false;
+    }
+}
+
+bool AsyncHttpServer::parseHeaders(Connection &conn)
+{
+    const char *end = findBytes(conn.rx, conn.rxLen, "\r\n\r\n", 4);
+    if (!end)
+    {
+        if (conn.rxLen >= HTTP_RX_BUFFER_SIZE)
+        {
+            sendError(conn, 431, "Request headers too large");
+            return true;
+        }
+        return false;
+    }
+    conn.headerLen = end - conn.rx + 4;
+
+    // Request line: METHOD SP target SP version CRLF
+    const char *line = conn.rx;
+    const char *lineEnd = findBytes(line, conn.headerLen, "\r\n", 2);
+    const char *sp1 = (const char *)memchr(line, ' ', lineEnd - line);
+    const char *sp2 = sp1 ? (const char *)memchr(sp1 + 1, ' ', lineEnd - sp1 - 1) : nullptr;
+    if (!sp1 || !sp2)
+    {
+        sendError(conn, 400, "Bad request line");
+        return true;
+    }
+
+    if (equalsIgnoreCase(line, sp1 - line, "GET"))
+        conn.method = HttpMethod::Get;
+    else if (equalsIgnoreCase(line, sp1 - line, "POST"))
+        conn.method = HttpMethod::Post;
+    else
+    {
+        sendError(conn, 405, "Method not allowed");
+        return true;
+    }
+
+    conn.path = sp1 + 1;
+    const char *question = (const char *)memchr(conn.path, '?', sp2 - conn.path);
+    if (question)
+    {
+        conn.pathLen = question - conn.path;
+        conn.query = question + 1;
+        conn.queryLen = sp2 - conn.query;
+    }
+    else
+    {
+        conn.pathLen = sp2 - conn.path;
+    }
+    conn.http11 = equalsIgnoreCase(sp2 + 1, lineEnd - sp2 - 1, "HTTP/1.1");
+    conn.keepAlive = conn.http11;
+
+    // Header fields we act on; the rest stay in rx for header()
+    bool expectContinue = false;
+    const char *cursor = lineEnd + 2;
+    const char *headersEnd = conn.rx + conn.headerLen - 2;
+    while (cursor < headersEnd)
+    {
+        const char *eol = findBytes(cursor, headersEnd - cursor + 2, "\r\n", 2);
+        const char *colon = (const char *)memchr(cursor, ':', eol - cursor);
+        if (colon)
+        {
+            const char *value = colon + 1;
+            while (value < eol && *value == ' ')
+                value++;
+            size_t nameLen = colon - cursor;
+            size_t valueLen = eol - value;
+
+            if (equalsIgnoreCase(cursor, nameLen, "Content-Length"))
+                conn.contentLength = strtoul(value, nullptr, 10);
+            else if (equalsIgnoreCase(cursor, nameLen, "Connection"))
+            {
+                if (equalsIgnoreCase(value, valueLen, "close"))
+                    conn.keepAlive = false;
+                else if (equalsIgnoreCase(value, valueLen, "keep-alive"))
+                    conn.keepAlive = true;
+            }
+            else if (equalsIgnoreCase(cursor, nameLen, "Expect"))
+                expectContinue = equalsIgnoreCase(value, valueLen, "100-continue");
+            else if (equalsIgnoreCase(cursor, nameLen, "Transfer-Encoding"))
+            {
+                sendError(conn, 501, "Chunked requests not supported");
+                return true;
+            }
+            else if (equalsIgnoreCase(cursor, nameLen, "Content-Type") && valueLen > 19 &&
+                     strncasecmp(value, "multipart/form-data", 19) == 0)
+            {
+                const char *token = findBytes(value, valueLen, "boundary=", 9);
+                if (token)
+                {
+                    token += 9;
+                    size_t tokenLen = eol - token;
+                    if (tokenLen > 1 && token[0] == '"')
+                    {
+                        token++;
+                        tokenLen -= 2;
+                    }
+                    if (tokenLen > 0 && tokenLen + 4 <= sizeof(conn.boundary))
+                    {
+                        memcpy(conn.boundary, "\r\n--", 4);
+                        memcpy(conn.boundary + 4, token, tokenLen);
+                        conn.boundaryLen = tokenLen + 4;
+                        conn.isMultipart = true;
+                    }
+                }
+            }
+        }
+        cursor = eol + 2;
+    }
+
+    conn.route = router ? router->match(conn.method, conn.path, conn.pathLen) : HTTP_NO_ROUTE;
+
+    if (conn.isMultipart && conn.route != HTTP_NO_ROUTE && router->acceptsUpload(conn.route))
+    {
+        if (uploadOwner && uploadOwner != &conn)
+        {
+            sendError(conn, 503, "Another upload is in progress");
+            return true;
+        }
+        uploadOwner = &conn;
+        conn.uploadState = UPLOAD_SEEK_BOUNDARY;
+        conn.state = CONN_READ_UPLOAD;
+    }
+    else if (conn.contentLength > HTTP_RX_BUFFER_SIZE - conn.headerLen)
+    {
+        sendError(conn, 413, "Request body too large");
+        return true;
+    }
+    else
+    {
+        conn.state = CONN_READ_BODY;
+    }
+
+    if (expectContinue)
+    {
+        static const char cont[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        ::send(conn.fd, cont, sizeof(cont) - 1, 0);
+    }
+    return true;
+}
+
+// Streaming multipart/form-data parser. File data is handed to the upload
+// handler as it arrives; only a boundary-sized tail is held back in rx.
+bool AsyncHttpServer::processUpload(Connection &conn)
+{
+    for (;;)
+    {
+        const char *data = conn.rx + conn.headerLen;
+        size_t available = conn.rxLen - conn.headerLen;
+        bool bodyComplete = conn.bodyReceived + available >= conn.contentLength;
+
+        switch (conn.uploadState)
+        {
+        case UPLOAD_SEEK_BOUNDARY:
+        {
+            // The first delimiter has no leading CRLF
+            const char *delimiter = conn.boundary + 2;
+            size_t delimiterLen = conn.boundaryLen - 2;
+            const char *found = findBytes(data, available, delimiter, delimiterLen);
+            if (!found)
+            {
+                if (bodyComplete)
+                {
+                    sendError(conn, 400, "Malformed multipart body");
+                    return true;
+                }
+                if (available >= delimiterLen)
+                    consumeBody(conn, available - delimiterLen + 1);
+                return false;
+            }
+            consumeBody(conn, found - data + delimiterLen);
+            conn.uploadState = UPLOAD_AFTER_BOUNDARY;
+            break;
+        }
+
+        case UPLOAD_AFTER_BOUNDARY:
+            if (available < 2)
+            {
+                if (bodyComplete)
+                {
+                    sendError(conn, 400, "Malformed multipart body");
+                    return true;
+                }
+                return false;
+            }
+            if (data[0] == '-' && data[1] == '-')
+            {
+                conn.uploadState = UPLOAD_DONE;
+            }
+            else
+            {
+                consumeBody(conn, 2); // CRLF before the part headers
+                conn.uploadState = UPLOAD_PART_HEADERS;
+            }
+            break;
+
+        case UPLOAD_PART_HEADERS:
+        {
+            const char *end = findBytes(data, available, "\r\n\r\n", 4);
+            if (!end)
+            {
+                if (bodyComplete || conn.rxLen >= HTTP_RX_BUFFER_SIZE)
+                {
+                    sendError(conn, 400, "Malformed multipart headers");
+                    return true;
+                }
+                return false;
+            }
+
+            uploadData.filename = "";
+            const char *name = findBytes(data, end - data, "filename=\"", 10);
+            if (name)
+            {
+                name += 10;
+                const char *quote = (const char *)memchr(name, '"', end - name);
+                if (quote)
+                {
+                    String filename;
+                    filename.reserve(quote - name);
+                    for (const char *p = name; p < quote; p++)
+                        filename += *p;
+                    uploadData.filename = filename;
+                }
+            }
+            consumeBody(conn, end - data + 4);
+
+            // Plain form fields in a multipart body are skipped
+            conn.fileOpen = uploadData.filename.length() > 0;
+            if (conn.fileOpen)
+            {
+                bindRequest(conn);
+                uploadData.status = UPLOAD_FILE_START;
+                uploadData.totalSize = 0;
+                uploadData.currentSize = 0;
+                router->handleUpload(conn.route);
+            }
+            conn.uploadState = UPLOAD_PART_DATA;
+            break;
+        }
+
+        case UPLOAD_PART_DATA:
+        {
+            const char *found = findBytes(data, available, conn.boundary, conn.boundaryLen);
+            if (!found)
+            {
+                if (bodyComplete)
+                {
+                    sendError(conn, 400, "Truncated multipart body");
+                    return true;
+                }
+                // Hold back enough bytes to catch a delimiter split across reads
+                if (available >= conn.boundaryLen)
+                {
+                    size_t safe = available - conn.boundaryLen + 1;
+                    deliverUploadData(conn, data, safe);
+                    consumeBody(conn, safe);
+                }
+                return false;
+            }
+
+            deliverUploadData(conn, data, found - data);
+            if (conn.fileOpen)
+            {
+                bindRequest(conn);
+                uploadData.status = UPLOAD_FILE_END;
+                uploadData.currentSize = 0;
+                router->handleUpload(conn.route);
+                conn.fileOpen = false;
+            }
+            consumeBody(conn, found - data + conn.boundaryLen);
+            conn.uploadState = UPLOAD_AFTER_BOUNDARY;
+            break;
+        }
+
+        case UPLOAD_DONE:
+        {
+            // Discard the epilogue, then run the route handler
+            size_t remaining = conn.contentLength > conn.bodyReceived ? conn.contentLength - conn.bodyReceived : 0;
+            consumeBody(conn, available < remaining ? available : remaining);
+            if (conn.bodyReceived < conn.contentLength)
+                return false;
+            uploadOwner = nullptr;
+            finishRequest(conn);
+            return true;
+        }
+        }
+    }
+}
+
+void AsyncHttpServer::deliverUploadData(Connection &conn, const char *data, size_t len)
+{
+    if (!conn.fileOpen)
+        return;
+
+    bindRequest(conn);
+    while (len > 0)
+    {
+        size_t chunk = len < HTTP_UPLOAD_BUFLEN ? len : HTTP_UPLOAD_BUFLEN;
+        memcpy(uploadData.buf, data, chunk);
+        uploadData.status = UPLOAD_FILE_WRITE;
+        uploadData.currentSize = chunk;
+        uploadData.totalSize += chunk;
+        router->handleUpload(conn.route);
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+// Drops body bytes that follow the headers in rx
+void AsyncHttpServer::consumeBody(Connection &conn, size_t len)
+{
+    char *body = conn.rx + conn.headerLen;
+    size_t available = conn.rxLen - conn.headerLen;
+    if (len > available)
+        len = available;
+    memmove(body, body + len, available - len);
+    conn.rxLen -= len;
+    conn.bodyReceived += len;
+}
+
+void AsyncHttpServer::finishRequest(Connection &conn)
+{
+    bindRequest(conn);
+    if (router)
+        router->handle(conn.route);
+    current = nullptr;
+
+    if (!conn.responded)
+        sendError(conn, 500, "No response from handler");
+
+    // Remove this request from rx; anything left is a pipelined request
+    size_t bodyLeft = conn.contentLength > conn.bodyReceived ? conn.contentLength - conn.bodyReceived : 0;
+    size_t used = conn.headerLen + bodyLeft;
+    if (used > conn.rxLen)
+        used = conn.rxLen;
+    memmove(conn.rx, conn.rx + used, conn.rxLen - used);
+    conn.rxLen -= used;
+    conn.state = CONN_SENDING;
+}
+
+void AsyncHttpServer::bindRequest(Connection &conn)
+{
+    if (current == &conn)
+        return;
+    current = &conn;
+    currentUri = "";
+    currentUri.reserve(conn.pathLen);
+    for (size_t i = 0; i < conn.pathLen; i++)
+        currentUri += conn.path[i];
+    extraHeaders = "";
+}
+
+// ========================= REQUEST ACCESSORS =========================
+
+HttpMethod AsyncHttpServer::method() const
+{
+    return current ? current->method : HttpMethod::Get;
+}
+
+IPAddress AsyncHttpServer::remoteIP() const
+{
+    return current ? current->remoteIP : IPAddress();
+}
+
+// Looks up a urlencoded key; decodes the value into *value when given
+bool AsyncHttpServer::findArg(const char *data, size_t len, const char *name, String *value) const
+{
+    size_t nameLen = strlen(name);
+    const char *end = data + len;
+    const char *pair = data;
+    while (pair < end)
+    {
+        const char *amp = (const char *)memchr(pair, '&', end - pair);
+        const char *pairEnd = amp ? amp : end;
+        const char *eq = (const char *)memchr(pair, '=', pairEnd - pair);
+        const char *keyEnd = eq ? eq : pairEnd;
+
+        if ((size_t)(keyEnd - pair) == nameLen && memcmp(pair, name, nameLen) == 0)
+        {
+            if (value)
+            {
+                *value = "";
+                for (const char *p = eq ? eq + 1 : pairEnd; p < pairEnd; p++)
+                {
+                    if (*p == '+')
+                        *value += ' ';
+                    else if (*p == '%' && p + 2 < pairEnd && hexValue(p[1]) >= 0 && hexValue(p[2]) >= 0)
+                    {
+                        *value += (char)(hexValue(p[1]) * 16 + hexValue(p[2]));
+                        p += 2;
+                    }
+                    else
+                        *value += *p;
+                }
+            }
+            return true;
+        }
+        pair = pairEnd + 1;
+    }
+    return false;
+}
+
+bool AsyncHttpServer::hasArg(const char *name) const
+{
+    if (!current)
+        return false;
+    if (current->query && findArg(current->query, current->queryLen, name, nullptr))
+        return true;
+    return !current->isMultipart && findArg(current->rx + current->headerLen, current->contentLength, name, nullptr);
+}
+
+String AsyncHttpServer::arg(const char *name) const
+{
+    String value;
+    if (!current)
+        return value;
+    if (current->query && findArg(current->query, current->queryLen, name, &value))
+        return value;
+    if (!current->isMultipart)
+        findArg(current->rx + current->headerLen, current->contentLength, name, &value);
+    return value;
+}
+
+const char *AsyncHttpServer::body() const
+{
+    return current ? current->rx + current->headerLen : "";
+}
+
+size_t AsyncHttpServer::bodyLength() const
+{
+    return current && !current->isMultipart ? current->contentLength : 0;
+}
+
+const char *AsyncHttpServer::query() const
+{
+    return current && current->query ? current->query : "";
+}
+
+size_t AsyncHttpServer::queryLength() const
+{
+    return current ? current->queryLen : 0;
+}
+
+String AsyncHttpServer::header(const char *name) const
+{
+    String value;
+    const char *v;
+    size_t len;
+    if (findHeader(name, v, len))
+        value.concat(v, len);
+    return value;
+}
+
+bool AsyncHttpServer::findHeader(const char *name, const char *&value, size_t &valueLen) const
+{
+    if (!current)
+        return false;
+
+    size_t nameLen = strlen(name);
+    const char *cursor = (const char *)memchr(current->rx, '\n', current->headerLen) + 1;
+    const char *end = current->rx + current->headerLen - 2;
+    while (cursor < end)
+    {
+        const char *eol = findBytes(cursor, end - cursor + 2, "\r\n", 2);
+        if ((size_t)(eol - cursor) > nameLen && cursor[nameLen] == ':' && strncasecmp(cursor, name, nameLen) == 0)
+        {
+            const char *v = cursor + nameLen + 1;
+            while (v < eol && *v == ' ')
+                v++;
+            value = v;
+            valueLen = eol - v;
+            return true;
+        }
+        cursor = eol + 2;
+    }
+    return false;
+}
+
+// ========================= RESPONSES =========================
+
+const char *AsyncHttpServer::statusText(int code)
+{
+    switch (code)
+    {
+    case 200:
+        return "OK";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 413:
+        return "Payload Too Large";
+    case 429:
+        return "Too Many Requests";
+    case 431:
+        return "Request Header Fields Too Large";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 503:
+        return "Service Unavailable";
+    default:
+        return "";
+    }
+}
+
+void AsyncHttpServer::sendHeader(const char *name, const char *value)
+{
+    extraHeaders += name;
+    extraHeaders += ": ";
+    extraHeaders += value;
+    extraHeaders += "\r\n";
+}
+
+// contentLength HTTP_CHUNKED: the body comes from conn.source
+void AsyncHttpServer::startResponse(Connection &conn, int code, const char *contentType, size_t contentLength)
+{
+    char framing[48] = "";
+    if (contentLength != HTTP_CHUNKED)
+        snprintf(framing, sizeof(framing), "Content-Length: %u\r\n", (unsigned)contentLength);
+    else if (conn.http11)
+        strcpy(framing, "Transfer-Encoding: chunked\r\n");
+    else
+        conn.keepAlive = false; // an HTTP/1.0 body ends when the connection closes
+
+    char head[192];
+    int len = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\n%sConnection: %s\r\n",
+                       code, statusText(code), contentType, framing, conn.keepAlive ? "keep-alive" : "close");
+    conn.tx.reserve(len + extraHeaders.length() + 2 + (contentLength != HTTP_CHUNKED ? contentLength : 0));
+    conn.tx.concat(head, len);
+    conn.tx += extraHeaders;
+    conn.tx += "\r\n";
+    conn.responded = true;
+}
+
+void AsyncHttpServer::send(int code, const char *contentType, const String &content)
+{
+    send(code, contentType, content.c_str(), content.length());
+}
+
+void AsyncHttpServer::send(int code, const char *contentType, const char *content, size_t length)
+{
+    if (!current || current->responded)
+        return;
+    startResponse(*current, code, contentType, length);
+    current->tx.concat(content, length);
+
+    // Push what the socket will take now; the event loop sends the rest
+    flush(*current);
+}
+
+size_t AsyncHttpServer::streamFile(File &file, const char *contentType)
+{
+    if (!current || current->responded)
+        return 0;
+    size_t size = file.size();
+    startResponse(*current, 200, contentType, size);
+    current->file = file;
+    current->streaming = true;
+    return size;
+}
+
+bool AsyncHttpServer::sendChunked(int code, const char *contentType, HttpBodySource *source)
+{
+    if (!current || current->responded)
+        return false;
+    startResponse(*current, code, contentType, HTTP_CHUNKED);
+    current->source = source;
+    flush(*current);
+    return true;
+}
+
+// Frames the source's next piece into tx; the last chunk is empty
+void AsyncHttpServer::readChunk(Connection &conn)
+{
+    char data[HTTP_TX_CHUNK_SIZE];
+    size_t n = conn.source->read(data, sizeof(data));
+    if (n == 0 && conn.source->failed())
+    {
+        endSource(conn);
+        conn.keepAlive = false;
+        return;
+    }
+    if (conn.http11)
+    {
+        char size[12];
+        int len = snprintf(size, sizeof(size), "%X\r\n", (unsigned)n);
+        conn.tx.concat(size, len);
+    }
+    conn.tx.concat(data, n);
+    if (conn.http11)
+        conn.tx += "\r\n";
+    if (n == 0)
+        endSource(conn);
+}
+
+void AsyncHttpServer::endSource(Connection &conn)
+{
+    if (!conn.source)
+        return;
+    conn.source->end();
+    conn.source = nullptr;
+}
+
+void AsyncHttpServer::sendError(Connection &conn, int code, const char *message)
+{
+    if (!conn.responded)
+    {
+        extraHeaders = "";
+        startResponse(conn, code, "text/plain", strlen(message));
+        conn.tx += message;
+    }
+    conn.keepAlive = false; // the rest of the request is not read
+    conn.state = CONN_SENDING;
+}
+
+AsyncHttpServer::FlushResult AsyncHttpServer::flush(Connection &conn)
+{
+    for (;;)
+    {
+        size_t pending = conn.tx.length() - conn.txOffset;
+        if (pending > 0)
+        {
+            ssize_t sent = ::send(conn.fd, conn.tx.c_str() + conn.txOffset, pending, 0);
+            if (sent < 0)
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? FLUSH_PENDING : FLUSH_ERROR;
+            conn.txOffset += sent;
+            conn.lastActivity = millis();
+            if ((size_t)sent < pending)
+                return FLUSH_PENDING;
+            continue;
+        }
+
+        // Send buffer drained; keep the allocation for the next response
+        conn.tx = "";
+        conn.txOffset = 0;
+        if (conn.source)
+        {
+            readChunk(conn);
+            continue;
+        }
+        if (!conn.streaming)
+            return FLUSH_DONE;
+
+        uint8_t chunk[HTTP_TX_CHUNK_SIZE];
+        size_t position = conn.file.position();
+        size_t n = conn.file.read(chunk, sizeof(chunk));
+        if (n == 0)
+        {
+            conn.file.close();
+            conn.streaming = false;
+            return FLUSH_DONE;
+        }
+
+        ssize_t sent = ::send(conn.fd, chunk, n, 0);
+        if (sent < 0)
+        {
+            conn.file.seek(position);
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? FLUSH_PENDING : FLUSH_ERROR;
+        }
+        conn.lastActivity = millis();
+        if ((size_t)sent < n)
+        {
+            conn.file.seek(position + sent);
+            return FLUSH_PENDING;
+        }
+    }
+}
@@ -0,0 +1,206 @@
+#include "job_scheduler.h"
+
+#define SCHED_WHEEL_MASK (SCHED_WHEEL_SIZE - 1)
+#define SCHED_NO_JOB -1
+
+JobScheduler::JobScheduler() : jobCount(0), wheelTime(0), windowStartUs(0), idleUs(0)
+{
+    memset(jobs, 0, sizeof(jobs));
+    memset(wheel, SCHED_NO_JOB, sizeof(wheel));
+}
+
+int JobScheduler::add(const char *name, SchedulerJob job, uint32_t periodMs, JobMode mode, uint32_t firstDelayMs)
+{
+    if (jobCount >= SCHED_MAX_JOBS || periodMs == 0)
+        return -1;
+    if (jobCount == 0)
+    {
+        wheelTime = millis();
+        windowStartUs = micros();
+    }
+
+    int id = jobCount++;
+    Job &j = jobs[id];
+    j.run = job;
+    j.name = name;
+    j.periodMs = periodMs;
+    j.mode = mode;
+    j.deadline = millis() + firstDelayMs;
+    insert(id);
+    return id;
+}
+
+void JobScheduler::runNextIn(int id, uint32_t delayMs)
+{
+    if (id < 0 || id >= jobCount)
+        return;
+    jobs[id].nextDelay = delayMs;
+    jobs[id].overridden = true;
+}
+
+// Level n holds deadlines less than 64^(n+1) ms ahead, in slots of 64^n ms.
+// A slot of level n > 0 is moved down a level when the wheel reaches it.
+void JobScheduler::insert(int id)
+{
+    Job &j = jobs[id];
+    int32_t delta = (int32_t)(j.deadline - wheelTime);
+    uint32_t target = delta < 0 ? wheelTime : j.deadline; // overdue: next tick
+
+    int level = 0;
+    uint32_t span = SCHED_WHEEL_SIZE;
+    while (level < SCHED_WHEEL_LEVELS - 1 && (uint32_t)(target - wheelTime) >= span)
+    {
+        level++;
+        span <<= SCHED_WHEEL_BITS;
+    }
+    if ((uint32_t)(target - wheelTime) >= span)
+        target = wheelTime + span - 1; // beyond the wheel; re-cascaded from the top level
+
+    int slot = (target >> (level * SCHED_WHEEL_BITS)) & SCHED_WHEEL_MASK;
+    j.next = wheel[level][slot];
+    wheel[level][slot] = id;
+}
+
+void JobScheduler::cascade(int level, uint32_t tick)
+{
+    int slot = (tick >> (level * SCHED_WHEEL_BITS)) & SCHED_WHEEL_MASK;
+    int id = wheel[level][slot];
+    wheel[level][slot] = SCHED_NO_JOB;
+    while (id != SCHED_NO_JOB)
+    {
+        int next = jobs[id].next;
+        insert(id);
+        id = next;
+    }
+}
+
+void JobScheduler::runSlot(uint32_t tick, uint32_t now)
+{
+    int slot = tick & SCHED_WHEEL_MASK;
+    int id = wheel[0][slot];
+    wheel[0][slot] = SCHED_NO_JOB;
+    while (id != SCHED_NO_JOB)
+    {
+        Job &j = jobs[id];
+        int next = j.next;
+
+        uint32_t late = now - j.deadline;
+        j.totalLateMs += late;
+        if (late > j.maxLateMs)
+            j.maxLateMs = late;
+        j.runs++;
+
+        j.overridden = false;
+        uint32_t startUs = micros();
+        j.run(now);
+        uint32_t runUs = micros() - startUs;
+        if (runUs > j.maxRunUs)
+            j.maxRunUs = runUs;
+
+        uint32_t finished = millis();
+        if (j.overridden)
+        {
+            j.deadline = finished + j.nextDelay;
+        }
+        else if (j.mode == JobMode::FixedDelay)
+        {
+            j.deadline = finished + j.periodMs;
+        }
+        else
+        {
+            // Stay on the grid. If we fell behind, run once for the latest
+            // deadline that passed and count the earlier ones as missed.
+            j.deadline += j.periodMs;
+            if ((int32_t)(finished - j.deadline) > 0)
+            {
+                uint32_t skipped = (finished - j.deadline) / j.periodMs;
+                j.misses += skipped;
+                j.deadline += skipped * j.periodMs;
+            }
+        }
+        insert(id);
+        id = next;
+    }
+}
+
+void JobScheduler::run(uint32_t now)
+{
+    // A job that blocked for a while leaves a backlog of ticks; each empty
+    // one costs a couple of array reads
+    while ((int32_t)(now - wheelTime) >= 0)
+    {
+        uint32_t tick = wheelTime;
+        for (int level = SCHED_WHEEL_LEVELS - 1; level > 0; level--)
+        {
+            if ((tick & ((1UL << (level * SCHED_WHEEL_BITS)) - 1)) == 0)
+                cascade(level, tick);
+        }
+        // Advance first, so jobs rescheduled as overdue land in the next
+        // slot rather than the one being drained
+        wheelTime++;
+        runSlot(tick, now);
+    }
+}
+
+uint32_t JobScheduler::msUntilNext(uint32_t now) const
+{
+    uint32_t wait = UINT32_MAX;
+    for (int i = 0; i < jobCount; i++)
+    {
+        // Overdue jobs wait for the wheel's next tick
+        uint32_t due = (int32_t)(wheelTime - jobs[i].deadline) > 0 ? wheelTime : jobs[i].deadline;
+        int32_t delta = (int32_t)(due - now);
+        if (delta <= 0)
+            return 0;
+        if ((uint32_t)delta < wait)
+            wait = delta;
+    }
+    return wait;
+}
+
+void JobScheduler::idle(uint32_t now)
+{
+    uint32_t wait = msUntilNext(now);
+    if (wait == 0)
+        return;
+    uint32_t startUs = micros();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+    idleUs += micros() - startUs;
+}
+
+void JobScheduler::recordIdle(uint32_t idleTimeUs)
+{
+    idleUs += idleTimeUs;
+}
+
+float JobScheduler::getIdlePercent() const
+{
+    uint32_t elapsed = micros() - windowStartUs;
+    return elapsed ? idleUs * 100.0f / elapsed : 0.0f;
+}
+
+void JobScheduler::printStats() const
+{
+    Serial.printf("[SCHED] idle %.1f%%\n", getIdlePercent());
+    for (int i = 0; i < jobCount; i++)
+    {
+        const Job &j = jobs[i];
+        Serial.printf("[SCHED] %-8s %5lu runs, %3lu missed, late avg %.1f max %lu ms, longest run %lu us\n", j.name,
+                      (unsigned long)j.runs, (unsigned long)j.misses, j.runs ? (float)j.totalLateMs / j.runs : 0.0f,
+                      (unsigned long)j.maxLateMs, (unsigned long)j.maxRunUs);
+    }
+}
+
+void JobScheduler::resetStats()
+{
+    for (int i = 0; i < jobCount; i++)
+    {
+        jobs[i].runs = 0;
+        jobs[i].misses = 0;
+        jobs[i].totalLateMs = 0;
+        jobs[i].maxLateMs = 0;
+        jobs[i].maxRunUs = 0;
+    }
+    windowStartUs = micros();
+    idleUs = 0;
+}
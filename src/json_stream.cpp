@@ -0,0 +1,144 @@
+#include "json_stream.h"
+
+void JsonStream::start(char opening, char closing)
+{
+    this->opening = opening;
+    this->closing = closing;
+    stage = STAGE_OPEN;
+    hasItems = false;
+}
+
+size_t JsonStream::read(char *buf, size_t capacity)
+{
+    size_t len = 0;
+    if (stage == STAGE_OPEN && capacity > 0)
+    {
+        buf[len++] = opening;
+        stage = STAGE_ITEMS;
+    }
+
+    size_t itemsStart = len;
+    while (stage == STAGE_ITEMS)
+    {
+        size_t mark = len;
+        if (hasItems)
+        {
+            if (len + 1 >= capacity)
+                break;
+            buf[len++] = ',';
+        }
+
+        JsonWriter json(buf + len, capacity - len);
+        if (!writeItem(json))
+        {
+            len = mark;
+            stage = STAGE_CLOSE;
+            break;
+        }
+        if (!json.ok())
+        {
+            len = mark;
+            // An item larger than a whole chunk can never be sent. Skipping
+            // it would still end in valid JSON that silently lacks it, so
+            // the response is failed instead.
+            if (mark == itemsStart)
+                stage = STAGE_FAILED;
+            break;
+        }
+        len += json.length();
+        hasItems = true;
+        nextItem();
+    }
+
+    if (stage == STAGE_CLOSE && len < capacity)
+    {
+        buf[len++] = closing;
+        stage = STAGE_DONE;
+    }
+    return len;
+}
+
+void JsonStream::end()
+{
+    release();
+    stage = STAGE_DONE;
+    active = false;
+}
+
+// ========================= FILE LIST =========================
+
+bool FileListStream::begin(uint32_t offset, uint32_t limit)
+{
+    root = SPIFFS.open("/");
+    if (!root)
+        return false;
+    file = root.openNextFile();
+    for (uint32_t i = 0; i < offset && file; i++)
+        file = root.openNextFile();
+    remaining = limit ? limit : UINT32_MAX;
+    start('[', ']');
+    return true;
+}
+
+bool FileListStream::writeItem(JsonWriter &json)
+{
+    if (!file || remaining == 0)
+        return false;
+    json.beginObject().field("name", file.name()).field("size", file.size()).endObject();
+    return true;
+}
+
+void FileListStream::nextItem()
+{
+    file = root.openNextFile();
+    remaining--;
+}
+
+void FileListStream::release()
+{
+    file.close();
+    root.close();
+}
+
+// ========================= SENSOR TABLE =========================
+
+void SensorTableStream::begin(const SensorTable &table)
+{
+    snapshot = table;
+    content = CONTENT_VALUES;
+    index = 0;
+    start('{', '}');
+}
+
+void SensorTableStream::beginStats(const SensorTable &table, const SensorManager &from)
+{
+    begin(table);
+    content = CONTENT_STATS;
+    from.getStatsSnapshot(stats, snapshot.count);
+}
+
+void SensorTableStream::beginLatency(const SensorTable &table, const SensorManager &from)
+{
+    begin(table);
+    content = CONTENT_LATENCY;
+    from.getLatencySnapshot(latency, snapshot.count);
+}
+
+bool SensorTableStream::writeItem(JsonWriter &json)
+{
+    if (index >= snapshot.count)
+        return false;
+    switch (content)
+    {
+    case CONTENT_STATS:
+        SensorManager::writeSensorStats(json, snapshot, stats[index], index);
+        break;
+    case CONTENT_LATENCY:
+        SensorManager::writeSensorLatency(json, snapshot, latency[index], index);
+        break;
+    default:
+        SensorManager::writeSensor(json, snapshot, index);
+        break;
+    }
+    return true;
+}
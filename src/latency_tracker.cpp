@@ -0,0 +1,156 @@
+#include "latency_tracker.h"
+#include "sensor_ingest.h"
+#include "response_arena.h"
+
+void LatencyHistogram::record(uint32_t ms)
+{
+    uint8_t bucket = 0;
+    while (ms >> bucket && bucket < LATENCY_BUCKETS - 1)
+        bucket++;
+    buckets[bucket]++;
+    count++;
+    sumMs += ms;
+    if (ms > maxMs)
+        maxMs = ms;
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t pct) const
+{
+    if (count == 0)
+        return 0;
+    uint32_t target = ((uint64_t)count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen >= target)
+        {
+            uint32_t upper = (1UL << i) - 1;
+            return i == LATENCY_BUCKETS - 1 || upper > maxMs ? maxMs : upper;
+        }
+    }
+    return maxMs;
+}
+
+void ClockSync::update(uint32_t receivedAt, uint32_t sentAt, uint32_t rttMs)
+{
+    int32_t estimate = (int32_t)(receivedAt - sentAt - rttMs / 2);
+
+    if (samples == 0 || rttMs < bestRttMs)
+    {
+        // Take the first sample outright; move halfway towards one with the
+        // tightest round trip so far
+        offsetMs = samples == 0 ? estimate : offsetMs + (estimate - offsetMs) / 2;
+        bestRttMs = rttMs;
+    }
+    else if (rttMs <= (uint32_t)bestRttMs * 2 + CLOCK_SYNC_RTT_SLACK)
+    {
+        offsetMs += (estimate - offsetMs) / 8;
+        // Let the best round trip age so a route change can be followed
+        if (bestRttMs < 0xFFFF)
+            bestRttMs++;
+    }
+    if (samples < 0xFFFF)
+        samples++;
+}
+
+LatencyTracker::LatencyTracker()
+{
+    memset(ingestToPush, 0, sizeof(ingestToPush));
+    memset(lastPushedIngest, 0, sizeof(lastPushedIngest));
+    memset(pushGeneration, 0, sizeof(pushGeneration));
+}
+
+void LatencyTracker::resetSlot(int slot)
+{
+    IngestLatency &l = ingest[slot].beginWrite();
+    uint32_t generation = l.generation;
+    memset(&l, 0, sizeof(IngestLatency));
+    l.generation = generation + 1;
+    ingest[slot].endWrite();
+}
+
+void LatencyTracker::recordIngest(int slot, const SensorSample &sample, uint32_t ingestedAt)
+{
+    if (!(sample.timing & SAMPLE_TIMING_SENT_AT))
+        return; // client does not stamp its samples
+
+    IngestLatency &l = ingest[slot].beginWrite();
+    if (sample.timing & SAMPLE_TIMING_RTT)
+        l.clock.update(sample.receivedAt, sample.sentAt, sample.rttMs);
+    // Replayed samples would only measure the outage
+    if (l.clock.samples != 0 && !(sample.timing & SAMPLE_TIMING_REPLAY))
+    {
+        uint32_t capturedAt = (sample.timing & SAMPLE_TIMING_CAPTURED_AT) ? sample.capturedAt : sample.sentAt;
+        int32_t latency = (int32_t)(ingestedAt - (capturedAt + l.clock.offsetMs));
+        l.captureToIngest.record(latency > 0 ? latency : 0);
+    }
+    ingest[slot].endWrite();
+}
+
+uint32_t LatencyTracker::toLocalTime(int slot, const SensorSample &sample) const
+{
+    const ClockSync &clock = ingest[slot].writerView().clock;
+    if (!(sample.timing & SAMPLE_TIMING_CAPTURED_AT) || clock.samples == 0)
+        return sample.receivedAt;
+    return sample.capturedAt + clock.offsetMs;
+}
+
+void LatencyTracker::recordPush(const SensorTable &snapshot, uint32_t now)
+{
+    for (int i = 0; i < snapshot.count; i++)
+    {
+        uint32_t current = ingest[i].read(&IngestLatency::generation);
+        if (pushGeneration[i] != current)
+        {
+            // The slot went to a new sender since we last served it
+            memset(&ingestToPush[i], 0, sizeof(LatencyHistogram));
+            lastPushedIngest[i] = 0;
+            pushGeneration[i] = current;
+        }
+        uint32_t ingestedAt = snapshot.ingestedAt[i];
+        if (ingestedAt == lastPushedIngest[i])
+            continue; // unchanged since the last time it was served
+        lastPushedIngest[i] = ingestedAt;
+        ingestToPush[i].record(now - ingestedAt);
+    }
+}
+
+SensorLatency LatencyTracker::get(int slot) const
+{
+    IngestLatency copy;
+    ingest[slot].read(copy);
+
+    SensorLatency l;
+    l.clock = copy.clock;
+    l.captureToIngest = copy.captureToIngest;
+    // Still the previous sender's until recordPush() sees the new generation
+    if (pushGeneration[slot] == copy.generation)
+        l.ingestToPush = ingestToPush[slot];
+    else
+        memset(&l.ingestToPush, 0, sizeof(LatencyHistogram));
+    return l;
+}
+
+void LatencyTracker::writeHistogram(JsonWriter &json, const LatencyHistogram &histogram)
+{
+    json.beginObject()
+        .field("count", histogram.count)
+        .field("meanMs", histogram.count ? (uint32_t)(histogram.sumMs / histogram.count) : 0)
+        .field("p50Ms", histogram.percentile(50))
+        .field("p99Ms", histogram.percentile(99))
+        .field("maxMs", histogram.maxMs)
+        .key("buckets")
+        .beginArray();
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++)
+        json.value(histogram.buckets[i]);
+    json.endArray().endObject();
+}
+
+void LatencyTracker::writeJSON(JsonWriter &json, const SensorLatency &l)
+{
+    json.field("clockOffsetMs", l.clock.offsetMs).field("bestRttMs", (unsigned)l.clock.bestRttMs).key("captureToIngest");
+    writeHistogram(json, l.captureToIngest);
+    json.key("ingestToPush");
+    writeHistogram(json, l.ingestToPush);
+}
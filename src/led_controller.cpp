@@ -1,11 +1,23 @@
 #include "led_controller.h"
 #include "config.h"
 
-LEDController::LEDController() : pixel(NUM_PIXELS, RGB_LED_PIN, NEO_GRB + NEO_KHZ800)
+static const LedKeyframe SOLID_FRAMES[] = {{0, 255}};
+static const LedKeyframe BLINK_FRAMES[] = {{0, 255}, {LED_BLINK_PERIOD / 2, 0}};
+static const LedKeyframe BREATHE_FRAMES[] = {{0, 16}, {LED_BREATHE_PERIOD / 2, 255}};
+static const LedKeyframe FLASH_FRAMES[] = {{0, 255}, {LED_FLASH_DURATION, 0}};
+
+static const LedPattern SOLID = {SOLID_FRAMES, 1, 1000, false, true};
+static const LedPattern BLINK = {BLINK_FRAMES, 2, LED_BLINK_PERIOD, false, true};
+static const LedPattern BREATHE = {BREATHE_FRAMES, 2, LED_BREATHE_PERIOD, true, true};
+static const LedPattern FLASH = {FLASH_FRAMES, 2, LED_FLASH_DURATION, true, false};
+
+LEDController::LEDController()
+    : pixel(NUM_PIXELS, RGB_LED_PIN, NEO_GRB + NEO_KHZ800), overlayActive(false),
+      shownColor(0), shown(false), framesWritten(0), framesUnchanged(0)
 {
-    currentRed = 0;
-    currentGreen = 0;
-    currentBlue = 0;
+    memset(&base, 0, sizeof(base));
+    memset(&overlay, 0, sizeof(overlay));
+    base.pattern = &SOLID;
 }
 
 void LEDController::init()
@@ -13,53 +25,131 @@ void LEDController::init()
     pixel.begin();
     pixel.setBrightness(128);
     setDisconnectedIndicator();
+    update(millis());
 }
 
-void LEDController::setColor(int red, int green, int blue)
+void LEDController::start(Animation &animation, const LedPattern &pattern, int red, int green, int blue)
+{
+    animation.pattern = &pattern;
+    animation.red = red;
+    animation.green = green;
+    animation.blue = blue;
+    animation.startedAt = millis();
+}
+
+// Re-requesting the running pattern keeps its phase, so callers may repeat
+// an indicator every loop without restarting a blink
+void LEDController::setBase(const LedPattern &pattern, int red, int green, int blue)
+{
+    if (base.pattern == &pattern && base.red == red && base.green == green && base.blue == blue)
+        return;
+    start(base, pattern, red, green, blue);
+}
+
+int LEDController::levelAt(const LedPattern &pattern, uint32_t elapsed)
+{
+    if (pattern.looping)
+        elapsed %= pattern.periodMs;
+    else if (elapsed >= pattern.periodMs)
+        return -1;
+
+    int i = pattern.count - 1;
+    while (i > 0 && pattern.frames[i].atMs > elapsed)
+        i--;
+    const LedKeyframe &from = pattern.frames[i];
+    if (!pattern.smooth)
+        return from.level;
+
+    // The last keyframe ramps back to the first one at the period boundary
+    bool wraps = i + 1 >= pattern.count;
+    uint32_t toAt = wraps ? pattern.periodMs : pattern.frames[i + 1].atMs;
+    int toLevel = wraps ? (pattern.looping ? pattern.frames[0].level : from.level) : pattern.frames[i + 1].level;
+    uint32_t span = toAt - from.atMs;
+    if (span == 0)
+        return from.level;
+    return from.level + (toLevel - from.level) * (int32_t)(elapsed - from.atMs) / (int32_t)span;
+}
+
+void LEDController::update(uint32_t now)
 {
-    currentRed = red;
-    currentGreen = green;
-    currentBlue = blue;
-    pixel.setPixelColor(0, pixel.Color(red, green, blue));
+    int level = levelAt(*base.pattern, now - base.startedAt);
+    int red = base.red * level / 255;
+    int green = base.green * level / 255;
+    int blue = base.blue * level / 255;
+
+    if (overlayActive)
+    {
+        int mix = levelAt(*overlay.pattern, now - overlay.startedAt);
+        if (mix < 0)
+        {
+            overlayActive = false;
+        }
+        else
+        {
+            red += (overlay.red - red) * mix / 255;
+            green += (overlay.green - green) * mix / 255;
+            blue += (overlay.blue - blue) * mix / 255;
+        }
+    }
+
+    // Each write holds the line for the whole strip; skip it if nothing changed
+    uint32_t color = pixel.Color(red, green, blue);
+    if (shown && color == shownColor)
+    {
+        framesUnchanged++;
+        return;
+    }
+    for (int i = 0; i < NUM_PIXELS; i++)
+        pixel.setPixelColor(i, color);
     pixel.show();
+    shownColor = color;
+    shown = true;
+    framesWritten++;
+}
+
+void LEDController::setColor(int red, int green, int blue)
+{
+    setBase(SOLID, red, green, blue);
 }
 
 void LEDController::setConnectingIndicator()
 {
-    static bool ledState = false;
-    ledState = !ledState;
-    pixel.setPixelColor(0, ledState ? pixel.Color(0, 0, 255) : pixel.Color(0, 0, 0));
-    pixel.show();
+    setBase(BLINK, 0, 0, 255);
 }
 
 void LEDController::setConnectedIndicator()
 {
-    pixel.setPixelColor(0, pixel.Color(0, 255, 0));
-    pixel.show();
+    setBase(SOLID, 0, 255, 0);
 }
 
 void LEDController::setDisconnectedIndicator()
 {
-    pixel.setPixelColor(0, pixel.Color(255, 0, 0));
-    pixel.show();
+    setBase(SOLID, 255, 0, 0);
+}
+
+void LEDController::setRetryIndicator()
+{
+    setBase(BREATHE, 255, 0, 0);
 }
 
 void LEDController::setSensorIndicator(int sensorValue)
 {
     if (sensorValue == 1)
-    {
-        pixel.setPixelColor(0, pixel.Color(0, 0, 255)); // Blue
-    }
+        setBase(SOLID, 0, 0, 255); // Blue
     else
-    {
-        pixel.setPixelColor(0, pixel.Color(255, 0, 0)); // Red
-    }
-    pixel.show();
+        setBase(SOLID, 255, 0, 0); // Red
+}
+
+void LEDController::flashTouch()
+{
+    // A new touch restarts the flash
+    start(overlay, FLASH, 255, 255, 255);
+    overlayActive = true;
 }
 
 void LEDController::getCurrentColor(int &red, int &green, int &blue)
 {
-    red = currentRed;
-    green = currentGreen;
-    blue = currentBlue;
-}
\ No newline at end of file
+    red = base.red;
+    green = base.green;
+    blue = base.blue;
+}
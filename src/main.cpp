@@ -1,65 +1,345 @@
 #include <Arduino.h>
-#include <WebServer.h>
 #include <HTTPClient.h>
 
 // Project headers
 #include "config.h"
+#include "http_server.h"
 #include "sensor_manager.h"
+#include "sensor_ingest.h"
 #include "web_handlers.h"
 #include "wifi_manager.h"
 #include "filesystem_utils.h"
+#include "send_rate_controller.h"
+#include "sample_buffer.h"
+#include "power_manager.h"
+#include "slot_scheduler.h"
+#include "uplink_router.h"
+#include "gateway_uplink.h"
+#include "multicast_publisher.h"
+#include "uart_export.h"
+#include "led_controller.h"
+#include "job_scheduler.h"
+#include "heap_monitor.h"
 
 // ========================= GLOBAL OBJECTS =========================
 SensorManager sensorManager;
-WebServer server(WEB_SERVER_PORT);
-WebHandlers webHandlers(&server, &sensorManager);
+SensorIngest sensorIngest;
+AsyncHttpServer server(WEB_SERVER_PORT);
+WebHandlers webHandlers(&server, &sensorManager, &sensorIngest);
 WiFiManager wifiManager;
+LEDController ledController; // status LED, animated from loop()
+#if GATEWAY_ENABLED
+GatewayUplink gatewayUplink; // one frame of table changes per tick, pushed upstream
+#endif
+#if MULTICAST_ENABLED
+MulticastPublisher multicastPublisher; // table datagrams for any number of LAN listeners
+#endif
+#if UART_EXPORT_ENABLED
+UartExport uartExport(Serial2); // binary table frames for a serially attached host
+#endif
 
 // ========================= CLIENT CONFIGURATION =========================
-const char *SERVER_URL = "http://192.168.1.200/sensor";
-const unsigned long SEND_INTERVAL = 200; // ms
+// Aggregators in order of preference; later entries take over when earlier ones fail
+const char *const UPLINK_HOSTS[] = {"192.168.1.200", "192.168.1.201"};
+const unsigned long SEND_INTERVAL = 200; // ms, fastest periodic send
 int clientId = 0;                        // Will be set via web interface
+SendRateController sendRate(SEND_INTERVAL);
+SampleBuffer offlineBuffer; // readings taken while the uplink is down
+PowerManager powerManager((PowerMode)POWER_MODE);
+SlotScheduler slotScheduler; // transmit slot handed out by the aggregator
+UplinkRouter uplinkRouter(UPLINK_HOSTS, sizeof(UPLINK_HOSTS) / sizeof(UPLINK_HOSTS[0]));
+JobScheduler scheduler; // runs everything in loop() except touch dispatch
+HeapMonitor heapMonitor; // fragmentation trend, served at /heap
+int sendJobId = -1;
 
 // ========================= TIMING VARIABLES =========================
 unsigned long lastSensorSend = 0;
-unsigned long lastLocalDisplay = 0;
+unsigned long lastBatchSend = 0;
+unsigned long lastRoundTrip = 0; // reported to the aggregator for clock sync
+bool haveRoundTrip = false;
+uint32_t uplinkSeq = 0;       // lets aggregators drop duplicates from failover and retries
+uint32_t pendingBatchSeq = 0; // reused until the current backlog batch is acknowledged
+size_t pendingBatchCount = 0;
 
 // ========================= HELPER FUNCTIONS =========================
 
-void sendSensorDataToServer()
+// Appends a fixed-point channel value; a JSON number is also a valid form value
+void appendFixed(String &out, int32_t value, uint8_t decimals)
 {
-  int touchValue = sensorManager.getLocalTouchValue();
-  float batteryVoltage = sensorManager.getLocalBatteryVoltage();
-  float batteryPercent = sensorManager.getLocalBatteryPercent();
+  char text[16];
+  JsonWriter(text, sizeof(text)).fixed(value, decimals);
+  out += text;
+}
+
+void bufferSample(const int32_t (&channels)[SENSOR_CHANNEL_COUNT], unsigned long capturedAt)
+{
+  BufferedSample sample;
+  sample.capturedAt = capturedAt;
+  for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    sample.channels[ch] = channels[ch];
+  offlineBuffer.add(sample);
+}
+
+// POSTs body to the healthiest aggregator and fails over down the list on
+// timeouts and 5xx (503 included, though a busy aggregator is not counted as
+// down). With hedging on, the first attempt only gets
+// UPLINK_HEDGE_BUDGET before the next aggregator is tried. Feeds the rate
+// controller and slot scheduler; returns the final HTTP code.
+int postToAggregator(const char *path, const String &body, String &reply)
+{
+  int index = uplinkRouter.primary(millis());
+  int responseCode = -1;
+  unsigned long roundTrip = 0;
+  unsigned long sentAt = 0;
+
+  for (size_t attempt = 0; index >= 0 && attempt < uplinkRouter.size(); attempt++)
+  {
+    bool hedged = UPLINK_HEDGE_ENABLED && attempt == 0 && uplinkRouter.size() > 1;
+    uint16_t timeout = hedged ? UPLINK_HEDGE_BUDGET : UPLINK_HTTP_TIMEOUT;
+
+    HTTPClient http;
+    http.setConnectTimeout(timeout);
+    http.setTimeout(timeout);
+    http.begin(String("http://") + uplinkRouter.getHost(index) + path);
+    http.addHeader("Content-Type", "application/x-www-form-urlencoded");
 
-  HTTPClient http;
-  http.begin(SERVER_URL);
-  http.addHeader("Content-Type", "application/x-www-form-urlencoded");
+    sentAt = millis();
+    responseCode = http.POST(body + "&sentAt=" + String(sentAt));
+    roundTrip = millis() - sentAt;
+    reply = responseCode > 0 ? http.getString() : String();
+    http.end();
 
-  String postData = "clientId=" + String(clientId) +
-                    "&touch=" + String(touchValue) +
-                    "&batteryVoltage=" + String(batteryVoltage, 2) +
-                    "&batteryPercent=" + String(batteryPercent, 1);
-  int responseCode = http.POST(postData);
+    uplinkRouter.onResult(index, UplinkRouter::classify(responseCode, hedged, roundTrip), roundTrip, millis());
+    if (responseCode > 0 && responseCode < 500)
+      break; // answered; a 4xx would fail the same way elsewhere
+
+    Serial.printf("[SEND ERROR] %s: %d %s\n", uplinkRouter.getHost(index), responseCode, HTTPClient::errorToString(responseCode).c_str());
+    index = uplinkRouter.next(index, millis());
+  }
 
+  int backpressure = responseCode > 0 ? SendRateController::parseBackpressure(reply) : -1;
+  sendRate.onResult(responseCode, roundTrip, WiFi.RSSI(), backpressure);
   if (responseCode == 200)
   {
-    Serial.printf("[SEND] ID: %d, Touch: %d, Battery: %.2fV (%.1f%%)\n", clientId, touchValue, batteryVoltage, batteryPercent);
+    slotScheduler.onAck(reply, sentAt, roundTrip);
+    lastRoundTrip = roundTrip;
+    haveRoundTrip = true;
   }
   else
   {
-    Serial.printf("[SEND ERROR] %d: %s\n", responseCode, http.errorToString(responseCode).c_str());
+    slotScheduler.onFailure();
+  }
+  return responseCode;
+}
+
+// capturedAt is the millis() timestamp at which the channels were read.
+// Returns false if no aggregator accepted the sample.
+bool sendSensorDataToServer(const int32_t (&channels)[SENSOR_CHANNEL_COUNT], unsigned long capturedAt)
+{
+  String postData = "clientId=" + String(clientId);
+  for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+  {
+    postData += '&';
+    postData += SENSOR_CHANNEL_INFO[ch].key;
+    postData += '=';
+    appendFixed(postData, channels[ch], SENSOR_CHANNEL_INFO[ch].decimals);
+  }
+  postData += "&capturedAt=" + String(capturedAt) + "&seq=" + String(++uplinkSeq);
+  if (haveRoundTrip)
+    postData += "&rtt=" + String(lastRoundTrip);
+
+  String reply;
+  int responseCode = postToAggregator("/sensor", postData, reply);
+  if (responseCode != 200)
+  {
+    Serial.printf("[SEND] Not delivered (%d), next in %lu ms\n", responseCode, (unsigned long)sendRate.getInterval());
+    return false;
+  }
+
+  int touchValue = channels[SENSOR_CHANNEL_Touch];
+  float batteryVoltage = sensorChannelToFloat(SENSOR_CHANNEL_BatteryVoltage, channels[SENSOR_CHANNEL_BatteryVoltage]);
+  float batteryPercent = sensorChannelToFloat(SENSOR_CHANNEL_BatteryPercent, channels[SENSOR_CHANNEL_BatteryPercent]);
+  powerManager.onSent(millis(), touchValue, batteryPercent);
+  Serial.printf("[SEND] ID: %d, Touch: %d, Battery: %.2fV (%.1f%%)\n", clientId, touchValue, batteryVoltage, batteryPercent);
+  if (slotScheduler.getSendCount() % 100 == 0)
+    Serial.printf("[TDMA] slot %d, %lu sends, %lu retries, avg ack %lu ms\n", slotScheduler.getSlot(),
+                  (unsigned long)slotScheduler.getSendCount(), (unsigned long)slotScheduler.getRetryCount(),
+                  (unsigned long)slotScheduler.getAverageAckMs());
+  return true;
+}
+
+// Replays one batch of buffered samples, oldest first
+void sendBufferedBatch()
+{
+  // A retried batch keeps its sequence number and contents, so an aggregator
+  // that already applied it can drop the copy
+  BufferedSample batch[OFFLINE_BATCH_SIZE];
+  size_t count = offlineBuffer.peek(batch, pendingBatchCount ? pendingBatchCount : OFFLINE_BATCH_SIZE);
+  if (count == 0)
+    return;
+  if (count != pendingBatchCount)
+  {
+    pendingBatchSeq = ++uplinkSeq;
+    pendingBatchCount = count;
   }
 
-  http.end();
+  String postData = "clientId=" + String(clientId) + "&seq=" + String(pendingBatchSeq) + "&samples=";
+  postData.reserve(postData.length() + count * (11 + 8 * SENSOR_CHANNEL_COUNT) + 40);
+  for (size_t i = 0; i < count; i++)
+  {
+    if (i > 0)
+      postData += ';';
+    postData += String((unsigned long)batch[i].capturedAt);
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+      postData += ',';
+      appendFixed(postData, batch[i].channels[ch], SENSOR_CHANNEL_INFO[ch].decimals);
+    }
+  }
+  if (haveRoundTrip)
+    postData += "&rtt=" + String(lastRoundTrip);
+
+  String reply;
+  int responseCode = postToAggregator("/sensorBatch", postData, reply);
+  if (responseCode == 200)
+  {
+    offlineBuffer.commit(count);
+    pendingBatchCount = 0;
+    Serial.printf("[REPLAY] %u samples, %u left\n", (unsigned)count, (unsigned)offlineBuffer.size());
+  }
+  else
+  {
+    Serial.printf("[REPLAY ERROR] %d, %u buffered\n", responseCode, (unsigned)offlineBuffer.size());
+  }
 }
 
 void displayLocalSensorData()
 {
-  int touchValue = sensorManager.getLocalTouchValue();
-  float batteryVoltage = sensorManager.getLocalBatteryVoltage();
-  float batteryPercent = sensorManager.getLocalBatteryPercent();
-  Serial.printf("Local Touch: %d, Battery: %.2fV (%.1f%%)\n", touchValue, batteryVoltage, batteryPercent);
+  int32_t channels[SENSOR_CHANNEL_COUNT];
+  sensorManager.readLocalChannels(channels);
+  String line = "Local";
+  for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+  {
+    line += ' ';
+    line += SENSOR_CHANNEL_INFO[ch].key;
+    line += '=';
+    appendFixed(line, channels[ch], SENSOR_CHANNEL_INFO[ch].decimals);
+  }
+  Serial.println(line);
+}
+
+// ========================= SCHEDULED JOBS =========================
+
+void wifiJob(uint32_t)
+{
+  // WiFi events, reconnect timers and OTA
+  wifiManager.handleConnection();
+}
+
+void ingestJob(uint32_t)
+{
+  // Apply samples queued by the request handlers (server runs on its own task)
+  sensorIngest.drain(sensorManager);
+}
+
+#if GATEWAY_ENABLED
+void gatewayJob(uint32_t now)
+{
+  if (wifiManager.isConnected())
+    gatewayUplink.poll(now, sensorManager);
+}
+#endif
+#if MULTICAST_ENABLED
+void multicastJob(uint32_t now)
+{
+  if (wifiManager.isConnected())
+    multicastPublisher.poll(now, sensorManager);
+}
+#endif
+#if UART_EXPORT_ENABLED
+void uartExportJob(uint32_t now)
+{
+  uartExport.poll(now, sensorManager); // the wire does not depend on WiFi
+}
+#endif
+
+// Periodic send of the current state and the offline backlog. Runs again
+// when the next send can be due rather than on a fixed period.
+void sendJob(uint32_t now)
+{
+  unsigned long wait;
+  if (wifiManager.isConnected())
+  {
+    // Paced by the send rate controller and held to our TDMA slot once the
+    // aggregator has assigned one; in low-power mode sent only when the
+    // value changed or the heartbeat is due
+    bool periodicDue = slotScheduler.isDue(now, lastSensorSend, sendRate.getInterval());
+    int32_t channels[SENSOR_CHANNEL_COUNT];
+    if (periodicDue)
+      sensorManager.readLocalChannels(channels);
+    if (periodicDue && powerManager.isLowPower())
+      periodicDue = powerManager.isSendDue(now, channels[SENSOR_CHANNEL_Touch],
+                                           sensorChannelToFloat(SENSOR_CHANNEL_BatteryPercent, channels[SENSOR_CHANNEL_BatteryPercent]));
+    if (periodicDue)
+    {
+      unsigned long capturedAt = millis();
+      if (!sendSensorDataToServer(channels, capturedAt))
+        bufferSample(channels, capturedAt);
+      lastSensorSend = now;
+    }
+
+    // Drain the backlog at the same pace as live traffic
+    if (!offlineBuffer.isEmpty() && slotScheduler.isDue(now, lastBatchSend, sendRate.getInterval()))
+    {
+      sendBufferedBatch();
+      lastBatchSend = now;
+    }
+
+    unsigned long current = millis();
+    wait = slotScheduler.msUntilDue(current, lastSensorSend, sendRate.getInterval());
+    if (!offlineBuffer.isEmpty())
+    {
+      unsigned long batchWait = slotScheduler.msUntilDue(current, lastBatchSend, sendRate.getInterval());
+      if (batchWait < wait)
+        wait = batchWait;
+    }
+  }
+  else
+  {
+    // Keep sampling at the base rate while the link is down
+    if (now - lastSensorSend >= SEND_INTERVAL)
+    {
+      int32_t channels[SENSOR_CHANNEL_COUNT];
+      sensorManager.readLocalChannels(channels);
+      bufferSample(channels, millis());
+      lastSensorSend = now;
+    }
+    wait = SEND_INTERVAL - (millis() - lastSensorSend) % SEND_INTERVAL;
+  }
+  scheduler.runNextIn(sendJobId, wait ? wait : 1);
+}
+
+void ledJob(uint32_t now)
+{
+  ledController.update(now);
+}
+
+void displayJob(uint32_t)
+{
+  displayLocalSensorData();
+}
+
+void heapJob(uint32_t)
+{
+  heapMonitor.sample();
+}
+
+void metricsJob(uint32_t)
+{
+  scheduler.printStats();
+  scheduler.resetStats();
+  heapMonitor.printStats();
+  Serial.printf("[POWER] %s, %.2f mAh used since boot (model)\n", powerManager.getModeName(), powerManager.getConsumedMah());
 }
 
 bool initializeSystem()
@@ -78,22 +358,32 @@ bool initializeSystem()
     return false;
   }
 
+  offlineBuffer.begin();
+
   // Check filesystem contents
   FilesystemUtils::listFiles();
   FilesystemUtils::checkIndexFile();
 
-  // Initialize WiFi and web server
-  if (!wifiManager.init())
-  {
-    Serial.println("ERROR: WiFi initialization failed");
-    return false;
-  }
+  // The LED follows the WiFi state from here on
+  ledController.init();
+  wifiManager.setStatusLed(&ledController);
+
+  // Start connecting (non-blocking) and bring the web server up meanwhile;
+  // it listens on all interfaces and serves as soon as the link is ready
+  wifiManager.init();
 
   webHandlers.setupRoutes(clientId);
+  webHandlers.setHeapMonitor(&heapMonitor);
   server.begin();
+#if MULTICAST_ENABLED
+  multicastPublisher.begin();
+#endif
+#if UART_EXPORT_ENABLED
+  uartExport.begin();
+#endif
 
   Serial.println("=== System initialized successfully ===");
-  Serial.printf("Web server running on: http://%s\n", WiFi.localIP().toString().c_str());
+  Serial.printf("Web server listening on port %d\n", WEB_SERVER_PORT);
 
   return true;
 }
@@ -109,32 +399,77 @@ void setup()
       delay(1000); // Stop execution
   }
   sensorManager.begin(); // Initialize sensor pins
+
+  // Random start so a reboot does not land inside the aggregators' dedup window
+  uplinkSeq = esp_random();
+
+  // Touch edges end the loop's idle sleep in every power mode
+  powerManager.begin(TOUCH_PIN);
+  sensorManager.getTouchEvents().setWakeTask(powerManager.getLoopTask());
+
+  scheduler.add("wifi", wifiJob, SCHED_WIFI_INTERVAL, JobMode::FixedDelay);
+  scheduler.add("ingest", ingestJob, SCHED_INGEST_INTERVAL, JobMode::FixedRate);
+  sendJobId = scheduler.add("send", sendJob, SEND_INTERVAL, JobMode::FixedDelay);
+  scheduler.add("led", ledJob, LED_FRAME_INTERVAL, JobMode::FixedRate);
+  if (!powerManager.isLowPower())
+    scheduler.add("display", displayJob, SENSOR_UPDATE_INTERVAL, JobMode::FixedRate);
+#if GATEWAY_ENABLED
+  scheduler.add("gateway", gatewayJob, SCHED_GATEWAY_INTERVAL, JobMode::FixedRate);
+#endif
+#if MULTICAST_ENABLED
+  scheduler.add("mcast", multicastJob, MULTICAST_INTERVAL, JobMode::FixedRate);
+#endif
+#if UART_EXPORT_ENABLED
+  scheduler.add("uart", uartExportJob, UART_EXPORT_INTERVAL, JobMode::FixedRate);
+#endif
+  scheduler.add("heap", heapJob, SCHED_HEAP_INTERVAL, JobMode::FixedRate);
+  scheduler.add("metrics", metricsJob, SCHED_METRICS_INTERVAL, JobMode::FixedRate, SCHED_METRICS_INTERVAL);
 }
 
 void loop()
 {
-  unsigned long currentTime = millis();
-
-  // Handle WiFi connection and OTA
-  wifiManager.handleConnection();
-
-  // Handle web server requests (only when connected)
-  if (wifiManager.isConnected())
+  // Touch edges go out immediately, one POST per edge so short presses are not
+  // lost; while offline (or if the POST fails) they are buffered instead
+  bool online = wifiManager.isConnected();
+  TouchEventCapture &touchEvents = sensorManager.getTouchEvents();
+  TouchEvent touchEvent;
+  while (touchEvents.poll(touchEvent))
   {
-    server.handleClient();
-
-    // Send sensor data to central server
-    if (currentTime - lastSensorSend >= SEND_INTERVAL)
+    // Flash before the POST, which may take a while
+    if (touchEvent.level)
     {
-      sendSensorDataToServer();
-      lastSensorSend = currentTime;
+      ledController.flashTouch();
+      ledController.update(millis());
     }
+
+    // Convert the ISR's micros() stamp by age, which survives micros() wrap
+    unsigned long capturedAt = millis() - (micros() - touchEvent.timestampUs) / 1000;
+    int32_t channels[SENSOR_CHANNEL_COUNT];
+    sensorManager.readLocalChannels(channels);
+    channels[SENSOR_CHANNEL_Touch] = touchEvent.level; // the level at the edge, not now
+    if (online && sendSensorDataToServer(channels, capturedAt))
+      touchEvents.markSent();
+    else
+      bufferSample(channels, capturedAt);
+    lastSensorSend = millis();
   }
 
-  // Display local sensor data (every second)
-  if (currentTime - lastLocalDisplay >= 200)
+  scheduler.run(millis());
+
+  // Low-power clients sleep until the heartbeat or the next touch edge, but
+  // only while connected and with nothing left to deliver, and never past
+  // the next job's deadline
+  unsigned long now = millis();
+  if (powerManager.isLowPower() && online && offlineBuffer.isEmpty() && sensorIngest.pending() == 0)
+  {
+    uint32_t startUs = micros();
+    powerManager.idle(now, slotScheduler.msUntilDue(now, lastSensorSend, sendRate.getInterval()),
+                      scheduler.msUntilNext(now));
+    scheduler.recordIdle(micros() - startUs);
+  }
+  else
   {
-    displayLocalSensorData();
-    lastLocalDisplay = currentTime;
+    // Sleep until the next job is due
+    scheduler.idle(now);
   }
-}
\ No newline at end of file
+}
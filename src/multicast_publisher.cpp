@@ -0,0 +1,55 @@
+#include "multicast_publisher.h"
+#include <lwip/sockets.h>
+
+MulticastPublisher::MulticastPublisher()
+    : encoder(MULTICAST_BATTERY_DELTA, MULTICAST_FULL_REFRESH), fd(-1), lastPublishAt(0), datagramsSent(0), sendErrors(0)
+{
+}
+
+bool MulticastPublisher::begin()
+{
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        Serial.println("[MULTICAST] Failed to create socket");
+        return false;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    // Stay on the local network segment
+    uint8_t ttl = MULTICAST_TTL;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+    Serial.printf("[MULTICAST] Publishing to %s:%d every %d ms\n", MULTICAST_GROUP, MULTICAST_PORT, MULTICAST_INTERVAL);
+    return true;
+}
+
+void MulticastPublisher::poll(uint32_t now, const SensorManager &manager)
+{
+    if (fd < 0 || now - lastPublishAt < MULTICAST_INTERVAL)
+        return;
+    lastPublishAt = now;
+
+    SensorTable snapshot;
+    manager.getSnapshot(snapshot);
+    size_t len = encoder.encode(snapshot, now, frame);
+    if (len == 0)
+        return; // unchanged since the last datagram
+
+    struct sockaddr_in group;
+    memset(&group, 0, sizeof(group));
+    group.sin_family = AF_INET;
+    group.sin_port = htons(MULTICAST_PORT);
+    group.sin_addr.s_addr = inet_addr(MULTICAST_GROUP);
+
+    if (sendto(fd, frame, len, 0, (struct sockaddr *)&group, sizeof(group)) == (ssize_t)len)
+    {
+        datagramsSent++;
+    }
+    else
+    {
+        // Dropped datagram: listeners may now hold stale entries
+        sendErrors++;
+        encoder.requestFull();
+    }
+}
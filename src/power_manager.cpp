@@ -0,0 +1,165 @@
+#include "power_manager.h"
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <esp_pm.h>
+#include <esp_idf_version.h>
+#include <driver/gpio.h>
+
+// Idle draw per mode between sends, indexed by PowerMode
+static const float IDLE_MA[] = {POWER_MA_IDLE_ALWAYS_ON, POWER_MA_IDLE_MODEM_SLEEP, POWER_MA_IDLE_LIGHT_SLEEP};
+
+DutyCycle::DutyCycle(uint32_t heartbeatMs)
+    : heartbeatMs(heartbeatMs), lastSendAt(0), lastTouch(0), lastBatteryPercent(0), haveSent(false)
+{
+}
+
+bool DutyCycle::isSendDue(uint32_t now, int touchValue, float batteryPercent) const
+{
+    if (!haveSent || touchValue != lastTouch)
+        return true;
+    if (fabsf(batteryPercent - lastBatteryPercent) >= POWER_BATTERY_DELTA)
+        return true;
+    return now - lastSendAt >= heartbeatMs;
+}
+
+void DutyCycle::onSent(uint32_t now, int touchValue, float batteryPercent)
+{
+    lastSendAt = now;
+    lastTouch = touchValue;
+    lastBatteryPercent = batteryPercent;
+    haveSent = true;
+}
+
+uint32_t DutyCycle::idleBudget(uint32_t now) const
+{
+    if (!haveSent)
+        return 0;
+    uint32_t elapsed = now - lastSendAt;
+    return elapsed >= heartbeatMs ? 0 : heartbeatMs - elapsed;
+}
+
+PowerManager::PowerManager(PowerMode mode)
+    : mode(mode), cycle(POWER_HEARTBEAT_INTERVAL), loopTask(nullptr), wakePin(0), lightSleepActive(false),
+      lastAccountAt(0), awakeMs(0), idleMs(0), sendCount(0)
+{
+}
+
+void PowerManager::begin(uint8_t touchPin)
+{
+    loopTask = xTaskGetCurrentTaskHandle();
+    wakePin = touchPin;
+    lastAccountAt = millis();
+
+    if (mode == PowerMode::AlwaysOn)
+        return;
+
+    // Modem sleep keeps the association: the radio wakes for DTIM beacons
+    // and the AP buffers our frames in between
+    WiFi.setSleep(WIFI_PS_MAX_MODEM);
+
+    if (mode == PowerMode::LightSleep)
+    {
+#if CONFIG_PM_ENABLE
+        // Automatic light sleep from the idle task, aligned with the beacons
+#if ESP_IDF_VERSION_MAJOR >= 5
+        esp_pm_config_t pm = {};
+#elif CONFIG_IDF_TARGET_ESP32S3
+        esp_pm_config_esp32s3_t pm = {};
+#else
+        esp_pm_config_esp32_t pm = {}; // nodemcu-32s build in platformio.ini
+#endif
+        pm.max_freq_mhz = 240;
+        pm.min_freq_mhz = 80;
+        pm.light_sleep_enable = true;
+        lightSleepActive = esp_pm_configure(&pm) == ESP_OK;
+#endif
+        if (lightSleepActive)
+            esp_sleep_enable_gpio_wakeup();
+        else
+        {
+            Serial.println("[POWER] Light sleep unavailable in this build, using modem sleep");
+            mode = PowerMode::ModemSleep;
+        }
+    }
+
+    Serial.printf("[POWER] %s mode, heartbeat %u ms, est. %.1f mA average\n", getModeName(),
+                  (unsigned)POWER_HEARTBEAT_INTERVAL,
+                  estimateAverageMa(mode, POWER_HEARTBEAT_INTERVAL, POWER_MODEL_EVENTS_PER_HOUR));
+}
+
+void PowerManager::account(uint32_t now, bool idle)
+{
+    uint32_t elapsed = now - lastAccountAt;
+    lastAccountAt = now;
+    if (idle)
+        idleMs += elapsed;
+    else
+        awakeMs += elapsed;
+}
+
+bool PowerManager::isSendDue(uint32_t now, int touchValue, float batteryPercent) const
+{
+    return cycle.isSendDue(now, touchValue, batteryPercent);
+}
+
+void PowerManager::onSent(uint32_t now, int touchValue, float batteryPercent)
+{
+    cycle.onSent(now, touchValue, batteryPercent);
+    sendCount++;
+}
+
+void PowerManager::idle(uint32_t now, uint32_t holdMs, uint32_t limitMs)
+{
+    uint32_t budget = cycle.idleBudget(now);
+    if (holdMs > budget)
+        budget = holdMs;
+    if (budget > limitMs)
+        budget = limitMs;
+    if (mode == PowerMode::AlwaysOn || budget == 0)
+        return;
+
+    account(now, false);
+    if (lightSleepActive)
+    {
+        // Wake on the opposite level, or a held touch would wake us at once
+        int level = digitalRead(wakePin);
+        gpio_wakeup_enable((gpio_num_t)wakePin, level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+    // The touch ISR notifies this task; otherwise sleep out the budget
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(budget));
+    account(millis(), true);
+}
+
+float PowerManager::getConsumedMah() const
+{
+    float activeMaMs = (float)awakeMs * POWER_MA_AWAKE;
+    float idleMaMs = (float)idleMs * IDLE_MA[(int)mode];
+    float sendMaMs = (float)sendCount * POWER_SEND_ACTIVE_MS * (POWER_MA_SEND - POWER_MA_AWAKE);
+    return (activeMaMs + idleMaMs + sendMaMs) / 3600000.0f;
+}
+
+const char *PowerManager::modeName(PowerMode mode)
+{
+    switch (mode)
+    {
+    case PowerMode::ModemSleep:
+        return "modem-sleep";
+    case PowerMode::LightSleep:
+        return "light-sleep";
+    default:
+        return "always-on";
+    }
+}
+
+// Time-weighted average over one hour: each send costs POWER_SEND_ACTIVE_MS
+// at the send current, the rest of the hour is spent at the mode's idle draw
+float PowerManager::estimateAverageMa(PowerMode mode, uint32_t heartbeatMs, uint32_t eventsPerHour)
+{
+    const float hourMs = 3600000.0f;
+    float sends = (mode == PowerMode::AlwaysOn ? hourMs / SENSOR_UPDATE_INTERVAL : hourMs / heartbeatMs) + eventsPerHour;
+    float sendMs = sends * POWER_SEND_ACTIVE_MS;
+    if (sendMs > hourMs)
+        sendMs = hourMs;
+    float idleMa = mode == PowerMode::AlwaysOn ? POWER_MA_AWAKE : IDLE_MA[(int)mode];
+    return (sendMs * POWER_MA_SEND + (hourMs - sendMs) * idleMa) / hourMs;
+}
@@ -0,0 +1,277 @@
+#include "response_arena.h"
+#include <stdarg.h>
+
+ResponseArena::ResponseArena()
+    : used(0), highWater(0), overflows(0), writerOpen(false)
+{
+}
+
+void *ResponseArena::alloc(size_t size)
+{
+    size_t start = (used + 3) & ~(size_t)3;
+    if (writerOpen || start + size > sizeof(storage))
+    {
+        overflows++;
+        return nullptr;
+    }
+    used = start + size;
+    if (used > highWater)
+        highWater = used;
+    return storage + start;
+}
+
+const char *ResponseArena::format(const char *format, ...)
+{
+    if (writerOpen)
+    {
+        overflows++;
+        return "";
+    }
+    // Text needs no alignment, so it goes right after the last allocation
+    size_t capacity = sizeof(storage) - used;
+    char *text = storage + used;
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, capacity, format, args);
+    va_end(args);
+    if (len < 0 || (size_t)len >= capacity)
+    {
+        overflows++;
+        return "";
+    }
+    used += len + 1;
+    if (used > highWater)
+        highWater = used;
+    return text;
+}
+
+char *ResponseArena::open(size_t &capacity)
+{
+    if (writerOpen)
+    {
+        capacity = 0;
+        return nullptr;
+    }
+    writerOpen = true;
+    capacity = sizeof(storage) - used;
+    return storage + used;
+}
+
+void ResponseArena::close(size_t length, bool overflowed)
+{
+    writerOpen = false;
+    used += length;
+    if (used > highWater)
+        highWater = used;
+    if (overflowed)
+        overflows++;
+}
+
+void ResponseArena::reset()
+{
+    used = 0;
+    writerOpen = false;
+}
+
+// ========================= JSON WRITER =========================
+
+JsonWriter::JsonWriter(ResponseArena &arena)
+    : arena(&arena), len(0), overflowed(false), afterKey(false), depth(0), hasItems(0)
+{
+    buf = arena.open(capacity);
+    attached = buf != nullptr;
+    if (!buf || capacity == 0)
+    {
+        static char empty[1];
+        buf = empty;
+        capacity = 0;
+        overflowed = true;
+        return;
+    }
+    buf[0] = '\0';
+}
+
+JsonWriter::JsonWriter(char *buffer, size_t capacity)
+    : arena(nullptr), buf(buffer), capacity(capacity), len(0), overflowed(capacity == 0), attached(false),
+      afterKey(false), depth(0), hasItems(0)
+{
+    if (capacity > 0)
+        buf[0] = '\0';
+}
+
+// Keeps the text allocated until the arena is reset
+JsonWriter::~JsonWriter()
+{
+    if (attached)
+        arena->close(overflowed ? 0 : len + 1, overflowed);
+}
+
+void JsonWriter::put(char c)
+{
+    put(&c, 1);
+}
+
+void JsonWriter::put(const char *text, size_t length)
+{
+    // One byte stays free for the terminator
+    if (overflowed || len + length >= capacity)
+    {
+        overflowed = true;
+        return;
+    }
+    memcpy(buf + len, text, length);
+    len += length;
+    buf[len] = '\0';
+}
+
+void JsonWriter::separate()
+{
+    if (afterKey)
+    {
+        afterKey = false;
+        return;
+    }
+    uint32_t bit = 1UL << (depth & 31);
+    if (hasItems & bit)
+        put(',');
+    hasItems |= bit;
+}
+
+void JsonWriter::open(char bracket)
+{
+    separate();
+    put(bracket);
+    depth++;
+    hasItems &= ~(1UL << (depth & 31));
+}
+
+void JsonWriter::close(char bracket)
+{
+    if (depth > 0)
+        depth--;
+    put(bracket);
+}
+
+JsonWriter &JsonWriter::key(const char *name)
+{
+    value(name);
+    put(':');
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const char *text)
+{
+    separate();
+    put('"');
+    for (const char *p = text; *p; p++)
+    {
+        char c = *p;
+        if (c == '"' || c == '\\')
+        {
+            char escaped[2] = {'\\', c};
+            put(escaped, 2);
+        }
+        else if ((uint8_t)c < 0x20)
+        {
+            char escaped[7];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            put(escaped, 6);
+        }
+        else
+        {
+            put(c);
+        }
+    }
+    put('"');
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(long number)
+{
+    char text[24];
+    int n = snprintf(text, sizeof(text), "%ld", number);
+    separate();
+    put(text, n);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(unsigned long number)
+{
+    char text[24];
+    int n = snprintf(text, sizeof(text), "%lu", number);
+    separate();
+    put(text, n);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(float number, int decimals)
+{
+    char text[48];
+    int n = snprintf(text, sizeof(text), "%.*f", decimals, number);
+    if (n < 0 || (size_t)n >= sizeof(text))
+    {
+        overflowed = true;
+        return *this;
+    }
+    separate();
+    put(text, n);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(bool flag)
+{
+    separate();
+    if (flag)
+        put("true", 4);
+    else
+        put("false", 5);
+    return *this;
+}
+
+JsonWriter &JsonWriter::fixed(int32_t scaled, uint8_t decimals)
+{
+    // Digits are produced right to left, with the point inserted after `decimals` of them
+    char text[16];
+    char *p = text + sizeof(text);
+    uint32_t magnitude = scaled < 0 ? 0u - (uint32_t)scaled : (uint32_t)scaled;
+    for (int i = 0; magnitude > 0 || i <= decimals; i++)
+    {
+        if (i == decimals && decimals > 0)
+            *--p = '.';
+        *--p = '0' + magnitude % 10;
+        magnitude /= 10;
+    }
+    if (scaled < 0)
+        *--p = '-';
+    separate();
+    put(p, text + sizeof(text) - p);
+    return *this;
+}
+
+static void formatIp(uint32_t address, char (&text)[16])
+{
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (unsigned)(address & 0xFF), (unsigned)((address >> 8) & 0xFF),
+             (unsigned)((address >> 16) & 0xFF), (unsigned)(address >> 24));
+}
+
+JsonWriter &JsonWriter::ip(uint32_t address)
+{
+    char text[16];
+    formatIp(address, text);
+    return value(text);
+}
+
+JsonWriter &JsonWriter::ipKey(uint32_t address)
+{
+    char text[16];
+    formatIp(address, text);
+    return key(text);
+}
+
+JsonWriter &JsonWriter::raw(const char *json, size_t length)
+{
+    separate();
+    put(json, length);
+    return *this;
+}
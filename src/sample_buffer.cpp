@@ -0,0 +1,95 @@
+#include "sample_buffer.h"
+#include <SPIFFS.h>
+
+SampleBuffer::SampleBuffer() : head(0), count(0), spilledBytes(0), replayOffset(0), droppedCount(0)
+{
+}
+
+void SampleBuffer::begin()
+{
+    if (SPIFFS.exists(OFFLINE_SPILL_FILE))
+        SPIFFS.remove(OFFLINE_SPILL_FILE);
+    head = 0;
+    count = 0;
+    spilledBytes = 0;
+    replayOffset = 0;
+}
+
+void SampleBuffer::spillOldest(size_t n)
+{
+    size_t bytes = n * sizeof(BufferedSample);
+    File file;
+    if (spilledBytes + bytes <= OFFLINE_FLASH_MAX_BYTES)
+        file = SPIFFS.open(OFFLINE_SPILL_FILE, "a");
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const BufferedSample &sample = ring[(head + i) % OFFLINE_RAM_SAMPLES];
+        if (file && file.write((const uint8_t *)&sample, sizeof(sample)) == sizeof(sample))
+            spilledBytes += sizeof(sample);
+        else
+            droppedCount++; // flash budget exhausted or write failed
+    }
+    if (file)
+        file.close();
+
+    head = (head + n) % OFFLINE_RAM_SAMPLES;
+    count -= n;
+}
+
+void SampleBuffer::add(const BufferedSample &sample)
+{
+    if (count == OFFLINE_RAM_SAMPLES)
+        spillOldest(OFFLINE_RAM_SAMPLES / 2);
+
+    ring[(head + count) % OFFLINE_RAM_SAMPLES] = sample;
+    count++;
+}
+
+size_t SampleBuffer::peek(BufferedSample *out, size_t max)
+{
+    // Spilled samples are older, so a batch never mixes the two sources
+    if (replayOffset < spilledBytes)
+    {
+        File file = SPIFFS.open(OFFLINE_SPILL_FILE, "r");
+        if (!file || !file.seek(replayOffset))
+        {
+            // Spill file lost; skip what it held rather than stall replay
+            droppedCount += (spilledBytes - replayOffset) / sizeof(BufferedSample);
+            replayOffset = spilledBytes;
+        }
+        else
+        {
+            size_t available = (spilledBytes - replayOffset) / sizeof(BufferedSample);
+            size_t n = available < max ? available : max;
+            size_t read = file.read((uint8_t *)out, n * sizeof(BufferedSample));
+            file.close();
+            return read / sizeof(BufferedSample);
+        }
+    }
+
+    size_t n = count < max ? count : max;
+    for (size_t i = 0; i < n; i++)
+        out[i] = ring[(head + i) % OFFLINE_RAM_SAMPLES];
+    return n;
+}
+
+void SampleBuffer::commit(size_t n)
+{
+    if (replayOffset < spilledBytes)
+    {
+        replayOffset += n * sizeof(BufferedSample);
+        if (replayOffset >= spilledBytes)
+        {
+            SPIFFS.remove(OFFLINE_SPILL_FILE);
+            spilledBytes = 0;
+            replayOffset = 0;
+        }
+        return;
+    }
+
+    if (n > count)
+        n = count;
+    head = (head + n) % OFFLINE_RAM_SAMPLES;
+    count -= n;
+}
@@ -0,0 +1,63 @@
+#include "send_rate_controller.h"
+
+SendRateController::SendRateController(uint32_t minInterval)
+    : minIntervalMs(minInterval), intervalMs(minInterval), smoothedRttMs(0),
+      lastRssi(0), lastBackpressure(-1), backoffCount(0)
+{
+}
+
+uint32_t SendRateController::floorInterval() const
+{
+    uint32_t floor = minIntervalMs;
+    // Marginal links retry more at the MAC layer; give them more air time
+    if (lastRssi != 0 && lastRssi < RATE_WEAK_RSSI)
+        floor *= 2;
+    return floor;
+}
+
+void SendRateController::onResult(int httpCode, uint32_t rttMs, int8_t rssi, int backpressure)
+{
+    lastRssi = rssi;
+    lastBackpressure = backpressure;
+
+    // A rejected request (4xx other than 429) says nothing about the link
+    if (httpCode >= 400 && httpCode < 500 && httpCode != 429)
+        return;
+
+    bool failed = httpCode <= 0 || httpCode == 429 || httpCode >= 500;
+    if (!failed)
+        smoothedRttMs = smoothedRttMs == 0 ? rttMs : (smoothedRttMs * 7 + rttMs) / 8;
+
+    bool congested = failed ||
+                     backpressure >= RATE_BACKPRESSURE_LIMIT ||
+                     rttMs > RATE_RTT_TARGET * 2;
+
+    if (congested)
+    {
+        // Multiplicative decrease of the send rate
+        intervalMs = intervalMs * 2 > RATE_MAX_INTERVAL ? RATE_MAX_INTERVAL : intervalMs * 2;
+        backoffCount++;
+    }
+    else if (smoothedRttMs > RATE_RTT_TARGET)
+    {
+        // Queues are building; ease off gently
+        intervalMs = intervalMs + RATE_ADDITIVE_STEP > RATE_MAX_INTERVAL ? RATE_MAX_INTERVAL : intervalMs + RATE_ADDITIVE_STEP;
+    }
+    else
+    {
+        // Additive increase of the send rate
+        intervalMs = intervalMs > RATE_ADDITIVE_STEP ? intervalMs - RATE_ADDITIVE_STEP : 0;
+    }
+
+    uint32_t floor = floorInterval();
+    if (intervalMs < floor)
+        intervalMs = floor;
+}
+
+int SendRateController::parseBackpressure(const String &reply)
+{
+    int pos = reply.indexOf("bp=");
+    if (pos < 0)
+        return -1;
+    return reply.substring(pos + 3).toInt();
+}
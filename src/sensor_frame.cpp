@@ -0,0 +1,115 @@
+#include "sensor_frame.h"
+
+static uint8_t *put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+SensorFrameEncoder::SensorFrameEncoder(float batteryDelta, uint32_t fullRefreshMs)
+    : seq(0), lastFullAt(0), forceFull(true), fullRefreshMs(fullRefreshMs)
+{
+    memset(&lastSent, 0, sizeof(lastSent));
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        changeThreshold[ch] = SENSOR_CHANNEL_INFO[ch].change;
+    changeThreshold[SENSOR_CHANNEL_BatteryPercent] = sensorChannelFromFloat(SENSOR_CHANNEL_BatteryPercent, batteryDelta);
+}
+
+bool SensorFrameEncoder::hasChanged(const SensorTable &table, int slot) const
+{
+    int previous = lastSent.find(table.ip[slot]);
+    if (previous < 0)
+        return true;
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        int32_t delta = table.channels[ch][slot] - lastSent.channels[ch][previous];
+        if (changeThreshold[ch] > 0 && (delta >= changeThreshold[ch] || -delta >= changeThreshold[ch]))
+            return true;
+    }
+    return strncmp(table.clientId[slot], lastSent.clientId[previous], SENSOR_CLIENT_ID_LEN) != 0;
+}
+
+void SensorFrameEncoder::remember(const SensorTable &table, int slot, int into)
+{
+    lastSent.ip[into] = table.ip[slot];
+    lastSent.ingestedAt[into] = table.ingestedAt[slot];
+    lastSent.sampleTime[into] = table.sampleTime[slot];
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        lastSent.channels[ch][into] = table.channels[ch][slot];
+    memcpy(lastSent.clientId[into], table.clientId[slot], SENSOR_CLIENT_ID_LEN);
+}
+
+size_t SensorFrameEncoder::encodeEntry(const SensorTable &table, int slot, uint32_t now, uint8_t *out)
+{
+    uint32_t age = now - table.ingestedAt[slot];
+    size_t idLen = strnlen(table.clientId[slot], SENSOR_CLIENT_ID_LEN);
+
+    uint8_t *p = put32(out, table.ip[slot]);
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        p = put16(p, (uint16_t)table.channels[ch][slot]); // low 16 bits; signed channels decode as i16
+    p = put16(p, age > 0xFFFF ? 0xFFFF : age);
+    *p++ = idLen;
+    memcpy(p, table.clientId[slot], idLen);
+    return p + idLen - out;
+}
+
+size_t SensorFrameEncoder::encode(const SensorTable &table, uint32_t now, uint8_t *out)
+{
+    // A sender missing from the table (cleared) can only be conveyed by a full frame
+    bool full = forceFull || now - lastFullAt >= fullRefreshMs || table.count < lastSent.count;
+    for (int i = 0; !full && i < lastSent.count; i++)
+        full = table.find(lastSent.ip[i]) < 0;
+
+    uint8_t *p = out + SENSOR_FRAME_HEADER_SIZE;
+    uint8_t count = 0;
+    bool sent[MAX_TRACKED_SENSORS];
+    for (int i = 0; i < table.count; i++)
+    {
+        sent[i] = full || hasChanged(table, i);
+        if (!sent[i])
+            continue;
+        p += encodeEntry(table, i, now, p);
+        count++;
+    }
+    if (count == 0 && !full)
+        return 0;
+
+    // Remember what the receivers now hold
+    if (full)
+    {
+        lastSent = table;
+        lastFullAt = now;
+        forceFull = false;
+    }
+    else
+    {
+        for (int i = 0; i < table.count; i++)
+        {
+            if (!sent[i])
+                continue;
+            int previous = lastSent.find(table.ip[i]);
+            if (previous < 0 && lastSent.count < MAX_TRACKED_SENSORS)
+                previous = lastSent.count++;
+            if (previous >= 0)
+                remember(table, i, previous);
+        }
+    }
+
+    uint8_t *h = put16(out, SENSOR_FRAME_MAGIC);
+    *h++ = SENSOR_FRAME_VERSION;
+    *h++ = full ? SENSOR_FRAME_FULL : 0;
+    h = put32(h, ++seq);
+    h = put32(h, now);
+    *h = count;
+    return p - out;
+}
@@ -0,0 +1,38 @@
+#include "sensor_ingest.h"
+
+SensorIngest::SensorIngest() : acceptedCount(0), droppedCount(0), appliedCount(0)
+{
+}
+
+bool SensorIngest::push(const SensorSample &sample)
+{
+    if (!queue.push(sample))
+    {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    acceptedCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t SensorIngest::drain(SensorManager &manager, size_t maxSamples)
+{
+    SensorSample batch[INGEST_BATCH_SIZE];
+    size_t total = 0;
+
+    while (total < maxSamples)
+    {
+        size_t n = 0;
+        while (n < INGEST_BATCH_SIZE && total + n < maxSamples && queue.pop(batch[n]))
+            n++;
+        if (n == 0)
+            break;
+
+        // One seqlock write section per batch keeps reader retries rare
+        manager.applySamples(batch, n);
+        total += n;
+    }
+
+    appliedCount += total;
+    return total;
+}
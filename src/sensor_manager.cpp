@@ -1,7 +1,7 @@
 #include "sensor_manager.h"
+#include "sensor_ingest.h"
 #include <WiFi.h>
 
-#define TOUCH_PIN 13
 #define BATTERY_PIN 34
 #define TOUCH_THRESHOLD 40
 #define VCC 3.3f
@@ -9,88 +9,84 @@
 #define R2 10000.0f             // Adjust as per your voltage divider
 #define CALIBRATION_FACTOR 1.0f // Adjust as needed
 
-void SensorManager::updateSensorData(const String &senderIP, const String &clientId, int touchValue, float batteryVoltage, float batteryPercent)
+int SensorManager::findOrAddSlot(SensorTable &t, uint32_t ip)
 {
-    sensorDataMap[senderIP] = {clientId, touchValue, batteryVoltage, batteryPercent};
+    int slot = t.find(ip);
+    if (slot >= 0)
+        return slot;
+    if (t.count >= MAX_TRACKED_SENSORS)
+        return -1;
+
+    slot = t.count++;
+    t.ip[slot] = ip;
+    t.ingestedAt[slot] = 0;
+    t.sampleTime[slot] = 0;
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        t.channels[ch][slot] = 0;
+    memset(t.clientId[slot], 0, SENSOR_CLIENT_ID_LEN);
+    return slot;
 }
 
-String SensorManager::getSensorDataJSON() const
+void SensorManager::applySamples(const SensorSample *samples, size_t count)
 {
-    String json = "{";
-    bool first = true;
-    for (const auto &pair : sensorDataMap)
+    uint32_t now = millis();
+    SensorTable &t = table.beginWrite();
+    for (size_t i = 0; i < count; i++)
     {
-        if (!first)
-            json += ",";
-        json += "\"" + pair.first + "\":{";
-        json += "\"clientId\":\"" + pair.second.clientId + "\",";
-        json += "\"touch\":" + String(pair.second.touchValue) + ",";
-        json += "\"batteryVoltage\":" + String(pair.second.batteryVoltage, 2) + ",";
-        json += "\"batteryPercent\":" + String(pair.second.batteryPercent, 1);
-        json += "}";
-        first = false;
+        const SensorSample &sample = samples[i];
+        uint8_t before = t.count;
+        int slot = findOrAddSlot(t, sample.ip);
+        if (slot < 0)
+            continue; // table full, drop unknown sender
+        bool isNew = t.count != before;
+        if (isNew)
+        {
+            latency.resetSlot(slot);
+            stats.resetSlot(slot);
+        }
+        latency.recordIngest(slot, sample, now);
+        stats.recordArrival(slot, sample);
+
+        // Replayed batches can arrive after fresher live samples; keep the newest
+        uint32_t sampleTime = latency.toLocalTime(slot, sample);
+        if (!isNew && (int32_t)(sampleTime - t.sampleTime[slot]) < 0)
+            continue;
+
+        t.sampleTime[slot] = sampleTime;
+        t.ingestedAt[slot] = now;
+        memcpy(t.clientId[slot], sample.clientId, SENSOR_CLIENT_ID_LEN);
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+            t.channels[ch][slot] = sample.channels[ch];
+        stats.recordValue(slot, sample.channels, sampleTime);
     }
-    json += "}";
-    return json;
+    table.endWrite();
 }
 
-const std::map<String, SensorData> &SensorManager::getAllSensorData() const
+void SensorManager::getSnapshot(SensorTable &out) const
 {
-    return sensorDataMap;
+    table.read(out);
 }
 
-void SensorManager::clearSensorData()
+void SensorManager::recordDashboardPush(const SensorTable &snapshot)
 {
-    sensorDataMap.clear();
+    latency.recordPush(snapshot, millis());
 }
 
-bool SensorManager::hasSensorData() const
+void SensorManager::clearSensorData()
 {
-    return !sensorDataMap.empty();
+    table.beginWrite().count = 0;
+    table.endWrite();
 }
 
-String SensorManager::getFormattedSensorData() const
+bool SensorManager::hasSensorData() const
 {
-    String result = "TP:";
-    bool first = true;
-    for (const auto &pair : sensorDataMap)
-    {
-        if (!first)
-            result += ",";
-        result += String(pair.second.touchValue) + "," + String(pair.second.batteryPercent, 1);
-        first = false;
-    }
-    return result;
-}
-
-String SensorManager::getFormattedSensorData(int minSensors) const
-{
-    String result = "TP:";
-    bool first = true;
-    int sensorCount = 0;
-    for (const auto &pair : sensorDataMap)
-    {
-        if (!first)
-            result += ",";
-        result += String(pair.second.touchValue) + "," + String(pair.second.batteryPercent, 1);
-        first = false;
-        sensorCount++;
-    }
-    while (sensorCount < minSensors)
-    {
-        if (!first)
-            result += ",";
-        result += "0,0.0";
-        first = false;
-        sensorCount++;
-    }
-    return result;
+    return table.read(&SensorTable::count) > 0;
 }
 
 int SensorManager::getLocalTouchValue() const
 {
-    int touchValue = digitalRead(TOUCH_PIN);
-    return touchValue;
+    // Debounced level tracked by the touch interrupt
+    return touchEvents.currentLevel();
 }
 
 float SensorManager::getLocalBatteryVoltage() const
@@ -106,9 +102,8 @@ float SensorManager::getLocalBatteryVoltage() const
     return averageVoltage;
 }
 
-float SensorManager::getLocalBatteryPercent() const
+static float batteryPercentFor(float voltage)
 {
-    float voltage = getLocalBatteryVoltage();
     float percent = (voltage - 3.2f) / (4.2f - 3.2f) * 100.0f;
     if (percent < 0)
         percent = 0;
@@ -117,25 +112,44 @@ float SensorManager::getLocalBatteryPercent() const
     return percent;
 }
 
-String SensorManager::getLocalSensorDataJSON() const
+float SensorManager::getLocalBatteryPercent() const
+{
+    return batteryPercentFor(getLocalBatteryVoltage());
+}
+
+// One reading of every channel, in schema order
+void SensorManager::readLocalChannels(int32_t (&out)[SENSOR_CHANNEL_COUNT]) const
+{
+    float voltage = getLocalBatteryVoltage(); // 100 ADC reads; shared by both battery channels
+    out[SENSOR_CHANNEL_Touch] = getLocalTouchValue();
+    out[SENSOR_CHANNEL_BatteryVoltage] = sensorChannelFromFloat(SENSOR_CHANNEL_BatteryVoltage, voltage);
+    out[SENSOR_CHANNEL_BatteryPercent] = sensorChannelFromFloat(SENSOR_CHANNEL_BatteryPercent, batteryPercentFor(voltage));
+}
+
+template <typename Writer>
+void SensorManager::writeLocalSensorData(Writer &out) const
 {
-    String json = "{";
-    String localIP = WiFi.localIP().toString();
-    json += "\"ip\":\"" + localIP + "\",";
     extern int clientId;
-    json += "\"clientId\":" + String(clientId) + ",";
-    int touchValue = getLocalTouchValue();
-    float batteryVoltage = getLocalBatteryVoltage();
-    float batteryPercent = getLocalBatteryPercent();
-    json += "\"touch\":" + String(touchValue) + ",";
-    json += "\"batteryVoltage\":" + String(batteryVoltage, 2) + ",";
-    json += "\"batteryPercent\":" + String(batteryPercent, 1);
-    json += "}";
-    return json;
+    int32_t channels[SENSOR_CHANNEL_COUNT];
+    readLocalChannels(channels);
+    out.beginObject(1 + SENSOR_LOCAL_FIELDS + SENSOR_CHANNEL_COUNT)
+        .key("ip")
+        .ip((uint32_t)WiFi.localIP())
+        .field("clientId", clientId);
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        out.key(SENSOR_CHANNEL_INFO[ch].key).fixed(channels[ch], SENSOR_CHANNEL_INFO[ch].decimals);
+    out.field("touchEdgesCaptured", touchEvents.getCapturedCount())
+        .field("touchEdgesDropped", touchEvents.getDroppedCount())
+        .field("touchEdgesSent", touchEvents.getSentCount())
+        .endObject();
 }
 
+template void SensorManager::writeLocalSensorData(JsonWriter &) const;
+template void SensorManager::writeLocalSensorData(BinaryWriter &) const;
+
 void SensorManager::begin()
 {
     pinMode(TOUCH_PIN, INPUT);
     pinMode(BATTERY_PIN, INPUT);
+    touchEvents.begin(TOUCH_PIN);
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "sensor_stats.h"
+#include "sensor_ingest.h"
+#include "response_arena.h"
+
+#define STATS_FLAG_ARRIVAL 0x01 // lastArrival and lastTransit are set
+#define STATS_FLAG_SEQ 0x02     // highestSeq is set
+#define STATS_FLAG_VALUE 0x04   // a value has been applied
+#define STATS_FLAG_PRESSED 0x08
+#define STATS_FLAG_PRESS_TIMED 0x10 // pressStart is known
+#define STATS_FLAG_BATTERY 0x20     // batteryAnchor is set
+
+void RunningStats::add(float x)
+{
+    count++;
+    float delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+}
+
+static void applyArrival(SensorStats &s, const SensorSample &sample)
+{
+    s.received++;
+
+    if (sample.timing & SAMPLE_TIMING_SEQ)
+    {
+        int32_t ahead = (int32_t)(sample.seq - s.highestSeq);
+        if (!(s.flags & STATS_FLAG_SEQ) || ahead >= DEDUP_WINDOW || -ahead >= DEDUP_WINDOW)
+        {
+            // First number, or the client restarted its counter. Clients
+            // start from a random number, so a restart can land anywhere.
+            s.highestSeq = sample.seq;
+            s.flags |= STATS_FLAG_SEQ;
+        }
+        else if (ahead > 0)
+        {
+            s.lost += ahead - 1;
+            s.highestSeq = sample.seq;
+        }
+        else if (ahead < 0)
+        {
+            s.reordered++;
+            if (s.lost > 0)
+                s.lost--;
+        }
+    }
+
+    if (sample.timing & SAMPLE_TIMING_REPLAY)
+        return;
+
+    int32_t transit = (int32_t)(sample.receivedAt - sample.sentAt);
+    if (s.flags & STATS_FLAG_ARRIVAL)
+    {
+        uint32_t interval = sample.receivedAt - s.lastArrival;
+        if (s.interArrival.count >= STATS_GAP_MIN_SAMPLES && interval > s.interArrival.mean * STATS_GAP_FACTOR)
+            s.timingGaps++;
+        s.interArrival.add(interval);
+
+        if (sample.timing & SAMPLE_TIMING_SENT_AT)
+        {
+            int32_t change = transit - s.lastTransit;
+            s.jitterMs += ((change < 0 ? -change : change) - s.jitterMs) / 16.0f;
+        }
+    }
+    s.lastArrival = sample.receivedAt;
+    s.lastTransit = transit;
+    s.flags |= STATS_FLAG_ARRIVAL;
+}
+
+static void applyValue(SensorStats &s, const int32_t (&channels)[SENSOR_CHANNEL_COUNT], uint32_t sampleTime)
+{
+    // A press already held at first contact is counted, but not timed
+    bool pressed = channels[SENSOR_CHANNEL_Touch] != 0;
+    bool wasPressed = s.flags & STATS_FLAG_PRESSED;
+    if (pressed && !wasPressed)
+    {
+        s.presses++;
+        s.pressStart = sampleTime;
+        s.flags |= STATS_FLAG_PRESSED;
+        if (s.flags & STATS_FLAG_VALUE)
+            s.flags |= STATS_FLAG_PRESS_TIMED;
+    }
+    else if (!pressed && wasPressed)
+    {
+        if (s.flags & STATS_FLAG_PRESS_TIMED)
+        {
+            uint32_t duration = sampleTime - s.pressStart;
+            s.pressTotalMs += duration;
+            if (duration > s.pressMaxMs)
+                s.pressMaxMs = duration;
+            s.pressesTimed++;
+        }
+        s.flags &= ~(STATS_FLAG_PRESSED | STATS_FLAG_PRESS_TIMED);
+    }
+    s.flags |= STATS_FLAG_VALUE;
+
+    int32_t battery = channels[SENSOR_CHANNEL_BatteryPercent];
+    if (!(s.flags & STATS_FLAG_BATTERY))
+    {
+        s.batteryAnchor = battery;
+        s.batteryAnchorAt = sampleTime;
+        s.flags |= STATS_FLAG_BATTERY;
+        return;
+    }
+    uint32_t span = sampleTime - s.batteryAnchorAt;
+    if (span < STATS_SLOPE_SPAN)
+        return;
+    float perHour = sensorChannelToFloat(SENSOR_CHANNEL_BatteryPercent, battery - s.batteryAnchor) * 3600000.0f / span;
+    s.batteryPerHour = s.slopeSamples == 0 ? perHour : s.batteryPerHour + (perHour - s.batteryPerHour) / 4.0f;
+    if (s.slopeSamples < 0xFFFF)
+        s.slopeSamples++;
+    s.batteryAnchor = battery;
+    s.batteryAnchorAt = sampleTime;
+}
+
+void SensorStatsTracker::resetSlot(int slot)
+{
+    memset(&stats[slot].beginWrite(), 0, sizeof(SensorStats));
+    stats[slot].endWrite();
+}
+
+void SensorStatsTracker::recordArrival(int slot, const SensorSample &sample)
+{
+    applyArrival(stats[slot].beginWrite(), sample);
+    stats[slot].endWrite();
+}
+
+void SensorStatsTracker::recordValue(int slot, const int32_t (&channels)[SENSOR_CHANNEL_COUNT], uint32_t sampleTime)
+{
+    applyValue(stats[slot].beginWrite(), channels, sampleTime);
+    stats[slot].endWrite();
+}
+
+SensorStats SensorStatsTracker::get(int slot) const
+{
+    SensorStats copy;
+    stats[slot].read(copy);
+    return copy;
+}
+
+void SensorStatsTracker::writeJSON(JsonWriter &json, const SensorStats &s)
+{
+    uint32_t expected = s.received + s.lost;
+
+    json.field("received", s.received)
+        .key("interArrival")
+        .beginObject()
+        .field("count", s.interArrival.count)
+        .key("meanMs")
+        .value(s.interArrival.mean, 1)
+        .key("stdDevMs")
+        .value(sqrtf(s.interArrival.variance()), 1)
+        .endObject()
+        .key("jitterMs")
+        .value(s.jitterMs, 1)
+        .field("lost", s.lost)
+        .field("reordered", s.reordered)
+        .key("lossPercent")
+        .value(expected ? s.lost * 100.0f / expected : 0.0f, 2)
+        .field("timingGaps", s.timingGaps);
+
+    json.key("touch")
+        .beginObject()
+        .field("presses", s.presses)
+        .field("pressed", (bool)(s.flags & STATS_FLAG_PRESSED))
+        .field("meanPressMs", s.pressesTimed ? s.pressTotalMs / s.pressesTimed : 0)
+        .field("maxPressMs", s.pressMaxMs)
+        .field("totalPressMs", s.pressTotalMs)
+        .endObject();
+
+    json.key("battery").beginObject().field("slopeSamples", (unsigned)s.slopeSamples);
+    if (s.slopeSamples > 0)
+    {
+        json.key("percentPerHour").value(s.batteryPerHour, 2);
+        // Time to empty at the current rate, while discharging
+        if (s.batteryPerHour < 0)
+        {
+            float percent = sensorChannelToFloat(SENSOR_CHANNEL_BatteryPercent, s.batteryAnchor);
+            json.key("hoursLeft").value(percent / -s.batteryPerHour, 1);
+        }
+    }
+    json.endObject();
+}
@@ -0,0 +1,91 @@
+#include "sensor_manager.h"
+
+// Serialization of the aggregator table. Nothing here touches the sensor
+// hardware, so it also builds for [env:native].
+
+#define SENSOR_CHANNEL_KEY_CHECK(id, key, decimals, change) \
+    static_assert(sizeof(key) - 1 <= SENSOR_CHANNEL_KEY_MAX, "Channel key " key " is too long");
+SENSOR_CHANNELS(SENSOR_CHANNEL_KEY_CHECK)
+#undef SENSOR_CHANNEL_KEY_CHECK
+
+int SensorTable::find(uint32_t address) const
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (ip[i] == address)
+            return i;
+    }
+    return -1;
+}
+
+template <typename Writer>
+void SensorManager::writeSensorTable(Writer &out, const SensorTable &snapshot)
+{
+    out.beginObject(snapshot.count);
+    for (int i = 0; i < snapshot.count; i++)
+        writeSensor(out, snapshot, i);
+    out.endObject();
+}
+
+template <typename Writer>
+void SensorManager::writeSensor(Writer &out, const SensorTable &snapshot, int slot)
+{
+    out.ipKey(snapshot.ip[slot])
+        .beginObject(1 + SENSOR_CHANNEL_COUNT)
+        .field("clientId", snapshot.clientId[slot]);
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        out.key(SENSOR_CHANNEL_INFO[ch].key).fixed(snapshot.channels[ch][slot], SENSOR_CHANNEL_INFO[ch].decimals);
+    out.endObject();
+}
+
+template void SensorManager::writeSensorTable(JsonWriter &, const SensorTable &);
+template void SensorManager::writeSensorTable(BinaryWriter &, const SensorTable &);
+template void SensorManager::writeSensor(JsonWriter &, const SensorTable &, int);
+template void SensorManager::writeSensor(BinaryWriter &, const SensorTable &, int);
+
+void SensorManager::writeStatsTable(JsonWriter &out, const SensorTable &snapshot) const
+{
+    out.beginObject();
+    for (int i = 0; i < snapshot.count; i++)
+        writeSensorStats(out, snapshot, i);
+    out.endObject();
+}
+
+void SensorManager::writeSensorStats(JsonWriter &out, const SensorTable &snapshot, int slot) const
+{
+    writeSensorStats(out, snapshot, stats.get(slot), slot);
+}
+
+void SensorManager::writeSensorStats(JsonWriter &out, const SensorTable &snapshot, const SensorStats &slotStats, int slot)
+{
+    out.ipKey(snapshot.ip[slot]).beginObject().field("clientId", snapshot.clientId[slot]);
+    SensorStatsTracker::writeJSON(out, slotStats);
+    out.endObject();
+}
+
+void SensorManager::getStatsSnapshot(SensorStats *out, int count) const
+{
+    for (int i = 0; i < count; i++)
+        out[i] = stats.get(i);
+}
+
+void SensorManager::writeLatencyTable(JsonWriter &out, const SensorTable &snapshot) const
+{
+    out.beginObject();
+    for (int i = 0; i < snapshot.count; i++)
+        writeSensorLatency(out, snapshot, latency.get(i), i);
+    out.endObject();
+}
+
+void SensorManager::writeSensorLatency(JsonWriter &out, const SensorTable &snapshot, const SensorLatency &slotLatency, int slot)
+{
+    out.ipKey(snapshot.ip[slot]).beginObject().field("clientId", snapshot.clientId[slot]);
+    LatencyTracker::writeJSON(out, slotLatency);
+    out.endObject();
+}
+
+void SensorManager::getLatencySnapshot(SensorLatency *out, int count) const
+{
+    for (int i = 0; i < count; i++)
+        out[i] = latency.get(i);
+}
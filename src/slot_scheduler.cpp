@@ -0,0 +1,170 @@
+#include "slot_scheduler.h"
+
+SlotAllocator::SlotAllocator()
+    : lastWindow(0), lastWindowIp(0), arrivals(0), onSlot(0), collisions(0), reassignments(0)
+{
+    memset(slots, 0, sizeof(slots));
+}
+
+int SlotAllocator::assign(uint32_t ip, int preferred, uint32_t now)
+{
+    // Keep an existing lease
+    for (int i = 0; i < TDMA_SLOT_COUNT; i++)
+    {
+        if (slots[i].ip == ip && now - slots[i].lastSeen < TDMA_SLOT_LEASE)
+        {
+            if (i == preferred || preferred < 0 || preferred >= TDMA_SLOT_COUNT)
+            {
+                slots[i].lastSeen = now;
+                return i;
+            }
+            slots[i].ip = 0; // clientId changed, try its slot below
+        }
+    }
+
+    // Prefer the clientId slot, else the first free one (two boards sharing an id)
+    int chosen = -1;
+    if (preferred >= 0 && preferred < TDMA_SLOT_COUNT &&
+        (slots[preferred].ip == 0 || now - slots[preferred].lastSeen >= TDMA_SLOT_LEASE))
+        chosen = preferred;
+    for (int i = 0; chosen < 0 && i < TDMA_SLOT_COUNT; i++)
+    {
+        if (slots[i].ip == 0 || now - slots[i].lastSeen >= TDMA_SLOT_LEASE)
+            chosen = i;
+    }
+    if (chosen < 0)
+        return -1;
+    if (chosen != preferred)
+        reassignments++;
+
+    slots[chosen].ip = ip;
+    slots[chosen].lastSeen = now;
+    return chosen;
+}
+
+void SlotAllocator::recordArrival(uint32_t ip, int slot, uint32_t now)
+{
+    arrivals++;
+    if (slot >= 0 && (int)((now % TDMA_FRAME_MS) / TDMA_SLOT_WIDTH) == slot)
+        onSlot++;
+
+    uint32_t window = now / TDMA_SLOT_WIDTH;
+    if (window == lastWindow && ip != lastWindowIp)
+        collisions++;
+    lastWindow = window;
+    lastWindowIp = ip;
+}
+
+void SlotAllocator::writeJSON(JsonWriter &json, uint32_t now) const
+{
+    json.beginObject()
+        .field("frameMs", TDMA_FRAME_MS)
+        .field("slotWidthMs", TDMA_SLOT_WIDTH)
+        .field("arrivals", arrivals)
+        .field("onSlot", onSlot)
+        .field("collisions", collisions)
+        .field("reassignments", reassignments)
+        .key("slots")
+        .beginObject();
+    for (int i = 0; i < TDMA_SLOT_COUNT; i++)
+    {
+        if (slots[i].ip == 0 || now - slots[i].lastSeen >= TDMA_SLOT_LEASE)
+            continue;
+        char slot[4];
+        snprintf(slot, sizeof(slot), "%d", i);
+        json.key(slot).ip(slots[i].ip);
+    }
+    json.endObject().endObject();
+}
+
+SlotScheduler::SlotScheduler()
+    : slot(-1), frameMs(TDMA_FRAME_MS), slotWidthMs(TDMA_SLOT_WIDTH), offsetMs(0), bestRttMs(UINT32_MAX),
+      sends(0), acks(0), retries(0), totalAckMs(0), lastFailed(false)
+{
+}
+
+bool SlotScheduler::isDue(uint32_t now, uint32_t lastSend, uint32_t intervalMs) const
+{
+    if (slot < 0)
+        return now - lastSend >= intervalMs;
+
+    // Half a frame of slack so a 200 ms interval still gets every frame
+    if (now - lastSend + frameMs / 2 < intervalMs)
+        return false;
+
+    uint32_t position = (now + offsetMs) % frameMs;
+    uint32_t start = slot * slotWidthMs;
+    return position >= start && position < start + slotWidthMs - TDMA_GUARD_TIME;
+}
+
+uint32_t SlotScheduler::msUntilSlot(uint32_t now) const
+{
+    if (slot < 0)
+        return 0;
+    uint32_t position = (now + offsetMs) % frameMs;
+    uint32_t start = slot * slotWidthMs;
+    return position <= start ? start - position : frameMs - position + start;
+}
+
+uint32_t SlotScheduler::msUntilDue(uint32_t now, uint32_t lastSend, uint32_t intervalMs) const
+{
+    uint32_t slack = slot < 0 ? 0 : frameMs / 2;
+    uint32_t elapsed = now - lastSend + slack;
+    uint32_t hold = elapsed >= intervalMs ? 0 : intervalMs - elapsed;
+    return hold + msUntilSlot(now + hold);
+}
+
+void SlotScheduler::onAck(const String &reply, uint32_t sentAt, uint32_t rttMs)
+{
+    sends++;
+    acks++;
+    totalAckMs += rttMs;
+    if (lastFailed)
+        retries++;
+    lastFailed = false;
+
+    long aggregatorTime = parseField(reply, "t", -1);
+    long assigned = parseField(reply, "slot", -1);
+    if (aggregatorTime < 0 || assigned < 0)
+    {
+        slot = -1; // aggregator without TDMA, send unscheduled
+        return;
+    }
+    frameMs = parseField(reply, "frame", TDMA_FRAME_MS);
+    slotWidthMs = parseField(reply, "sw", TDMA_SLOT_WIDTH);
+    if (frameMs == 0 || (uint32_t)assigned * slotWidthMs >= frameMs)
+    {
+        slot = -1;
+        return;
+    }
+    slot = assigned;
+
+    // The stamp was taken about half a round trip before the reply landed.
+    // Only low-RTT replies update the offset; the bar creeps up so a
+    // changed path is eventually accepted.
+    if (bestRttMs != UINT32_MAX)
+        bestRttMs++;
+    if (rttMs <= bestRttMs + CLOCK_SYNC_RTT_SLACK)
+    {
+        offsetMs = (int32_t)((uint32_t)aggregatorTime - (sentAt + rttMs / 2));
+        if (rttMs < bestRttMs)
+            bestRttMs = rttMs;
+    }
+}
+
+void SlotScheduler::onFailure()
+{
+    sends++;
+    if (lastFailed)
+        retries++;
+    lastFailed = true;
+}
+
+long SlotScheduler::parseField(const String &reply, const char *key, long fallback)
+{
+    String token = String(";") + key + "=";
+    int pos = reply.indexOf(token);
+    if (pos < 0)
+        return fallback;
+    return reply.substring(pos + token.length()).toInt();
+}
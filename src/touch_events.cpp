@@ -0,0 +1,72 @@
+#include "touch_events.h"
+
+TouchEventCapture::TouchEventCapture()
+    : pin(0), edgeLock(portMUX_INITIALIZER_UNLOCKED), lastEdgeUs(0), lastLevel(LOW), capturedCount(0), droppedCount(0), sentCount(0), wakeTask(nullptr)
+{
+}
+
+void TouchEventCapture::begin(uint8_t touchPin)
+{
+    pin = touchPin;
+    lastLevel = digitalRead(pin);
+    lastEdgeUs = micros();
+    attachInterruptArg(digitalPinToInterrupt(pin), handleInterrupt, this, CHANGE);
+}
+
+void IRAM_ATTR TouchEventCapture::handleInterrupt(void *arg)
+{
+    TouchEventCapture *self = static_cast<TouchEventCapture *>(arg);
+    uint8_t level = digitalRead(self->pin);
+    uint32_t now = micros();
+
+    // Ignore contact bounce: the level must differ from the last accepted
+    // edge, which must be at least one debounce window old
+    portENTER_CRITICAL_ISR(&self->edgeLock);
+    if (level != self->lastLevel && now - self->lastEdgeUs >= TOUCH_DEBOUNCE_US)
+        self->recordEdge(level, now);
+    portEXIT_CRITICAL_ISR(&self->edgeLock);
+
+    // Cut a low-power idle short so the edge goes out right away
+    if (self->wakeTask)
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(self->wakeTask, &woken);
+        if (woken)
+            portYIELD_FROM_ISR();
+    }
+}
+
+void IRAM_ATTR TouchEventCapture::recordEdge(uint8_t level, uint32_t now)
+{
+    lastLevel = level;
+    lastEdgeUs = now;
+
+    TouchEvent event = {now, level};
+    if (queue.push(event))
+        capturedCount.fetch_add(1, std::memory_order_relaxed);
+    else
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TouchEventCapture::poll(TouchEvent &event)
+{
+    if (queue.pop(event))
+        return true;
+
+    // An edge rejected by the debounce window can leave the pin settled in
+    // the other state with no further interrupt; reconcile it here
+    uint32_t now = micros();
+    if (now - lastEdgeUs >= TOUCH_DEBOUNCE_US)
+    {
+        uint8_t level = digitalRead(pin);
+        if (level != lastLevel)
+        {
+            portENTER_CRITICAL(&edgeLock);
+            if (level != lastLevel)
+                recordEdge(level, now);
+            portEXIT_CRITICAL(&edgeLock);
+            return queue.pop(event);
+        }
+    }
+    return false;
+}
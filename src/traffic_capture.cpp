@@ -0,0 +1,105 @@
+#include "traffic_capture.h"
+
+static_assert(CAPTURE_RECORD_HEADER_SIZE + HTTP_RX_BUFFER_SIZE <= CAPTURE_BUFFER_SIZE,
+              "A whole request must fit the capture buffer");
+
+static uint8_t *put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+TrafficCapture::TrafficCapture()
+    : buffered(0), bytes(0), startedAt(0), stoppedAt(0), records(0), dropped(0), active(false)
+{
+}
+
+bool TrafficCapture::start(uint32_t now)
+{
+    stop();
+    file = SPIFFS.open(CAPTURE_FILE, "w");
+    if (!file)
+        return false;
+
+    uint8_t *p = put16(buffer, CAPTURE_MAGIC);
+    *p++ = CAPTURE_VERSION;
+    *p++ = 0;
+    put32(p, now);
+    buffered = CAPTURE_HEADER_SIZE;
+    bytes = CAPTURE_HEADER_SIZE;
+    startedAt = now;
+    records = 0;
+    dropped = 0;
+    active = true;
+    return true;
+}
+
+void TrafficCapture::stop()
+{
+    if (!active)
+        return;
+    flush();
+    file.close();
+    active = false;
+    stoppedAt = millis();
+}
+
+bool TrafficCapture::flush()
+{
+    if (buffered == 0)
+        return true;
+    bool ok = file.write(buffer, buffered) == buffered;
+    buffered = 0;
+    return ok;
+}
+
+void TrafficCapture::record(uint32_t now, uint32_t ip, uint8_t kind, const char *body, size_t length)
+{
+    if (!active)
+        return;
+    size_t size = CAPTURE_RECORD_HEADER_SIZE + length;
+    if (length > 0xFFFF || bytes + size > CAPTURE_MAX_BYTES)
+    {
+        dropped++;
+        return;
+    }
+    if (buffered + size > sizeof(buffer) && !flush())
+    {
+        // Flash full or failing: keep what is there and stop recording
+        dropped++;
+        stop();
+        return;
+    }
+
+    uint8_t *p = put32(buffer + buffered, now - startedAt);
+    p = put32(p, ip);
+    *p++ = kind;
+    p = put16(p, length);
+    memcpy(p, body, length);
+    buffered += size;
+    bytes += size;
+    records++;
+}
+
+void TrafficCapture::writeJSON(JsonWriter &json, uint32_t now) const
+{
+    json.beginObject()
+        .field("active", active)
+        .field("file", CAPTURE_FILE)
+        .field("records", records)
+        .field("bytes", bytes)
+        .field("maxBytes", (uint32_t)CAPTURE_MAX_BYTES)
+        .field("dropped", dropped)
+        .field("durationMs", (active ? now : stoppedAt) - startedAt)
+        .endObject();
+}
@@ -0,0 +1,81 @@
+#include "uart_export.h"
+
+UartExport::UartExport(HardwareSerial &port)
+    : port(port), encoder(UART_EXPORT_BATTERY_DELTA, UART_EXPORT_FULL_REFRESH), lastFrameAt(0),
+      framesSent(0), framesSkipped(0), bytesSent(0)
+{
+}
+
+void UartExport::begin()
+{
+    // Must be sized before begin(), which installs the driver
+    port.setTxBufferSize(2 * UART_EXPORT_MAX_ENCODED);
+    port.begin(UART_EXPORT_BAUD, SERIAL_8N1, UART_EXPORT_RX_PIN, UART_EXPORT_TX_PIN);
+    Serial.printf("[UART EXPORT] %d baud on TX pin %d, every %d ms\n", UART_EXPORT_BAUD, UART_EXPORT_TX_PIN, UART_EXPORT_INTERVAL);
+}
+
+void UartExport::poll(uint32_t now, const SensorManager &manager)
+{
+    if (now - lastFrameAt < UART_EXPORT_INTERVAL)
+        return;
+    lastFrameAt = now;
+
+    SensorTable snapshot;
+    manager.getSnapshot(snapshot);
+    size_t len = encoder.encode(snapshot, now, frame);
+    if (len == 0)
+        return; // unchanged since the last frame
+
+    uint16_t crc = crc16(frame, len);
+    frame[len++] = crc & 0xFF;
+    frame[len++] = crc >> 8;
+    size_t encodedLen = cobsEncode(frame, len, encoded);
+
+    // The host is slower than we produce: drop this frame rather than block
+    if ((size_t)port.availableForWrite() < encodedLen)
+    {
+        framesSkipped++;
+        encoder.requestFull();
+        return;
+    }
+    port.write(encoded, encodedLen);
+    framesSent++;
+    bytesSent += encodedLen;
+}
+
+uint16_t UartExport::crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+size_t UartExport::cobsEncode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    // Each block starts with the distance to the next zero (or block end)
+    size_t codeAt = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (in[i] != 0)
+        {
+            out[o++] = in[i];
+            code++;
+        }
+        if (in[i] == 0 || code == 0xFF)
+        {
+            out[codeAt] = code;
+            codeAt = o++;
+            code = 1;
+        }
+    }
+    out[codeAt] = code;
+    out[o++] = 0x00;
+    return o;
+}
@@ -0,0 +1,94 @@
+#include "uplink_router.h"
+
+UplinkRouter::UplinkRouter(const char *const *hosts, size_t hostCount)
+    : count(hostCount < UPLINK_MAX_DESTINATIONS ? hostCount : UPLINK_MAX_DESTINATIONS), lastPrimary(-1),
+      failoverCount(0), hedgeCount(0)
+{
+    memset(destinations, 0, sizeof(destinations));
+    for (size_t i = 0; i < count; i++)
+        destinations[i].host = hosts[i];
+}
+
+// A down destination becomes usable again for one probe after the retry delay
+bool UplinkRouter::isUsable(const Destination &d, uint32_t now) const
+{
+    return !d.down || now - d.downSince >= UPLINK_DOWN_RETRY;
+}
+
+int UplinkRouter::primary(uint32_t now)
+{
+    int chosen = -1;
+    for (size_t i = 0; i < count && chosen < 0; i++)
+    {
+        if (isUsable(destinations[i], now))
+            chosen = i;
+    }
+    // Everything down: keep trying the first one rather than going silent
+    if (chosen < 0 && count > 0)
+        chosen = 0;
+
+    if (chosen != lastPrimary && lastPrimary >= 0)
+    {
+        failoverCount++;
+        Serial.printf("[UPLINK] Switching to %s\n", destinations[chosen].host);
+    }
+    lastPrimary = chosen;
+    return chosen;
+}
+
+int UplinkRouter::next(int after, uint32_t now) const
+{
+    for (size_t i = after + 1; i < count; i++)
+    {
+        if (isUsable(destinations[i], now))
+            return i;
+    }
+    // Wrap to earlier entries that are not the one we just tried
+    for (int i = 0; i < after; i++)
+    {
+        if (isUsable(destinations[i], now))
+            return i;
+    }
+    return -1;
+}
+
+UplinkOutcome UplinkRouter::classify(int httpCode, bool hedged, uint32_t elapsedMs)
+{
+    if (httpCode > 0)
+        return httpCode < 500 || httpCode == 503 ? UplinkOutcome::Answered : UplinkOutcome::Failed;
+    // A hedged attempt is cut short on purpose; only an earlier error is a fault
+    return hedged && elapsedMs >= UPLINK_HEDGE_BUDGET ? UplinkOutcome::HedgeExpired : UplinkOutcome::Failed;
+}
+
+void UplinkRouter::onResult(int index, UplinkOutcome outcome, uint32_t rttMs, uint32_t now)
+{
+    if (index < 0 || (size_t)index >= count)
+        return;
+    Destination &d = destinations[index];
+
+    if (outcome == UplinkOutcome::HedgeExpired)
+    {
+        d.hedgeExpiries++;
+        hedgeCount++;
+        return;
+    }
+    if (outcome == UplinkOutcome::Answered)
+    {
+        d.successes++;
+        d.consecutiveFailures = 0;
+        d.down = false;
+        d.smoothedRttMs = d.smoothedRttMs ? (d.smoothedRttMs * 7 + rttMs) / 8 : rttMs;
+        return;
+    }
+
+    d.failures++;
+    if (d.consecutiveFailures < 255)
+        d.consecutiveFailures++;
+    if (d.consecutiveFailures >= UPLINK_FAIL_THRESHOLD)
+    {
+        if (!d.down)
+            Serial.printf("[UPLINK] %s marked down\n", d.host);
+        d.down = true;
+        d.downSince = now; // also restarts the wait after a failed probe
+    }
+}
@@ -1,31 +1,78 @@
 #include "web_handlers.h"
 #include <Update.h>
+#include "form_parser.h"
+#include "web_routes.h"
 
-WebHandlers::WebHandlers(WebServer *webServer, SensorManager *sensorMgr)
-    : server(webServer), sensorManager(sensorMgr), clientIdPtr(nullptr)
+WebHandlers::WebHandlers(AsyncHttpServer *webServer, SensorManager *sensorMgr, SensorIngest *ingest)
+    : server(webServer), sensorManager(sensorMgr), sensorIngest(ingest), clientIdPtr(nullptr),
+      heapMonitor(nullptr)
 {
 }
 
-// Helper method to determine content type
-String WebHandlers::getContentType(String filename)
+// ========================= ROUTE AND MIME TABLES =========================
+
+struct WebRoute
+{
+    void (WebHandlers::*handler)(); // nullptr: the upload handler responds
+    void (WebHandlers::*upload)();
+};
+
+// Handlers for the ids in web_routes.h
+static constexpr WebRoute WEB_ROUTES[WEB_ROUTE_COUNT] = {
+#define WEB_ROUTE_ENTRY(id, m, path, handler, upload) {handler, upload},
+    WEB_ROUTE_TABLE(WEB_ROUTE_ENTRY)
+#undef WEB_ROUTE_ENTRY
+};
+
+#define MIME_STATIC 0x01 // served from SPIFFS for paths without a route
+#define MIME_UPLOAD 0x02 // accepted by the file manager
+
+struct MimeType
+{
+    const char *extension; // without the dot
+    uint8_t extensionLen;
+    const char *contentType;
+    uint8_t flags;
+};
+
+static constexpr MimeType MIME_TYPES[] = {
+    {"html", 4, "text/html", MIME_STATIC | MIME_UPLOAD},
+    {"css", 3, "text/css", MIME_STATIC | MIME_UPLOAD},
+    {"js", 2, "application/javascript", MIME_STATIC | MIME_UPLOAD},
+    {"json", 4, "application/json", 0},
+    {"bin", 3, "application/octet-stream", MIME_UPLOAD},
+};
+
+// Looks at the extension in place; nullptr for unknown types
+static const MimeType *findMimeType(const char *path, size_t len)
 {
-    if (filename.endsWith(".html"))
-        return "text/html";
-    if (filename.endsWith(".css"))
-        return "text/css";
-    if (filename.endsWith(".js"))
-        return "application/javascript";
-    if (filename.endsWith(".json"))
-        return "application/json";
-    return "text/plain";
+    size_t dot = len;
+    while (dot > 0 && path[dot - 1] != '.' && path[dot - 1] != '/')
+        dot--;
+    if (dot == 0 || path[dot - 1] != '.')
+        return nullptr;
+
+    size_t extensionLen = len - dot;
+    for (const MimeType &mime : MIME_TYPES)
+    {
+        if (mime.extensionLen == extensionLen && memcmp(mime.extension, path + dot, extensionLen) == 0)
+            return &mime;
+    }
+    return nullptr;
+}
+
+static bool hasMimeFlag(const String &path, uint8_t flag)
+{
+    const MimeType *mime = findMimeType(path.c_str(), path.length());
+    return mime && (mime->flags & flag);
 }
 
 // Simplified file sending method
-bool WebHandlers::sendFile(String path)
+bool WebHandlers::sendFile(const char *path)
 {
     if (!SPIFFS.exists(path))
     {
-        Serial.printf("File not found: %s\n", path.c_str());
+        Serial.printf("File not found: %s\n", path);
         server->send(404, "text/plain", "File not found");
         return false;
     }
@@ -33,37 +80,111 @@ bool WebHandlers::sendFile(String path)
     File file = SPIFFS.open(path, "r");
     if (!file || file.size() == 0)
     {
-        Serial.printf("Cannot open or empty file: %s\n", path.c_str());
+        Serial.printf("Cannot open or empty file: %s\n", path);
         server->send(500, "text/plain", "Cannot open file");
         file.close();
         return false;
     }
 
-    // Stream file directly (ESP32 WebServer handles chunking automatically)
-    server->streamFile(file, getContentType(path));
-    file.close();
+    // The server owns the file from here and streams it as the socket drains
+    const MimeType *mime = findMimeType(path, strlen(path));
+    server->streamFile(file, mime ? mime->contentType : "text/plain");
     return true;
 }
 
-// Check if file extension is allowed
-bool WebHandlers::isValidFileExtension(String filename)
+// Sends a writer's output, or a 500 if it ran out of arena
+void WebHandlers::sendJson(const JsonWriter &json)
+{
+    if (!json.ok())
+    {
+        server->send(500, "text/plain", "Response too large");
+        return;
+    }
+    server->send(200, "application/json", json.c_str(), json.length());
+}
+
+static bool equalsIgnoreCase(const char *a, size_t aLen, const char *b)
+{
+    return strlen(b) == aLen && strncasecmp(a, b, aLen) == 0;
+}
+
+// The first media range in Accept that we can produce wins, so clients list
+// the binary type before any JSON fallback. Parameters other than q=0 are
+// ignored.
+bool WebHandlers::acceptsBinary(BinaryFormat &format)
+{
+    const char *accept;
+    size_t acceptLen;
+    if (!server->findHeader("Accept", accept, acceptLen))
+        return false;
+
+    const char *end = accept + acceptLen;
+    const char *range = accept;
+    while (range < end)
+    {
+        const char *comma = (const char *)memchr(range, ',', end - range);
+        const char *rangeEnd = comma ? comma : end;
+        while (range < rangeEnd && *range == ' ')
+            range++;
+        const char *params = (const char *)memchr(range, ';', rangeEnd - range);
+        const char *typeEnd = params ? params : rangeEnd;
+        while (typeEnd > range && typeEnd[-1] == ' ')
+            typeEnd--;
+        size_t typeLen = typeEnd - range;
+
+        bool refused = false;
+        for (const char *p = params; p && p + 3 <= rangeEnd; p++)
+        {
+            if (p[0] == 'q' && p[1] == '=' && atof(p + 2) == 0.0)
+                refused = true;
+        }
+
+        if (!refused)
+        {
+            if (equalsIgnoreCase(range, typeLen, "application/cbor"))
+            {
+                format = BinaryFormat::Cbor;
+                return true;
+            }
+            if (equalsIgnoreCase(range, typeLen, "application/msgpack") ||
+                equalsIgnoreCase(range, typeLen, "application/x-msgpack") ||
+                equalsIgnoreCase(range, typeLen, "application/vnd.msgpack"))
+            {
+                format = BinaryFormat::MsgPack;
+                return true;
+            }
+            if (equalsIgnoreCase(range, typeLen, "application/json") || equalsIgnoreCase(range, typeLen, "*/*") ||
+                equalsIgnoreCase(range, typeLen, "application/*"))
+                return false;
+        }
+        range = rangeEnd + 1;
+    }
+    return false;
+}
+
+void WebHandlers::sendBinary(const BinaryWriter &out)
+{
+    if (!out.ok())
+    {
+        server->send(500, "text/plain", "Response too large");
+        return;
+    }
+    server->send(200, out.contentType(), (const char *)out.data(), out.length());
+}
+
+// Every chunked response of this kind is still sending
+void WebHandlers::sendStreamsBusy()
 {
-    return filename.endsWith(".html") ||
-           filename.endsWith(".css") ||
-           filename.endsWith(".js") ||
-           filename.endsWith(".bin");
+    server->sendHeader("Retry-After", "1");
+    server->send(503, "text/plain", "Busy");
 }
 
 // Simplified JSON response helper
-void WebHandlers::sendJsonResponse(bool success, String message, String data)
+void WebHandlers::sendJsonResponse(bool success, const char *message)
 {
-    String json = "{\"success\":" + String(success ? "true" : "false");
-    if (message.length() > 0)
-        json += ",\"message\":\"" + message + "\"";
-    if (data.length() > 0)
-        json += "," + data;
-    json += "}";
-    server->send(success ? 200 : 400, "application/json", json);
+    JsonWriter json(arena);
+    json.beginObject().field("success", success).field("message", message).endObject();
+    server->send(success ? 200 : 400, "application/json", json.c_str(), json.length());
 }
 
 // ========================= ROUTE HANDLERS =========================
@@ -75,33 +196,395 @@ void WebHandlers::handleRoot()
 
 void WebHandlers::handleStaticFile()
 {
-    sendFile(server->uri());
+    sendFile(server->uri().c_str());
+}
+
+// Checked before any parsing, so a flooding sender costs little more than
+// reading its request. The hint is in whole seconds for Retry-After and in
+// ms in the body, matching the ack's ";key=" fields.
+bool WebHandlers::admitSender(uint32_t ip)
+{
+#if ADMISSION_ENABLED
+    uint32_t retryAfterMs;
+    if (!admission.admit(ip, millis(), retryAfterMs))
+    {
+        server->sendHeader("Retry-After", arena.format("%lu", (unsigned long)(retryAfterMs + 999) / 1000));
+        const char *body = arena.format("Too many requests;retry=%lu", (unsigned long)retryAfterMs);
+        server->send(429, "text/plain", body, strlen(body));
+        return false;
+    }
+#endif
+    return true;
+}
+
+// Source of a /sensor or /sensorBatch request. A replayer stands in for
+// many senders by naming the captured one in X-Replay-From.
+uint32_t WebHandlers::senderIP() const
+{
+#if CAPTURE_REPLAY_HEADER
+    const char *value;
+    size_t len;
+    char text[16];
+    IPAddress replayed;
+    if (server->findHeader("X-Replay-From", value, len) && len < sizeof(text))
+    {
+        memcpy(text, value, len);
+        text[len] = '\0';
+        if (replayed.fromString(text))
+            return (uint32_t)replayed;
+    }
+#endif
+    return (uint32_t)server->remoteIP();
+}
+
+// Records the request as received, before anything can reject it
+void WebHandlers::captureRequest(uint32_t ip, uint8_t kind)
+{
+#if CAPTURE_ENABLED
+    capture.record(millis(), ip, kind, server->body(), server->bodyLength());
+#else
+    (void)ip;
+    (void)kind;
+#endif
 }
 
 void WebHandlers::handleSensorData()
 {
-    String senderIP = server->client().remoteIP().toString();
-    String clientId = server->arg("clientId");
-    int touchValue = server->arg("touch").toInt();
-    float batteryVoltage = server->arg("batteryVoltage").toFloat();
-    float batteryPercent = server->arg("batteryPercent").toFloat();
+    uint32_t ip = senderIP();
+    captureRequest(ip, CAPTURE_KIND_SENSOR);
+    if (!admitSender(ip))
+        return;
+
+    // Parsed in one pass straight from the request buffer
+    SensorForm form;
+    if (FormParser::parseSensorForm(server->body(), server->bodyLength(), form) != FormResult::Ok)
+    {
+        server->send(400, "text/plain", "Bad sensor data");
+        return;
+    }
+
+    SensorSample sample;
+    sample.ip = ip;
+    memcpy(sample.clientId, form.clientId, SENSOR_CLIENT_ID_LEN);
+
+    // A retry or failover copy we already applied: ack it again, apply nothing
+    bool hasSeq = form.fields & FORM_FIELD_SEQ;
+    if (hasSeq && duplicates.isDuplicate(sample.ip, form.seq))
+    {
+        sendSensorAck(sample.ip, sample.clientId);
+        return;
+    }
 
-    sensorManager->updateSensorData(senderIP, clientId, touchValue, batteryVoltage, batteryPercent);
-    server->send(200, "text/plain", "OK");
+    memcpy(sample.channels, form.channels, sizeof(sample.channels));
+    sample.receivedAt = millis();
+    sample.capturedAt = form.capturedAt;
+    sample.sentAt = form.sentAt;
+    sample.rttMs = form.rttMs;
+    sample.timing = 0;
+    if (form.fields & FORM_FIELD_SENT_AT)
+        sample.timing |= SAMPLE_TIMING_SENT_AT;
+    if (form.fields & FORM_FIELD_CAPTURED_AT)
+        sample.timing |= SAMPLE_TIMING_CAPTURED_AT;
+    if (form.fields & FORM_FIELD_RTT)
+        sample.timing |= SAMPLE_TIMING_RTT;
+    if (hasSeq)
+        sample.timing |= SAMPLE_TIMING_SEQ;
+    sample.seq = form.seq;
+
+    // Applied to SensorManager by the ingest consumer in loop()
+    if (!sensorIngest->push(sample))
+    {
+        server->send(503, "text/plain", "Busy");
+        return;
+    }
+    if (hasSeq)
+        duplicates.record(sample.ip, form.seq);
+    sendSensorAck(sample.ip, sample.clientId);
 }
 
+// Accepts samples a client buffered while offline. Entries carry their own
+// capture timestamps and may be older than what the table already shows.
+void WebHandlers::handleSensorBatch()
+{
+    uint32_t ip = senderIP();
+    captureRequest(ip, CAPTURE_KIND_SENSOR_BATCH);
+    if (!admitSender(ip))
+        return;
+
+    SensorBatchForm batch;
+    if (FormParser::parseSensorBatch(server->body(), server->bodyLength(), batch) != FormResult::Ok)
+    {
+        server->send(400, "text/plain", "Bad batch");
+        return;
+    }
+
+    // Validate the whole list first so a batch is applied all or nothing
+    const char *end = batch.samples + batch.samplesLength;
+    const char *cursor = batch.samples;
+    BatchEntry entry;
+    FormResult result;
+    size_t entries = 0;
+    while ((result = FormParser::nextBatchEntry(cursor, end, entry)) == FormResult::Ok)
+        entries++;
+    if (result == FormResult::Invalid || entries == 0)
+    {
+        server->send(400, "text/plain", "Bad batch");
+        return;
+    }
+
+    bool hasSeq = batch.fields & FORM_FIELD_SEQ;
+    if (hasSeq && duplicates.isDuplicate(ip, batch.seq))
+    {
+        sendSensorAck(ip, batch.clientId);
+        return;
+    }
+    if (sensorIngest->pending() + entries > INGEST_QUEUE_SIZE)
+    {
+        server->send(503, "text/plain", "Busy");
+        return;
+    }
+
+    SensorSample sample;
+    sample.ip = ip;
+    memcpy(sample.clientId, batch.clientId, SENSOR_CLIENT_ID_LEN);
+    sample.receivedAt = millis();
+    sample.sentAt = batch.sentAt;
+    sample.rttMs = batch.rttMs;
+    sample.seq = batch.seq;
+
+    cursor = batch.samples;
+    bool first = true;
+    while (FormParser::nextBatchEntry(cursor, end, entry) == FormResult::Ok)
+    {
+        memcpy(sample.channels, entry.channels, sizeof(sample.channels));
+        sample.capturedAt = entry.capturedAt;
+        sample.timing = SAMPLE_TIMING_SENT_AT | SAMPLE_TIMING_CAPTURED_AT | SAMPLE_TIMING_REPLAY;
+        // One clock sync sample and one sequence number per request
+        if (first && (batch.fields & FORM_FIELD_RTT))
+            sample.timing |= SAMPLE_TIMING_RTT;
+        if (first && hasSeq)
+            sample.timing |= SAMPLE_TIMING_SEQ;
+        first = false;
+        sensorIngest->push(sample);
+    }
+    if (hasSeq)
+        duplicates.record(ip, batch.seq);
+    sendSensorAck(sample.ip, sample.clientId);
+}
+
+// Our clock rides along so clients can estimate their offset too, plus a
+// backpressure hint once the ingest queue starts filling up and the sender's
+// transmit slot (frames are aligned to our millis(), so "t" is the epoch)
+void WebHandlers::sendSensorAck(uint32_t ip, const char *clientId)
+{
+    uint32_t now = millis();
+    int fill = sensorIngest->pending() * 100 / INGEST_QUEUE_SIZE;
+    int backpressure = fill < BACKPRESSURE_QUEUE_PERCENT ? 0 : fill;
+    char reply[64];
+    int len = snprintf(reply, sizeof(reply), "OK;t=%lu;bp=%d", (unsigned long)now, backpressure);
+
+#if TDMA_ENABLED
+    int32_t preferred;
+    if (!FormParser::parseInt(clientId, strlen(clientId), preferred))
+        preferred = -1;
+    int slot = slotAllocator.assign(ip, preferred, now);
+    slotAllocator.recordArrival(ip, slot, now);
+    if (slot >= 0)
+        len += snprintf(reply + len, sizeof(reply) - len, ";slot=%d;frame=%d;sw=%d", slot, TDMA_FRAME_MS, TDMA_SLOT_WIDTH);
+#else
+    (void)ip;
+    (void)clientId;
+#endif
+    server->send(200, "text/plain", reply, len);
+}
+
+// The whole table always fits the arena in binary form
+static_assert(MAX_TRACKED_SENSORS * SENSOR_BINARY_ENTRY_MAX + 8 <= HTTP_ARENA_SIZE,
+              "Raise HTTP_ARENA_SIZE for binary /sensorData");
+static_assert(SENSOR_BINARY_LOCAL_MAX <= HTTP_ARENA_SIZE, "Raise HTTP_ARENA_SIZE for binary /localSensorData");
+
+// CBOR or MessagePack when Accept asks for it. JSON is sent in one piece
+// when it fits the arena, otherwise streamed in chunks.
 void WebHandlers::handleGetSensorData()
 {
-    String json = sensorManager->getSensorDataJSON();
-    server->send(200, "application/json", json);
+    SensorTable snapshot;
+    sensorManager->getSnapshot(snapshot);
+    server->sendHeader("Vary", "Accept");
+
+    BinaryFormat format;
+    if (acceptsBinary(format))
+    {
+        size_t size = snapshot.count * SENSOR_BINARY_ENTRY_MAX + 8;
+        BinaryWriter out(format, (uint8_t *)arena.alloc(size), size);
+        SensorManager::writeSensorTable(out, snapshot);
+        sendBinary(out);
+    }
+    else
+    {
+        JsonWriter json(arena);
+        SensorManager::writeSensorTable(json, snapshot);
+        if (json.ok())
+            server->send(200, "application/json", json.c_str(), json.length());
+    }
+    if (!server->responded())
+    {
+        SensorTableStream *stream = claimStream(tableStreams);
+        if (!stream)
+        {
+            sendStreamsBusy();
+            return;
+        }
+        stream->begin(snapshot);
+        server->sendChunked(200, "application/json", stream);
+    }
+    sensorManager->recordDashboardPush(snapshot);
+}
+
+// Clock offsets and latency histograms per sender; streamed like
+// /sensorStats when the table outgrows the arena
+void WebHandlers::handleGetLatency()
+{
+    SensorTable snapshot;
+    sensorManager->getSnapshot(snapshot);
+    {
+        JsonWriter json(arena);
+        sensorManager->writeLatencyTable(json, snapshot);
+        if (json.ok())
+            server->send(200, "application/json", json.c_str(), json.length());
+    }
+    if (server->responded())
+        return;
+    SensorTableStream *stream = claimStream(tableStreams);
+    if (!stream)
+    {
+        sendStreamsBusy();
+        return;
+    }
+    stream->beginLatency(snapshot, *sensorManager);
+    server->sendChunked(200, "application/json", stream);
+}
+
+// Rate, loss, jitter, touch activity and battery slope per sender; streamed
+// like /sensorData when the table outgrows the arena
+void WebHandlers::handleGetSensorStats()
+{
+    SensorTable snapshot;
+    sensorManager->getSnapshot(snapshot);
+    {
+        JsonWriter json(arena);
+        sensorManager->writeStatsTable(json, snapshot);
+        if (json.ok())
+            server->send(200, "application/json", json.c_str(), json.length());
+    }
+    if (server->responded())
+        return;
+    SensorTableStream *stream = claimStream(tableStreams);
+    if (!stream)
+    {
+        sendStreamsBusy();
+        return;
+    }
+    stream->beginStats(snapshot, *sensorManager);
+    server->sendChunked(200, "application/json", stream);
+}
+
+void WebHandlers::handleGetSlots()
+{
+    JsonWriter json(arena);
+    slotAllocator.writeJSON(json, millis());
+    sendJson(json);
+}
+
+void WebHandlers::handleGetIngestStats()
+{
+    JsonWriter json(arena);
+    json.beginObject()
+        .field("accepted", sensorIngest->getAcceptedCount())
+        .field("dropped", sensorIngest->getDroppedCount())
+        .field("pending", sensorIngest->pending())
+        .field("duplicates", duplicates.getDuplicateCount())
+        .field("rateLimited", admission.getRejectedCount())
+        .key("limitedSenders");
+    admission.writeJSON(json);
+    json.endObject();
+    sendJson(json);
+}
+
+// Heap fragmentation plus how much of the response arena requests use
+void WebHandlers::handleGetHeap()
+{
+    JsonWriter json(arena);
+    json.beginObject();
+    if (heapMonitor)
+    {
+        json.key("heap");
+        heapMonitor->writeJSON(json);
+    }
+    json.key("arena")
+        .beginObject()
+        .field("size", HTTP_ARENA_SIZE)
+        .field("highWater", arena.getHighWater())
+        .field("overflows", arena.getOverflows())
+        .endObject();
+    json.endObject();
+    sendJson(json);
 }
 
 void WebHandlers::handleGetLocalSensorData()
 {
-    String json = sensorManager->getLocalSensorDataJSON();
-    server->send(200, "application/json", json);
+    server->sendHeader("Vary", "Accept");
+    BinaryFormat format;
+    if (acceptsBinary(format))
+    {
+        BinaryWriter out(format, (uint8_t *)arena.alloc(SENSOR_BINARY_LOCAL_MAX), SENSOR_BINARY_LOCAL_MAX);
+        sensorManager->writeLocalSensorData(out);
+        sendBinary(out);
+        return;
+    }
+    JsonWriter json(arena);
+    sensorManager->writeLocalSensorData(json);
+    sendJson(json);
+}
+
+#if CAPTURE_ENABLED
+void WebHandlers::handleGetCapture()
+{
+    JsonWriter json(arena);
+    capture.writeJSON(json, millis());
+    sendJson(json);
 }
 
+// record=1 starts a new capture (replacing the file), record=0 stops it
+void WebHandlers::handleCaptureControl()
+{
+    int32_t record;
+    if (FormParser::findInt(server->body(), server->bodyLength(), "record", record) != FormResult::Ok)
+    {
+        sendJsonResponse(false, "Missing record parameter");
+        return;
+    }
+    if (record && !capture.start(millis()))
+    {
+        sendJsonResponse(false, "Cannot create " CAPTURE_FILE);
+        return;
+    }
+    if (!record)
+        capture.stop();
+    Serial.printf("[CAPTURE] %s\n", record ? "started" : "stopped");
+    handleGetCapture();
+}
+
+void WebHandlers::handleGetCaptureFile()
+{
+    if (capture.isActive())
+    {
+        server->send(409, "text/plain", "Capture in progress");
+        return;
+    }
+    sendFile(CAPTURE_FILE);
+}
+#endif
+
 void WebHandlers::handleSensorDataPage()
 {
     sendFile("/sensor_data.html");
@@ -109,21 +592,27 @@ void WebHandlers::handleSensorDataPage()
 
 void WebHandlers::handleSetClientId()
 {
-    if (!server->hasArg("id"))
+    int32_t newId;
+    FormResult result = FormParser::findInt(server->body(), server->bodyLength(), "id", newId);
+    if (result == FormResult::Missing)
+        result = FormParser::findInt(server->query(), server->queryLength(), "id", newId);
+
+    if (result == FormResult::Missing)
     {
         sendJsonResponse(false, "Missing ID parameter");
         return;
     }
 
-    int newId = server->arg("id").toInt();
-    if (newId < 0 || newId > 15)
+    if (result == FormResult::Invalid || newId < 0 || newId > 15)
     {
         sendJsonResponse(false, "ID must be between 0-15");
         return;
     }
 
     *clientIdPtr = newId;
-    sendJsonResponse(true, "Client ID updated", "\"clientId\":" + String(newId));
+    JsonWriter json(arena);
+    json.beginObject().field("success", true).field("message", "Client ID updated").field("clientId", newId).endObject();
+    sendJson(json);
     Serial.printf("[CLIENT_ID] Updated to %d\n", newId);
 }
 
@@ -134,7 +623,7 @@ void WebHandlers::handleUpload()
 
 void WebHandlers::handleFileUpload()
 {
-    HTTPUpload &upload = server->upload();
+    HttpUpload &upload = server->upload();
     static File uploadFile;
     static bool uploadSuccess = false;
 
@@ -146,7 +635,7 @@ void WebHandlers::handleFileUpload()
         if (!filename.startsWith("/"))
             filename = "/" + filename;
 
-        if (!isValidFileExtension(filename))
+        if (!hasMimeFlag(filename, MIME_UPLOAD))
         {
             Serial.printf("Rejected: %s (invalid extension)\n", filename.c_str());
             sendJsonResponse(false, "Only .html, .css, .js, .bin files allowed");
@@ -193,7 +682,7 @@ void WebHandlers::handleDeleteFile()
 
     if (!SPIFFS.exists(filename))
     {
-        sendJsonResponse(false, "File not found: " + filename);
+        sendJsonResponse(false, arena.format("File not found: %s", filename.c_str()));
         return;
     }
 
@@ -202,26 +691,33 @@ void WebHandlers::handleDeleteFile()
     Serial.printf("Delete %s: %s\n", filename.c_str(), success ? "success" : "failed");
 }
 
+// Streamed as the directory is walked. Optional ?offset=&limit= page through
+// it; a page shorter than limit is the last one.
 void WebHandlers::handleListFiles()
 {
-    String json = "[";
-    bool first = true;
-
-    File root = SPIFFS.open("/");
-    File file = root.openNextFile();
-
-    while (file)
+    int32_t offset = 0;
+    int32_t limit = 0;
+    if (FormParser::findInt(server->query(), server->queryLength(), "offset", offset) == FormResult::Invalid ||
+        FormParser::findInt(server->query(), server->queryLength(), "limit", limit) == FormResult::Invalid ||
+        offset < 0 || limit < 0)
     {
-        if (!first)
-            json += ",";
-        json += "{\"name\":\"" + String(file.name()) + "\",\"size\":" + String(file.size()) + "}";
-        first = false;
-        file = root.openNextFile();
+        server->send(400, "text/plain", "Bad offset or limit");
+        return;
     }
 
-    json += "]";
-    root.close();
-    server->send(200, "application/json", json);
+    FileListStream *stream = claimStream(listStreams);
+    if (!stream)
+    {
+        sendStreamsBusy();
+        return;
+    }
+    if (!stream->begin(offset, limit))
+    {
+        stream->end();
+        server->send(500, "text/plain", "Cannot open directory");
+        return;
+    }
+    server->sendChunked(200, "application/json", stream);
 }
 
 void WebHandlers::handleFirmware()
@@ -249,7 +745,7 @@ void WebHandlers::handleFirmwareUpdate()
 
     if (!SPIFFS.exists(filename))
     {
-        sendJsonResponse(false, "Firmware file not found: " + filename);
+        sendJsonResponse(false, arena.format("Firmware file not found: %s", filename.c_str()));
         return;
     }
 
@@ -288,52 +784,49 @@ void WebHandlers::handleFirmwareUpdate()
     }
 }
 
-// ========================= SETUP ROUTES =========================
+// ========================= ROUTING =========================
 
 void WebHandlers::setupRoutes(int &clientId)
 {
     clientIdPtr = &clientId; // Store reference for use in handlers
+    server->setRouter(this);
+}
 
-    // Main routes
-    server->on("/", HTTP_GET, [this]()
-               { handleRoot(); });
-    server->on("/sensorpage", HTTP_GET, [this]()
-               { handleSensorDataPage(); });
-    server->on("/upload", HTTP_GET, [this]()
-               { handleUpload(); });
-    server->on("/firmware", HTTP_GET, [this]()
-               { handleFirmware(); });
-
-    // API routes
-    server->on("/sensor", HTTP_POST, [this]()
-               { handleSensorData(); });
-    server->on("/sensorData", HTTP_GET, [this]()
-               { handleGetSensorData(); });
-    server->on("/localSensorData", HTTP_GET, [this]()
-               { handleGetLocalSensorData(); });
-    server->on("/setClientId", HTTP_POST, [this]()
-               { handleSetClientId(); });
-
-    // File management
-    server->on("/upload", HTTP_POST, []() {}, [this]()
-               { handleFileUpload(); });
-    server->on("/delete", HTTP_POST, [this]()
-               { handleDeleteFile(); });
-    server->on("/list", HTTP_GET, [this]()
-               { handleListFiles(); });
-    server->on("/firmwareUpdate", HTTP_POST, [this]()
-               { handleFirmwareUpdate(); });
-
-    // Static file handler
-    server->onNotFound([this]()
-                       {
-        String path = server->uri();
-        if (path.endsWith(".css") || path.endsWith(".js") || path.endsWith(".html"))
-        {
-            handleStaticFile();
-        }
-        else
-        {
-            server->send(404, "text/plain", "Not found");
-        } });
-}
\ No newline at end of file
+int WebHandlers::match(HttpMethod method, const char *path, size_t pathLen) const
+{
+    return webRouteMatch(method, path, pathLen);
+}
+
+bool WebHandlers::acceptsUpload(int route) const
+{
+    return route >= 0 && route < WEB_ROUTE_COUNT && WEB_ROUTES[route].upload;
+}
+
+void WebHandlers::handle(int route)
+{
+    if (route < 0 || route >= WEB_ROUTE_COUNT)
+    {
+        handleNotFound();
+        return;
+    }
+    if (WEB_ROUTES[route].handler)
+        (this->*WEB_ROUTES[route].handler)();
+    // send() has copied the response out by now
+    arena.reset();
+}
+
+void WebHandlers::handleUpload(int route)
+{
+    if (acceptsUpload(route))
+        (this->*WEB_ROUTES[route].upload)();
+    arena.reset();
+}
+
+// Pages and assets without a route of their own come straight from SPIFFS
+void WebHandlers::handleNotFound()
+{
+    if (hasMimeFlag(server->uri(), MIME_STATIC))
+        handleStaticFile();
+    else
+        server->send(404, "text/plain", "Not found");
+}
@@ -0,0 +1,35 @@
+#include "web_routes.h"
+
+struct WebRoutePath
+{
+    const char *path;
+    uint8_t pathLen;
+};
+
+static constexpr WebRoutePath WEB_ROUTE_PATHS[WEB_ROUTE_COUNT] = {
+#define WEB_ROUTE_PATH(id, m, path, handler, upload) {path, sizeof(path) - 1},
+    WEB_ROUTE_TABLE(WEB_ROUTE_PATH)
+#undef WEB_ROUTE_PATH
+};
+
+int webRouteMatch(HttpMethod method, const char *path, size_t pathLen)
+{
+    int route;
+    switch (httpRouteKey(method, path, pathLen))
+    {
+#define WEB_ROUTE_CASE(id, m, path, handler, upload) \
+    case httpRouteKey(HttpMethod::m, path):          \
+        route = WEB_ROUTE_##id;                      \
+        break;
+        WEB_ROUTE_TABLE(WEB_ROUTE_CASE)
+#undef WEB_ROUTE_CASE
+    default:
+        return HTTP_NO_ROUTE;
+    }
+
+    // Other paths can share a route's key
+    const WebRoutePath &entry = WEB_ROUTE_PATHS[route];
+    if (entry.pathLen != pathLen || memcmp(entry.path, path, pathLen) != 0)
+        return HTTP_NO_ROUTE;
+    return route;
+}
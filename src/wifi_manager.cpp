@@ -1,11 +1,35 @@
 #include "wifi_manager.h"
 #include "config.h"
+#include "led_controller.h"
 #include <SPIFFS.h>
 #include <Update.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/etharp.h>
+#include <lwip/priv/tcpip_priv.h>
+
+#define WIFI_CACHE_MAGIC 0x57494631 // "WIF1"
+#define WIFI_PREFS_NAMESPACE "wifi"
+#define WIFI_PREFS_KEY "cache"
+
+#define WIFI_EVENT_CONNECTED 1
+#define WIFI_EVENT_GOT_IP 2
+#define WIFI_EVENT_DISCONNECTED 3
+
+#define WIFI_REASON_ASSOC_LEAVE 8 // our own disconnect() while switching attempts
+
+// Survives deep sleep, so a wake skips the NVS read as well
+RTC_DATA_ATTR static WiFiCache rtcCache;
 
 WiFiManager::WiFiManager()
+    : state(WiFiState::Idle), statusLed(nullptr), cacheValid(false), fastAttempt(false), leaseCheck(false), otaReady(false),
+      everConnected(false), pendingChannel(0), attemptStart(0), leaseCheckAt(0), outageStart(0), retryAt(0), backoff(WIFI_RETRY_MIN_INTERVAL),
+      bootConnectMs(0), lastReconnectMs(0), reconnectCount(0), fastConnectCount(0), fullConnectCount(0)
 {
-    lastReconnectAttempt = 0;
+    memset(&cache, 0, sizeof(cache));
+    memset(pendingBssid, 0, sizeof(pendingBssid));
 }
 
 void WiFiManager::setupOTA()
@@ -74,56 +98,325 @@ void WiFiManager::printWiFiStatus()
     }
 }
 
-bool WiFiManager::init()
+// Runs on the WiFi event task; only queue the facts
+void WiFiManager::onEvent(WiFiEvent_t event, WiFiEventInfo_t info)
 {
-    WiFi.mode(WIFI_STA);
+    EventRecord record;
+    memset(&record, 0, sizeof(record));
+    record.at = millis();
+    switch (event)
+    {
+    case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+        record.id = WIFI_EVENT_CONNECTED;
+        record.channel = info.wifi_sta_connected.channel;
+        memcpy(record.bssid, info.wifi_sta_connected.bssid, sizeof(record.bssid));
+        break;
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        record.id = WIFI_EVENT_GOT_IP;
+        break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        record.id = WIFI_EVENT_DISCONNECTED;
+        record.reason = info.wifi_sta_disconnected.reason;
+        break;
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+        record.id = WIFI_EVENT_DISCONNECTED;
+        break;
+    default:
+        return;
+    }
+    events.push(record);
+}
 
-    Serial.printf("Connecting to WiFi: %s\n", WIFI_SSID);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+void WiFiManager::loadCache()
+{
+    if (rtcCache.magic == WIFI_CACHE_MAGIC)
+    {
+        cache = rtcCache;
+        cacheValid = true;
+        return;
+    }
 
-    int connectionAttempts = 0;
-    while (WiFi.status() != WL_CONNECTED && connectionAttempts < CONNECTION_TIMEOUT)
+    Preferences prefs;
+    if (prefs.begin(WIFI_PREFS_NAMESPACE, true))
     {
-        delay(500);
-        Serial.print(".");
-        connectionAttempts++;
+        cacheValid = prefs.getBytes(WIFI_PREFS_KEY, &cache, sizeof(cache)) == sizeof(cache) &&
+                     cache.magic == WIFI_CACHE_MAGIC;
+        prefs.end();
     }
-    Serial.println();
+    if (cacheValid)
+        rtcCache = cache;
+}
 
-    if (WiFi.status() == WL_CONNECTED)
+// Only writes NVS when the association actually changed, to spare flash wear
+void WiFiManager::saveCache()
+{
+    WiFiCache fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    fresh.magic = WIFI_CACHE_MAGIC;
+    fresh.channel = pendingChannel;
+    memcpy(fresh.bssid, pendingBssid, sizeof(fresh.bssid));
+    fresh.ip = (uint32_t)WiFi.localIP();
+    fresh.gateway = (uint32_t)WiFi.gatewayIP();
+    fresh.subnet = (uint32_t)WiFi.subnetMask();
+    fresh.dns = (uint32_t)WiFi.dnsIP();
+
+    rtcCache = fresh;
+    if (cacheValid && memcmp(&fresh, &cache, sizeof(fresh)) == 0)
+        return;
+
+    cache = fresh;
+    cacheValid = true;
+    Preferences prefs;
+    if (prefs.begin(WIFI_PREFS_NAMESPACE, false))
     {
-        printConnectionInfo();
-        setupOTA();
-        return true;
+        prefs.putBytes(WIFI_PREFS_KEY, &cache, sizeof(cache));
+        prefs.end();
+    }
+}
+
+void WiFiManager::setStatusLed(LEDController *led)
+{
+    statusLed = led;
+}
+
+void WiFiManager::setState(WiFiState next)
+{
+    state = next;
+    if (!statusLed)
+        return;
+    switch (next)
+    {
+    case WiFiState::Connecting:
+        statusLed->setConnectingIndicator();
+        break;
+    case WiFiState::Connected:
+        statusLed->setConnectedIndicator();
+        break;
+    case WiFiState::Backoff:
+        statusLed->setRetryIndicator();
+        break;
+    default:
+        statusLed->setDisconnectedIndicator();
+        break;
+    }
+}
+
+void WiFiManager::startAttempt(bool useCache)
+{
+    fastAttempt = useCache && cacheValid && cache.channel != 0;
+    leaseCheck = false;
+    setState(WiFiState::Connecting);
+
+    WiFi.disconnect();
+    // Events queued by the attempt we just abandoned are older than this
+    attemptStart = millis();
+    if (fastAttempt)
+    {
+        // Reuse the last lease too, so there is no DHCP round trip
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD, cache.channel, cache.bssid, true);
     }
     else
     {
-        Serial.println("Failed to connect to WiFi!");
-        printWiFiStatus();
-        return false;
+        WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
     }
 }
 
+// ARP work for the lease check, run on the lwIP thread
+struct LeaseProbe
+{
+    struct tcpip_api_call_data call; // must come first
+    bool send;                       // send the requests, or read what came back
+    uint32_t ip;
+    uint32_t gateway;
+    bool conflict;
+    bool gatewaySeen;
+};
+
+static err_t runLeaseProbe(struct tcpip_api_call_data *call)
+{
+    LeaseProbe *probe = (LeaseProbe *)call;
+    struct netif *netif = (struct netif *)esp_netif_get_netif_impl(esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"));
+    if (!netif)
+        return ERR_IF;
+
+    ip4_addr_t ip, gateway;
+    ip4_addr_set_u32(&ip, probe->ip);
+    ip4_addr_set_u32(&gateway, probe->gateway);
+    if (probe->send)
+    {
+        // A host that holds our address answers a request for it, and lwIP
+        // files that answer in the ARP table like any other
+        etharp_request(netif, &ip);
+        etharp_request(netif, &gateway);
+        return ERR_OK;
+    }
+
+    struct eth_addr *mac;
+    const ip4_addr_t *entry;
+    probe->conflict = etharp_find_addr(netif, &ip, &mac, &entry) >= 0;
+    probe->gatewaySeen = etharp_find_addr(netif, &gateway, &mac, &entry) >= 0;
+    return ERR_OK;
+}
+
+// The cached lease may have expired and been handed to another host; GOT_IP
+// fires for a static config either way, so check before using it
+void WiFiManager::startLeaseCheck()
+{
+    LeaseProbe probe;
+    memset(&probe, 0, sizeof(probe));
+    probe.send = true;
+    probe.ip = cache.ip;
+    probe.gateway = cache.gateway;
+    tcpip_api_call(runLeaseProbe, &probe.call);
+    leaseCheck = true;
+    leaseCheckAt = millis() + WIFI_LEASE_CHECK_TIME;
+}
+
+void WiFiManager::finishLeaseCheck()
+{
+    LeaseProbe probe;
+    memset(&probe, 0, sizeof(probe));
+    probe.ip = cache.ip;
+    probe.gateway = cache.gateway;
+    leaseCheck = false;
+    if (tcpip_api_call(runLeaseProbe, &probe.call) == ERR_OK && !probe.conflict && probe.gatewaySeen)
+    {
+        onConnected();
+        return;
+    }
+    Serial.printf("Cached lease not confirmed (%s)\n", probe.conflict ? "address in use" : "no gateway");
+    onAttemptFailed(); // drops the cache and retries with DHCP
+}
+
+void WiFiManager::onConnected()
+{
+    unsigned long elapsed = millis() - outageStart;
+    setState(WiFiState::Connected);
+    backoff = WIFI_RETRY_MIN_INTERVAL;
+    if (fastAttempt)
+        fastConnectCount++;
+    else
+        fullConnectCount++;
+
+    if (!everConnected)
+    {
+        bootConnectMs = elapsed;
+        everConnected = true;
+        Serial.printf("WiFi connected in %lu ms (%s)\n", elapsed, fastAttempt ? "cached" : "scan");
+    }
+    else
+    {
+        lastReconnectMs = elapsed;
+        reconnectCount++;
+        Serial.printf("WiFi reconnected in %lu ms (%s)\n", elapsed, fastAttempt ? "cached" : "scan");
+    }
+
+    saveCache();
+    printConnectionInfo();
+    if (!otaReady)
+    {
+        setupOTA();
+        otaReady = true;
+    }
+}
+
+void WiFiManager::onAttemptFailed()
+{
+    if (fastAttempt)
+    {
+        // AP moved channel or the lease is stale; forget it and scan
+        Serial.println("Cached WiFi parameters failed, scanning");
+        cacheValid = false;
+        rtcCache.magic = 0;
+        startAttempt(false);
+        return;
+    }
+
+    printWiFiStatus();
+    setState(WiFiState::Backoff);
+    retryAt = millis() + backoff;
+    backoff = backoff * 2 > RECONNECT_INTERVAL ? RECONNECT_INTERVAL : backoff * 2;
+}
+
+void WiFiManager::init()
+{
+    WiFi.persistent(false); // we keep our own cache; skip the SDK's flash writes
+    WiFi.setAutoReconnect(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info)
+                 { onEvent(event, info); });
+
+    loadCache();
+    Serial.printf("Connecting to WiFi: %s%s\n", WIFI_SSID, cacheValid ? " (cached channel/BSSID)" : "");
+    outageStart = millis();
+    startAttempt(true);
+}
+
 void WiFiManager::handleConnection()
 {
-    ArduinoOTA.handle();
+    if (otaReady)
+        ArduinoOTA.handle();
 
-    if (WiFi.status() != WL_CONNECTED)
+    EventRecord record;
+    while (events.pop(record))
     {
-        unsigned long currentMillis = millis();
-        if (currentMillis - lastReconnectAttempt > RECONNECT_INTERVAL)
+        if ((long)(record.at - attemptStart) < 0)
+            continue; // from an attempt we already gave up on
+        switch (record.id)
         {
-            Serial.println("WiFi connection lost! Reconnecting...");
-            WiFi.disconnect();
-            WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-            lastReconnectAttempt = currentMillis;
+        case WIFI_EVENT_CONNECTED:
+            pendingChannel = record.channel;
+            memcpy(pendingBssid, record.bssid, sizeof(pendingBssid));
+            break;
+        case WIFI_EVENT_GOT_IP:
+            if (state == WiFiState::Connected || leaseCheck)
+                break;
+            if (fastAttempt)
+                startLeaseCheck();
+            else
+                onConnected();
+            break;
+        case WIFI_EVENT_DISCONNECTED:
+            if (record.reason == WIFI_REASON_ASSOC_LEAVE)
+                break;
+            if (state == WiFiState::Connected)
+            {
+                // Same AP is the likely target; go straight back to it
+                Serial.printf("WiFi connection lost (reason %u), reconnecting\n", record.reason);
+                outageStart = millis();
+                startAttempt(true);
+            }
+            else if (state == WiFiState::Connecting)
+            {
+                onAttemptFailed();
+            }
+            break;
         }
     }
+
+    unsigned long now = millis();
+    if (state == WiFiState::Connecting && leaseCheck)
+    {
+        if ((long)(now - leaseCheckAt) >= 0)
+            finishLeaseCheck();
+    }
+    else if (state == WiFiState::Connecting)
+    {
+        unsigned long limit = fastAttempt ? WIFI_FAST_CONNECT_TIMEOUT : WIFI_FULL_CONNECT_TIMEOUT;
+        if (now - attemptStart >= limit)
+            onAttemptFailed();
+    }
+    else if (state == WiFiState::Backoff && (long)(now - retryAt) >= 0)
+    {
+        startAttempt(true);
+    }
 }
 
 bool WiFiManager::isConnected()
 {
-    return WiFi.status() == WL_CONNECTED;
+    return state == WiFiState::Connected;
 }
 
 void WiFiManager::printConnectionInfo()
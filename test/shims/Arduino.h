@@ -0,0 +1,83 @@
+#ifndef NATIVE_ARDUINO_SHIM_H
+#define NATIVE_ARDUINO_SHIM_H
+
+// Just enough of Arduino.h for the modules built in [env:native]: a String
+// over std::string with the calls those modules make, a millis() that
+// tests and simulations set by hand, and the FreeRTOS types their headers
+// name. Not a general Arduino emulation.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+inline uint32_t &nativeMillis()
+{
+    static uint32_t now = 0;
+    return now;
+}
+
+inline unsigned long millis() { return nativeMillis(); }
+
+typedef void *TaskHandle_t;
+typedef struct
+{
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+class String
+{
+private:
+    std::string text;
+
+public:
+    String() {}
+    String(const char *s) : text(s ? s : "") {}
+    String(const std::string &s) : text(s) {}
+    explicit String(long value) : text(std::to_string(value)) {}
+    explicit String(unsigned long value) : text(std::to_string(value)) {}
+    explicit String(int value) : text(std::to_string(value)) {}
+    explicit String(unsigned value) : text(std::to_string(value)) {}
+
+    const char *c_str() const { return text.c_str(); }
+    unsigned length() const { return text.size(); }
+    long toInt() const { return atol(text.c_str()); }
+    int indexOf(const String &s, unsigned from = 0) const
+    {
+        size_t pos = text.find(s.text, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned from) const { return String(from < text.size() ? text.substr(from) : std::string()); }
+    String substring(unsigned from, unsigned to) const
+    {
+        return String(from < text.size() && to > from ? text.substr(from, to - from) : std::string());
+    }
+    bool concat(const char *s, unsigned n)
+    {
+        text.append(s, n);
+        return true;
+    }
+
+    String &operator+=(const String &s)
+    {
+        text += s.text;
+        return *this;
+    }
+    String &operator+=(const char *s)
+    {
+        text += s;
+        return *this;
+    }
+    bool operator==(const String &s) const { return text == s.text; }
+
+    friend String operator+(const String &a, const String &b) { return String(a.text + b.text); }
+    friend String operator+(const String &a, const char *b) { return String(a.text + b); }
+    friend String operator+(const char *a, const String &b) { return String(a + b.text); }
+};
+
+#endif // NATIVE_ARDUINO_SHIM_H
@@ -0,0 +1,52 @@
+#ifndef NATIVE_FS_SHIM_H
+#define NATIVE_FS_SHIM_H
+
+// File for [env:native], over a byte string shared with the in-memory
+// SPIFFS, with the calls the native-built modules make
+
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+class File
+{
+private:
+    std::shared_ptr<std::string> data;
+    size_t position;
+    bool append;
+
+public:
+    File() : position(0), append(false) {}
+    File(std::shared_ptr<std::string> file, bool appendOnly) : data(file), position(0), append(appendOnly) {}
+
+    explicit operator bool() const { return data != nullptr; }
+    size_t size() const { return data ? data->size() : 0; }
+    bool seek(size_t to)
+    {
+        if (!data || to > data->size())
+            return false;
+        position = to;
+        return true;
+    }
+    size_t write(const uint8_t *buf, size_t length)
+    {
+        if (!data)
+            return 0;
+        if (append)
+            position = data->size();
+        data->replace(position, length, (const char *)buf, length);
+        position += length;
+        return length;
+    }
+    size_t read(uint8_t *buf, size_t length)
+    {
+        if (!data || position >= data->size())
+            return 0;
+        size_t n = data->copy((char *)buf, length, position);
+        position += n;
+        return n;
+    }
+    void close() { data.reset(); }
+};
+
+#endif // NATIVE_FS_SHIM_H
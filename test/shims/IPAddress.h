@@ -0,0 +1,21 @@
+#ifndef NATIVE_IPADDRESS_SHIM_H
+#define NATIVE_IPADDRESS_SHIM_H
+
+#include <stdint.h>
+
+// config.h declares the network settings as IPAddress; nothing built in
+// [env:native] uses them
+class IPAddress
+{
+private:
+    uint32_t address;
+
+public:
+    IPAddress() : address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : address(a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+
+    operator uint32_t() const { return address; }
+};
+
+#endif // NATIVE_IPADDRESS_SHIM_H
@@ -0,0 +1,40 @@
+#ifndef NATIVE_SPIFFS_SHIM_H
+#define NATIVE_SPIFFS_SHIM_H
+
+// In-memory SPIFFS for [env:native]: files are byte strings keyed by path.
+// Tests can drop or corrupt files through SPIFFS.files.
+
+#include <map>
+#include <memory>
+#include <string>
+#include "FS.h"
+
+class NativeSPIFFS
+{
+public:
+    std::map<std::string, std::shared_ptr<std::string>> files;
+
+    bool exists(const char *path) const { return files.count(path) > 0; }
+    bool remove(const char *path) { return files.erase(path) > 0; }
+    File open(const char *path, const char *mode)
+    {
+        auto found = files.find(path);
+        if (mode[0] == 'r')
+            return found == files.end() ? File() : File(found->second, false);
+        if (mode[0] == 'w' || found == files.end())
+            found = files.insert(std::make_pair(std::string(path), std::make_shared<std::string>())).first;
+        if (mode[0] == 'w')
+            found->second->clear();
+        return File(found->second, mode[0] == 'a');
+    }
+};
+
+inline NativeSPIFFS &nativeSPIFFS()
+{
+    static NativeSPIFFS fs;
+    return fs;
+}
+
+#define SPIFFS nativeSPIFFS()
+
+#endif // NATIVE_SPIFFS_SHIM_H
@@ -0,0 +1,318 @@
+// The /sensorData table through JsonWriter and BinaryWriter on the host:
+// CBOR and MessagePack output decoded back to the table's values, payload
+// size per format, and encode time per table.
+//
+//   pio test -e native -f test_encoders -v
+//
+// The decoder below covers only what BinaryWriter emits (maps, strings,
+// integers, 32-bit floats). Its timing is a rough guide to what a client
+// spends, not a measurement of any real client library.
+
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include "sensor_manager.h"
+
+#define BENCH_ITERATIONS 20000
+#define TABLE_BUFFER (MAX_TRACKED_SENSORS * SENSOR_BINARY_ENTRY_MAX + 8)
+
+static SensorTable table;
+static uint8_t binary[TABLE_BUFFER];
+static char text[HTTP_ARENA_SIZE];
+
+// count senders with values at the edges of what the schema stores
+static void fillTable(int count)
+{
+    memset(&table, 0, sizeof(table));
+    table.count = count;
+    for (int i = 0; i < count; i++)
+    {
+        table.ip[i] = 0x0001A8C0u | (uint32_t)(200 + i) << 24; // 192.168.1.200 up
+        snprintf(table.clientId[i], SENSOR_CLIENT_ID_LEN, "%d", i % 16);
+        table.channels[SENSOR_CHANNEL_Touch][i] = i & 1;
+        table.channels[SENSOR_CHANNEL_BatteryVoltage][i] = i == 0 ? 36300 : 3200 + i * 31; // 11:1 divider full scale
+        table.channels[SENSOR_CHANNEL_BatteryPercent][i] = i == 1 ? -5 : 1000 - i * 27;
+    }
+}
+
+// ========================= DECODER =========================
+
+class Reader
+{
+private:
+    BinaryFormat format;
+    const uint8_t *p;
+    const uint8_t *end;
+
+    uint8_t byte()
+    {
+        TEST_ASSERT_TRUE(p < end);
+        return *p++;
+    }
+
+    uint32_t bigEndian(size_t bytes)
+    {
+        uint32_t v = 0;
+        for (size_t i = 0; i < bytes; i++)
+            v = v << 8 | byte();
+        return v;
+    }
+
+    // CBOR initial byte: major type and argument
+    uint32_t cborArgument(uint8_t head)
+    {
+        uint8_t info = head & 0x1F;
+        if (info < 24)
+            return info;
+        TEST_ASSERT_TRUE(info <= 26);
+        return bigEndian((size_t)1 << (info - 24));
+    }
+
+    float toFloat(uint32_t bits)
+    {
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+public:
+    Reader(BinaryFormat format, const uint8_t *data, size_t length) : format(format), p(data), end(data + length) {}
+
+    bool atEnd() const { return p == end; }
+
+    size_t map()
+    {
+        uint8_t head = byte();
+        if (format == BinaryFormat::Cbor)
+        {
+            TEST_ASSERT_EQUAL(5, head >> 5);
+            return cborArgument(head);
+        }
+        if ((head & 0xF0) == 0x80)
+            return head & 0x0F;
+        TEST_ASSERT_EQUAL_HEX8(0xDE, head);
+        return bigEndian(2);
+    }
+
+    std::string string()
+    {
+        uint8_t head = byte();
+        size_t n;
+        if (format == BinaryFormat::Cbor)
+        {
+            TEST_ASSERT_EQUAL(3, head >> 5);
+            n = cborArgument(head);
+        }
+        else if ((head & 0xE0) == 0xA0)
+            n = head & 0x1F;
+        else if (head == 0xD9)
+            n = byte();
+        else
+        {
+            TEST_ASSERT_EQUAL_HEX8(0xDA, head);
+            n = bigEndian(2);
+        }
+        TEST_ASSERT_TRUE(n <= (size_t)(end - p));
+        std::string s((const char *)p, n);
+        p += n;
+        return s;
+    }
+
+    // A number as the writer sent it: integers exactly, floats as float
+    double number(bool &isFloat)
+    {
+        uint8_t head = byte();
+        isFloat = false;
+        if (format == BinaryFormat::Cbor)
+        {
+            if (head == 0xFA)
+            {
+                isFloat = true;
+                return toFloat(bigEndian(4));
+            }
+            uint8_t major = head >> 5;
+            TEST_ASSERT_TRUE(major <= 1);
+            uint32_t v = cborArgument(head);
+            return major == 0 ? (double)v : -1.0 - v;
+        }
+        if (head < 0x80)
+            return head;
+        if (head >= 0xE0)
+            return (int8_t)head;
+        switch (head)
+        {
+        case 0xCA:
+            isFloat = true;
+            return toFloat(bigEndian(4));
+        case 0xCC:
+            return byte();
+        case 0xCD:
+            return bigEndian(2);
+        case 0xCE:
+            return bigEndian(4);
+        case 0xD0:
+            return (int8_t)byte();
+        case 0xD1:
+            return (int16_t)bigEndian(2);
+        case 0xD2:
+            return (int32_t)bigEndian(4);
+        }
+        TEST_FAIL_MESSAGE("not a number");
+        return 0;
+    }
+};
+
+static std::string dottedQuad(uint32_t address)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (unsigned)(address & 0xFF), (unsigned)((address >> 8) & 0xFF),
+             (unsigned)((address >> 16) & 0xFF), (unsigned)(address >> 24));
+    return buf;
+}
+
+static int channelFor(const std::string &key)
+{
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        if (key == SENSOR_CHANNEL_INFO[ch].key)
+            return ch;
+    }
+    return -1;
+}
+
+// Walks the whole payload and checks every value against the table
+static void decodeAndCompare(BinaryFormat format, const uint8_t *data, size_t length)
+{
+    Reader in(format, data, length);
+    TEST_ASSERT_EQUAL(table.count, in.map());
+    for (int i = 0; i < table.count; i++)
+    {
+        TEST_ASSERT_EQUAL_STRING(dottedQuad(table.ip[i]).c_str(), in.string().c_str());
+        size_t members = in.map();
+        TEST_ASSERT_EQUAL(1 + SENSOR_CHANNEL_COUNT, members);
+        TEST_ASSERT_EQUAL_STRING("clientId", in.string().c_str());
+        TEST_ASSERT_EQUAL_STRING(table.clientId[i], in.string().c_str());
+        for (size_t m = 1; m < members; m++)
+        {
+            int ch = channelFor(in.string());
+            TEST_ASSERT_TRUE(ch >= 0);
+            bool isFloat;
+            double v = in.number(isFloat);
+            uint8_t decimals = SENSOR_CHANNEL_INFO[ch].decimals;
+            TEST_ASSERT_EQUAL(decimals > 0, isFloat);
+            // A float carries the fixed-point value to within rounding
+            TEST_ASSERT_EQUAL(table.channels[ch][i], (int32_t)lround(v * pow(10.0, decimals)));
+        }
+    }
+    TEST_ASSERT_TRUE(in.atEnd());
+}
+
+// ========================= TESTS =========================
+
+static size_t encode(BinaryFormat format)
+{
+    BinaryWriter out(format, binary, sizeof(binary));
+    SensorManager::writeSensorTable(out, table);
+    TEST_ASSERT_TRUE(out.ok());
+    return out.length();
+}
+
+static size_t encodeJson()
+{
+    JsonWriter json(text, sizeof(text));
+    SensorManager::writeSensorTable(json, table);
+    TEST_ASSERT_TRUE(json.ok());
+    return json.length();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_round_trip()
+{
+    for (int count = 0; count <= MAX_TRACKED_SENSORS; count += 7)
+    {
+        fillTable(count);
+        size_t length = encode(BinaryFormat::Cbor);
+        TEST_ASSERT_TRUE(length <= (size_t)count * SENSOR_BINARY_ENTRY_MAX + 8);
+        decodeAndCompare(BinaryFormat::Cbor, binary, length);
+
+        length = encode(BinaryFormat::MsgPack);
+        TEST_ASSERT_TRUE(length <= (size_t)count * SENSOR_BINARY_ENTRY_MAX + 8);
+        decodeAndCompare(BinaryFormat::MsgPack, binary, length);
+    }
+}
+
+// Same table as JSON, for the size comparison below
+void test_json_values()
+{
+    fillTable(2);
+    encodeJson();
+    TEST_ASSERT_EQUAL_STRING("{\"192.168.1.200\":{\"clientId\":\"0\",\"touch\":0,\"batteryVoltage\":36.300,"
+                             "\"batteryPercent\":100.0},\"192.168.1.201\":{\"clientId\":\"1\",\"touch\":1,"
+                             "\"batteryVoltage\":3.231,\"batteryPercent\":-0.5}}",
+                             text);
+}
+
+typedef size_t (*Encode)();
+
+static size_t encodeCbor() { return encode(BinaryFormat::Cbor); }
+static size_t encodeMsgPack() { return encode(BinaryFormat::MsgPack); }
+
+static double encodeNs(Encode run)
+{
+    size_t sink = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+        sink += run();
+    TEST_ASSERT_TRUE(sink > 0);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / BENCH_ITERATIONS;
+}
+
+static double decodeNs(BinaryFormat format, size_t length)
+{
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ITERATIONS / 10; i++)
+        decodeAndCompare(format, binary, length);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() /
+           (BENCH_ITERATIONS / 10);
+}
+
+void test_size_and_encode_time()
+{
+    fillTable(MAX_TRACKED_SENSORS);
+    size_t jsonBytes = encodeJson();
+    size_t cborBytes = encode(BinaryFormat::Cbor);
+    size_t msgPackBytes = encode(BinaryFormat::MsgPack);
+    // Binary drops the quotes, colons and commas, and the decimals of each float
+    TEST_ASSERT_TRUE(cborBytes < jsonBytes);
+    TEST_ASSERT_TRUE(msgPackBytes < jsonBytes);
+
+    double jsonNs = encodeNs(encodeJson);
+    double cborNs = encodeNs(encodeCbor);
+    double msgPackNs = encodeNs(encodeMsgPack);
+    double msgPackDecodeNs = decodeNs(BinaryFormat::MsgPack, msgPackBytes);
+    encode(BinaryFormat::Cbor);
+    double cborDecodeNs = decodeNs(BinaryFormat::Cbor, cborBytes);
+
+    char line[120];
+    snprintf(line, sizeof(line), "%d senders: JSON %u bytes, CBOR %u, MessagePack %u", MAX_TRACKED_SENSORS,
+             (unsigned)jsonBytes, (unsigned)cborBytes, (unsigned)msgPackBytes);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "encode: JSON %.0f ns, CBOR %.0f ns, MessagePack %.0f ns (host, not ESP32)", jsonNs,
+             cborNs, msgPackNs);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "decode and check: CBOR %.0f ns, MessagePack %.0f ns", cborDecodeNs, msgPackDecodeNs);
+    TEST_MESSAGE(line);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_json_values);
+    RUN_TEST(test_size_and_encode_time);
+    return UNITY_END();
+}
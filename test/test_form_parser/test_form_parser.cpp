@@ -0,0 +1,288 @@
+// FormParser on the host: known bodies, a seeded fuzz of random and mutated
+// bodies, and parse time per /sensor body and /sensorBatch entry.
+//
+//   pio test -e native -f test_form_parser -v
+//
+// Each fuzz input is parsed from a heap copy of exactly its length, so a
+// build with -fsanitize=address,undefined also reports any read past the end.
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "form_parser.h"
+
+#define FUZZ_ITERATIONS 200000
+#define BENCH_ITERATIONS 1000000
+
+static const char TYPICAL_BODY[] = "clientId=3&touch=1&batteryVoltage=3.712&batteryPercent=87.5"
+                                   "&capturedAt=123456&sentAt=123470&rtt=21&seq=4000000000";
+
+static uint32_t rngState = 0x2545F491;
+
+// xorshift32: the same inputs on every run
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_parses_sensor_form()
+{
+    SensorForm form;
+    TEST_ASSERT_TRUE(FormParser::parseSensorForm(TYPICAL_BODY, strlen(TYPICAL_BODY), form) == FormResult::Ok);
+    TEST_ASSERT_EQUAL_STRING("3", form.clientId);
+    TEST_ASSERT_EQUAL(1, form.channels[SENSOR_CHANNEL_Touch]);
+    TEST_ASSERT_EQUAL(3712, form.channels[SENSOR_CHANNEL_BatteryVoltage]);
+    TEST_ASSERT_EQUAL(875, form.channels[SENSOR_CHANNEL_BatteryPercent]);
+    TEST_ASSERT_EQUAL(123456, form.capturedAt);
+    TEST_ASSERT_EQUAL(123470, form.sentAt);
+    TEST_ASSERT_EQUAL(21, form.rttMs);
+    TEST_ASSERT_EQUAL(4000000000u, form.seq);
+    TEST_ASSERT_EQUAL(FORM_FIELD_CLIENT_ID | FORM_FIELD_CAPTURED_AT | FORM_FIELD_SENT_AT | FORM_FIELD_RTT | FORM_FIELD_SEQ,
+                      form.fields);
+
+    // Extra fraction digits truncate, missing ones pad; unknown keys are skipped
+    const char *body = "batteryVoltage=3.7&batteryPercent=-1.25&clientId=a%20b+c&future=x";
+    TEST_ASSERT_TRUE(FormParser::parseSensorForm(body, strlen(body), form) == FormResult::Ok);
+    TEST_ASSERT_EQUAL(3700, form.channels[SENSOR_CHANNEL_BatteryVoltage]);
+    TEST_ASSERT_EQUAL(-12, form.channels[SENSOR_CHANNEL_BatteryPercent]);
+    TEST_ASSERT_EQUAL_STRING("a b c", form.clientId);
+}
+
+void test_rejects_malformed()
+{
+    static const char *const invalid[] = {
+        "clientId=1&touch",             // no '='
+        "clientId=1&touch=",            // empty number
+        "clientId=1&touch=1x",          // trailing junk
+        "clientId=1&touch=-",           // sign only
+        "clientId=1&touch=1234567890",  // over FORM_MAX_DIGITS
+        "clientId=1&batteryVoltage=1234567.0",
+        "clientId=1&sentAt=4294967296", // over uint32_t
+        "clientId=1&seq=+1",
+        "clientId=%4",                  // short escape
+        "clientId=%zz",
+        "clientId=0123456789abcdef",    // does not fit with its terminator
+    };
+    SensorForm form;
+    for (const char *body : invalid)
+    {
+        if (FormParser::parseSensorForm(body, strlen(body), form) != FormResult::Invalid)
+        {
+            TEST_MESSAGE(body);
+            TEST_ASSERT_TRUE_MESSAGE(false, "accepted a malformed body");
+        }
+    }
+    TEST_ASSERT_TRUE(FormParser::parseSensorForm("touch=1", 7, form) == FormResult::Missing);
+    TEST_ASSERT_TRUE(FormParser::parseSensorForm("", 0, form) == FormResult::Missing);
+
+    int32_t value;
+    TEST_ASSERT_TRUE(FormParser::findInt("a=1&clientId=12", 15, "clientId", value) == FormResult::Ok);
+    TEST_ASSERT_EQUAL(12, value);
+    TEST_ASSERT_TRUE(FormParser::findInt("clientId=x", 10, "clientId", value) == FormResult::Invalid);
+    TEST_ASSERT_TRUE(FormParser::findInt("client=1", 8, "clientId", value) == FormResult::Missing);
+}
+
+void test_parses_batch()
+{
+    const char *body = "clientId=7&sentAt=5000&seq=9&samples=1000,1,3.700,50.0;2000,0,3.690,49.5";
+    SensorBatchForm batch;
+    TEST_ASSERT_TRUE(FormParser::parseSensorBatch(body, strlen(body), batch) == FormResult::Ok);
+    TEST_ASSERT_EQUAL(5000, batch.sentAt);
+    TEST_ASSERT_EQUAL(9, batch.seq);
+
+    const char *cursor = batch.samples;
+    const char *end = batch.samples + batch.samplesLength;
+    BatchEntry entry;
+    TEST_ASSERT_TRUE(FormParser::nextBatchEntry(cursor, end, entry) == FormResult::Ok);
+    TEST_ASSERT_EQUAL(1000, entry.capturedAt);
+    TEST_ASSERT_EQUAL(3700, entry.channels[SENSOR_CHANNEL_BatteryVoltage]);
+    TEST_ASSERT_TRUE(FormParser::nextBatchEntry(cursor, end, entry) == FormResult::Ok);
+    TEST_ASSERT_EQUAL(2000, entry.capturedAt);
+    TEST_ASSERT_EQUAL(495, entry.channels[SENSOR_CHANNEL_BatteryPercent]);
+    TEST_ASSERT_TRUE(FormParser::nextBatchEntry(cursor, end, entry) == FormResult::Missing);
+
+    const char *shortEntry = "1000,1,3.7";
+    cursor = shortEntry;
+    TEST_ASSERT_TRUE(FormParser::nextBatchEntry(cursor, shortEntry + strlen(shortEntry), entry) == FormResult::Invalid);
+    TEST_ASSERT_TRUE(FormParser::parseSensorBatch("clientId=7&sentAt=1", 19, batch) == FormResult::Missing);
+}
+
+// Formats value / 10^decimals the way a client would
+static std::string formatFixed(int32_t value, uint8_t decimals)
+{
+    uint32_t magnitude = value < 0 ? -(uint32_t)value : value;
+    std::string text = std::to_string(magnitude);
+    if (text.size() <= decimals)
+        text.insert(0, decimals + 1 - text.size(), '0');
+    if (decimals > 0)
+        text.insert(text.size() - decimals, ".");
+    return (value < 0 ? "-" : "") + text;
+}
+
+void test_fuzz_round_trip()
+{
+    for (int i = 0; i < FUZZ_ITERATIONS / 4; i++)
+    {
+        int32_t channels[SENSOR_CHANNEL_COUNT];
+        std::string body = "clientId=" + std::to_string(nextRandom() % 16);
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        {
+            // Anything with at most FORM_MAX_DIGITS digits in total
+            channels[ch] = (int32_t)(nextRandom() % 1000000000) * (nextRandom() & 1 ? -1 : 1);
+            body += std::string("&") + SENSOR_CHANNEL_INFO[ch].key + "=" + formatFixed(channels[ch], SENSOR_CHANNEL_INFO[ch].decimals);
+        }
+        uint32_t seq = nextRandom();
+        body += "&seq=" + std::to_string(seq);
+
+        SensorForm form;
+        if (FormParser::parseSensorForm(body.data(), body.size(), form) != FormResult::Ok)
+        {
+            TEST_MESSAGE(body.c_str());
+            TEST_ASSERT_TRUE_MESSAGE(false, "rejected a valid body");
+        }
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+            TEST_ASSERT_EQUAL(channels[ch], form.channels[ch]);
+        TEST_ASSERT_EQUAL(seq, form.seq);
+    }
+}
+
+// Random edits biased toward the bytes the parser branches on
+static void mutate(std::string &body)
+{
+    static const char alphabet[] = "=&;,.-+%0123456789afAFclientIdtouchsamples";
+    int edits = 1 + nextRandom() % 4;
+    for (int e = 0; e < edits; e++)
+    {
+        size_t at = body.empty() ? 0 : nextRandom() % (body.size() + 1);
+        char c = nextRandom() % 4 == 0 ? (char)nextRandom() : alphabet[nextRandom() % (sizeof(alphabet) - 1)];
+        switch (nextRandom() % 4)
+        {
+        case 0:
+            body.insert(at, 1, c);
+            break;
+        case 1:
+            if (at < body.size())
+                body[at] = c;
+            break;
+        case 2:
+            if (at < body.size())
+                body.erase(at, 1 + nextRandom() % 8);
+            break;
+        default:
+            body.resize(at);
+            break;
+        }
+    }
+}
+
+static void parseExactCopy(const std::string &body, uint32_t &accepted)
+{
+    char *copy = (char *)malloc(body.size() + 1); // +1 so an empty body has an address
+    memcpy(copy, body.data(), body.size());
+
+    SensorForm form;
+    if (FormParser::parseSensorForm(copy, body.size(), form) == FormResult::Ok)
+    {
+        TEST_ASSERT_TRUE(memchr(form.clientId, '\0', sizeof(form.clientId)) != nullptr);
+        accepted++;
+    }
+
+    SensorBatchForm batch;
+    if (FormParser::parseSensorBatch(copy, body.size(), batch) == FormResult::Ok)
+    {
+        TEST_ASSERT_TRUE(batch.samples >= copy && batch.samples + batch.samplesLength <= copy + body.size());
+        const char *cursor = batch.samples;
+        const char *end = batch.samples + batch.samplesLength;
+        BatchEntry entry;
+        size_t entries = 0;
+        while (FormParser::nextBatchEntry(cursor, end, entry) == FormResult::Ok)
+        {
+            TEST_ASSERT_TRUE(cursor <= end);
+            TEST_ASSERT_TRUE(++entries <= batch.samplesLength);
+        }
+    }
+
+    int32_t value;
+    FormParser::findInt(copy, body.size(), "clientId", value);
+    free(copy);
+}
+
+void test_fuzz_mutations()
+{
+    static const char *const seeds[] = {
+        TYPICAL_BODY,
+        "clientId=7&sentAt=5000&seq=9&rtt=30&samples=1000,1,3.700,50.0;2000,0,3.690,49.5;3000,1,3.680,49.0",
+        "clientId=%41%42&touch=0",
+    };
+    uint32_t accepted = 0;
+    for (int i = 0; i < FUZZ_ITERATIONS; i++)
+    {
+        std::string body = seeds[nextRandom() % 3];
+        mutate(body);
+        parseExactCopy(body, accepted);
+
+        // Pure noise as well, short enough to hit the end-of-input paths
+        std::string noise(nextRandom() % 24, '\0');
+        for (char &c : noise)
+            c = (char)nextRandom();
+        parseExactCopy(noise, accepted);
+    }
+    char line[80];
+    snprintf(line, sizeof(line), "%d mutated and %d random bodies, %lu /sensor forms accepted",
+             FUZZ_ITERATIONS, FUZZ_ITERATIONS, (unsigned long)accepted);
+    TEST_MESSAGE(line);
+}
+
+void test_benchmark()
+{
+    SensorForm form;
+    uint32_t sink = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        FormParser::parseSensorForm(TYPICAL_BODY, sizeof(TYPICAL_BODY) - 1, form);
+        sink += form.seq;
+    }
+    double formNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / BENCH_ITERATIONS;
+
+    // A full OFFLINE_BATCH_SIZE batch
+    std::string samples;
+    for (int i = 0; i < 32; i++)
+        samples += (i ? ";" : "") + std::to_string(100000 + i * 200) + ",1,3.712,87.5";
+    started = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ITERATIONS / 32; i++)
+    {
+        const char *cursor = samples.data();
+        BatchEntry entry;
+        while (FormParser::nextBatchEntry(cursor, samples.data() + samples.size(), entry) == FormResult::Ok)
+            sink += entry.capturedAt;
+    }
+    double entryNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / (BENCH_ITERATIONS / 32 * 32);
+
+    char line[96];
+    snprintf(line, sizeof(line), "/sensor body (%u bytes): %.0f ns; batch entry: %.0f ns (host, not ESP32)",
+             (unsigned)(sizeof(TYPICAL_BODY) - 1), formNs, entryNs);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(sink != 0);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parses_sensor_form);
+    RUN_TEST(test_rejects_malformed);
+    RUN_TEST(test_parses_batch);
+    RUN_TEST(test_fuzz_round_trip);
+    RUN_TEST(test_fuzz_mutations);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
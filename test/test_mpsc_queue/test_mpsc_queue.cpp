@@ -0,0 +1,123 @@
+// MpscQueue on the host: ordering, no loss or duplication under several
+// producer threads, and push/pop throughput for 1 to 4 producers.
+//
+//   pio test -e native -f test_mpsc_queue -v
+
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include "lockfree_queue.h"
+
+#define BENCH_ITEMS_PER_PRODUCER 1000000
+#define BENCH_QUEUE_SIZE 256 // as INGEST_QUEUE_SIZE
+
+struct Item
+{
+    uint32_t producer;
+    uint32_t index;
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_fifo_and_full()
+{
+    static MpscQueue<Item, 8> queue;
+    Item item;
+    TEST_ASSERT_FALSE(queue.pop(item));
+
+    for (uint32_t i = 0; i < 8; i++)
+        TEST_ASSERT_TRUE(queue.push(Item{0, i}));
+    TEST_ASSERT_FALSE(queue.push(Item{0, 8}));
+    TEST_ASSERT_EQUAL(8, queue.size());
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        TEST_ASSERT_TRUE(queue.pop(item));
+        TEST_ASSERT_EQUAL(i, item.index);
+    }
+    TEST_ASSERT_FALSE(queue.pop(item));
+    TEST_ASSERT_EQUAL(0, queue.size());
+
+    // Wraps around the ring
+    for (uint32_t round = 0; round < 5; round++)
+    {
+        TEST_ASSERT_TRUE(queue.push(Item{0, round}));
+        TEST_ASSERT_TRUE(queue.pop(item));
+        TEST_ASSERT_EQUAL(round, item.index);
+    }
+}
+
+// Runs producers against one consumer; returns items per second and fails
+// the test on a lost, duplicated or reordered item
+static double runProducers(uint32_t producers, uint32_t perProducer)
+{
+    static MpscQueue<Item, BENCH_QUEUE_SIZE> queue;
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        threads.push_back(std::thread([&, p]() {
+            while (!go.load())
+                std::this_thread::yield();
+            for (uint32_t i = 0; i < perProducer; i++)
+            {
+                while (!queue.push(Item{p, i}))
+                    std::this_thread::yield();
+            }
+        }));
+    }
+
+    std::vector<uint32_t> next(producers, 0);
+    uint64_t total = (uint64_t)producers * perProducer;
+    uint64_t received = 0;
+    bool inOrder = true;
+    auto started = std::chrono::steady_clock::now();
+    go.store(true);
+    Item item;
+    while (received < total)
+    {
+        if (!queue.pop(item))
+        {
+            std::this_thread::yield(); // single-core hosts
+            continue;
+        }
+        if (item.producer >= producers || item.index != next[item.producer])
+            inOrder = false;
+        else
+            next[item.producer]++;
+        received++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (std::thread &thread : threads)
+        thread.join();
+
+    TEST_ASSERT_TRUE_MESSAGE(inOrder, "item lost, duplicated or out of producer order");
+    for (uint32_t p = 0; p < producers; p++)
+        TEST_ASSERT_EQUAL(perProducer, next[p]);
+    TEST_ASSERT_EQUAL(0, queue.size());
+    return total / seconds;
+}
+
+void test_multi_producer_throughput()
+{
+    for (uint32_t producers = 1; producers <= 4; producers++)
+    {
+        double rate = runProducers(producers, BENCH_ITEMS_PER_PRODUCER);
+        char line[96];
+        snprintf(line, sizeof(line), "%u producer(s): %.1f M items/s through a %d-slot ring",
+                 (unsigned)producers, rate / 1e6, BENCH_QUEUE_SIZE);
+        TEST_MESSAGE(line);
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_and_full);
+    RUN_TEST(test_multi_producer_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,198 @@
+// ResponseArena and JsonWriter on the host: the bodies of /sensorData,
+// /sensorStats, /latency, /slots and the JSON status replies, built over and
+// over in one arena the way the router does. After every request the arena
+// must be empty again, its high-water mark must stay where the first round
+// left it, and nothing may come from the heap.
+//
+//   pio test -e native -f test_response_arena -v
+
+#include <unity.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sensor_manager.h"
+#include "sensor_ingest.h"
+#include "slot_scheduler.h"
+
+#define ROUNDS 20000
+#define SMALL_TABLE 4 // stats and latency for this many senders fit the arena
+
+// Counts operator new, so the request loop can check it never allocates
+static size_t heapAllocations;
+
+void *operator new(size_t size)
+{
+    heapAllocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static ResponseArena arena;
+static SensorTable table;
+static SensorStatsTracker stats;
+static LatencyTracker latency;
+static SlotAllocator slots;
+
+// A table of count senders, each with a few seconds of traffic behind it
+static void fillTable(int count)
+{
+    memset(&table, 0, sizeof(table));
+    for (int i = 0; i < count; i++)
+    {
+        table.ip[i] = 0x0A000000u | (uint32_t)(i + 1) << 24;
+        snprintf(table.clientId[i], SENSOR_CLIENT_ID_LEN, "%d", i);
+        table.channels[SENSOR_CHANNEL_Touch][i] = i & 1;
+        table.channels[SENSOR_CHANNEL_BatteryVoltage][i] = 3712 + i;
+        table.channels[SENSOR_CHANNEL_BatteryPercent][i] = 875 - i;
+        stats.resetSlot(i);
+        latency.resetSlot(i);
+
+        for (uint32_t n = 0; n < 50; n++)
+        {
+            SensorSample sample;
+            memset(&sample, 0, sizeof(sample));
+            sample.ip = table.ip[i];
+            sample.receivedAt = 100000 + n * 200 + i;
+            sample.sentAt = sample.receivedAt - 5000 - (n % 7);
+            sample.capturedAt = sample.sentAt - 3;
+            sample.rttMs = 20 + n % 5;
+            sample.seq = 1000 + n + (n > 20); // one lost
+            sample.timing = SAMPLE_TIMING_SENT_AT | SAMPLE_TIMING_CAPTURED_AT | SAMPLE_TIMING_RTT | SAMPLE_TIMING_SEQ;
+            sample.channels[SENSOR_CHANNEL_Touch] = (n / 10) & 1;
+            sample.channels[SENSOR_CHANNEL_BatteryPercent] = 900 - n;
+            latency.recordIngest(i, sample, sample.receivedAt + 2);
+            stats.recordArrival(i, sample);
+            stats.recordValue(i, sample.channels, sample.receivedAt);
+        }
+        slots.assign(table.ip[i], i, 100000);
+    }
+    table.count = count;
+    latency.recordPush(table, 110000);
+}
+
+// Each returns whether the body fit, like the handlers' json.ok() check
+static bool buildSensorData()
+{
+    JsonWriter json(arena);
+    SensorManager::writeSensorTable(json, table);
+    return json.ok();
+}
+
+static bool buildSensorStats()
+{
+    JsonWriter json(arena);
+    json.beginObject();
+    for (int i = 0; i < table.count; i++)
+        SensorManager::writeSensorStats(json, table, stats.get(i), i);
+    json.endObject();
+    return json.ok();
+}
+
+static bool buildLatency()
+{
+    JsonWriter json(arena);
+    json.beginObject();
+    for (int i = 0; i < table.count; i++)
+        SensorManager::writeSensorLatency(json, table, latency.get(i), i);
+    json.endObject();
+    return json.ok();
+}
+
+static bool buildSlots()
+{
+    JsonWriter json(arena);
+    slots.writeJSON(json, 110000);
+    return json.ok();
+}
+
+// sendJsonResponse with an arena-formatted message, as /delete sends
+static bool buildStatus()
+{
+    const char *message = arena.format("File not found: %s", "/missing.html");
+    JsonWriter json(arena);
+    json.beginObject().field("success", false).field("message", message).endObject();
+    return json.ok() && *message;
+}
+
+typedef bool (*Build)();
+
+// Runs every builder ROUNDS times, resetting after each as handle() does.
+// Returns how many of them did not fit.
+static uint32_t serve(const Build *builds, size_t count, uint32_t expectFailures)
+{
+    uint32_t failures = 0;
+    size_t highWater = 0;
+    uint32_t overflows = arena.getOverflows();
+    size_t allocations = heapAllocations;
+    for (uint32_t round = 0; round < ROUNDS; round++)
+    {
+        for (size_t b = 0; b < count; b++)
+        {
+            if (!builds[b]())
+                failures++;
+            arena.reset();
+            TEST_ASSERT_EQUAL(0, arena.getUsed());
+        }
+        if (round == 0)
+            highWater = arena.getHighWater();
+    }
+    TEST_ASSERT_EQUAL(highWater, arena.getHighWater());
+    TEST_ASSERT_EQUAL(allocations, heapAllocations);
+    TEST_ASSERT_EQUAL(overflows + failures, arena.getOverflows());
+    TEST_ASSERT_EQUAL(expectFailures * ROUNDS, failures);
+    char line[64];
+    snprintf(line, sizeof(line), "%d senders: high water %u of %u bytes", table.count, (unsigned)highWater,
+             HTTP_ARENA_SIZE);
+    TEST_MESSAGE(line);
+    return failures;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_small_table_fits()
+{
+    static const Build builds[] = {buildSensorData, buildSensorStats, buildLatency, buildSlots, buildStatus};
+    fillTable(SMALL_TABLE);
+    serve(builds, sizeof(builds) / sizeof(builds[0]), 0);
+}
+
+// A full table outgrows the arena for stats and latency; those handlers then
+// stream, and the failed attempt must not leave anything behind
+void test_full_table_overflows_cleanly()
+{
+    static const Build builds[] = {buildSensorData, buildSensorStats, buildLatency, buildStatus};
+    fillTable(MAX_TRACKED_SENSORS);
+    serve(builds, sizeof(builds) / sizeof(builds[0]), 2);
+}
+
+// What a streamed response writes per chunk: one sender's object always
+// fits, so the chunked fallback can always make progress
+void test_one_sender_fits_a_chunk()
+{
+    fillTable(MAX_TRACKED_SENSORS);
+    char chunk[HTTP_TX_CHUNK_SIZE];
+    for (int i = 0; i < table.count; i++)
+    {
+        JsonWriter stat(chunk, sizeof(chunk));
+        SensorManager::writeSensorStats(stat, table, stats.get(i), i);
+        TEST_ASSERT_TRUE(stat.ok());
+        JsonWriter lat(chunk, sizeof(chunk));
+        SensorManager::writeSensorLatency(lat, table, latency.get(i), i);
+        TEST_ASSERT_TRUE(lat.ok());
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_small_table_fits);
+    RUN_TEST(test_full_table_overflows_cleanly);
+    RUN_TEST(test_one_sender_fits_a_chunk);
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+// Route lookup on the host: every line of WEB_ROUTE_TABLE resolves to its
+// own id, near misses do not, and webRouteMatch() is timed against the
+// linear scan AsyncHttpServer used before the table (method check, then
+// strlen + memcmp per route) over the same routes.
+//
+//   pio test -e native -f test_routes -v
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "web_routes.h"
+
+#define BENCH_ITERATIONS 1000000
+
+struct TableRoute
+{
+    int id;
+    HttpMethod method;
+    const char *path;
+};
+
+static const TableRoute ROUTES[] = {
+#define TEST_ROUTE(id, m, path, handler, upload) {WEB_ROUTE_##id, HttpMethod::m, path},
+    WEB_ROUTE_TABLE(TEST_ROUTE)
+#undef TEST_ROUTE
+};
+
+#define ROUTE_COUNT (sizeof(ROUTES) / sizeof(ROUTES[0]))
+
+// The lookup this table replaced
+static int linearMatch(HttpMethod method, const char *path, size_t pathLen)
+{
+    for (size_t i = 0; i < ROUTE_COUNT; i++)
+    {
+        const TableRoute &route = ROUTES[i];
+        if (route.method != HttpMethod::Any && route.method != method)
+            continue;
+        if (strlen(route.path) == pathLen && memcmp(route.path, path, pathLen) == 0)
+            return route.id;
+    }
+    return HTTP_NO_ROUTE;
+}
+
+// Requests that must not match: static files, prefixes and extensions of
+// routes, other case, a trailing slash and the wrong method
+struct Probe
+{
+    HttpMethod method;
+    const char *path;
+};
+
+static const Probe MISSES[] = {
+    {HttpMethod::Get, "/styles.css"},
+    {HttpMethod::Get, "/index.html"},
+    {HttpMethod::Get, ""},
+    {HttpMethod::Get, "/sensorDat"},
+    {HttpMethod::Get, "/sensorData/"},
+    {HttpMethod::Get, "/sensordata"},
+    {HttpMethod::Get, "/sensorData?x=1"},
+    {HttpMethod::Post, "/sensorData"},
+    {HttpMethod::Get, "/sensor"},
+    {HttpMethod::Post, "/list"},
+    {HttpMethod::Get, "//"},
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_route_matches_itself()
+{
+    TEST_ASSERT_EQUAL(WEB_ROUTE_COUNT, ROUTE_COUNT);
+    for (size_t i = 0; i < ROUTE_COUNT; i++)
+    {
+        const TableRoute &route = ROUTES[i];
+        TEST_ASSERT_EQUAL(route.id, webRouteMatch(route.method, route.path, strlen(route.path)));
+        TEST_ASSERT_EQUAL(route.id, linearMatch(route.method, route.path, strlen(route.path)));
+    }
+}
+
+void test_near_misses()
+{
+    for (const Probe &probe : MISSES)
+    {
+        TEST_ASSERT_EQUAL(HTTP_NO_ROUTE, webRouteMatch(probe.method, probe.path, strlen(probe.path)));
+        TEST_ASSERT_EQUAL(HTTP_NO_ROUTE, linearMatch(probe.method, probe.path, strlen(probe.path)));
+    }
+
+    // The server hands over the path in place, not terminated
+    const char request[] = "/sensorDataXYZ";
+    TEST_ASSERT_EQUAL(WEB_ROUTE_SensorData, webRouteMatch(HttpMethod::Get, request, 11));
+}
+
+typedef int (*Match)(HttpMethod method, const char *path, size_t pathLen);
+
+// ns per lookup over every route, then every miss
+static double lookupNs(Match match, bool misses)
+{
+    size_t lengths[ROUTE_COUNT];
+    for (size_t i = 0; i < ROUTE_COUNT; i++)
+        lengths[i] = strlen(ROUTES[i].path);
+
+    long sink = 0;
+    size_t lookups = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int n = 0; n < BENCH_ITERATIONS / (int)ROUTE_COUNT; n++)
+    {
+        if (misses)
+        {
+            for (const Probe &probe : MISSES)
+                sink += match(probe.method, probe.path, strlen(probe.path));
+            lookups += sizeof(MISSES) / sizeof(MISSES[0]);
+        }
+        else
+        {
+            for (size_t i = 0; i < ROUTE_COUNT; i++)
+                sink += match(ROUTES[i].method, ROUTES[i].path, lengths[i]);
+            lookups += ROUTE_COUNT;
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / lookups;
+    TEST_ASSERT_TRUE(sink != 0);
+    return ns;
+}
+
+void test_benchmark()
+{
+    double tableHit = lookupNs(webRouteMatch, false);
+    double linearHit = lookupNs(linearMatch, false);
+    double tableMiss = lookupNs(webRouteMatch, true);
+    double linearMiss = lookupNs(linearMatch, true);
+
+    char line[120];
+    snprintf(line, sizeof(line), "%u routes, per lookup: table %.1f ns hit / %.1f ns miss, linear %.1f / %.1f ns",
+             (unsigned)ROUTE_COUNT, tableHit, tableMiss, linearHit, linearMiss);
+    TEST_MESSAGE(line);
+    TEST_MESSAGE("(host, not ESP32)");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_route_matches_itself);
+    RUN_TEST(test_near_misses);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
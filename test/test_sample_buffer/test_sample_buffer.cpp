@@ -0,0 +1,127 @@
+// SampleBuffer on the host with an in-memory SPIFFS: replay order across
+// the RAM ring and the spill file, the flash budget, a lost spill file and
+// full-width channel values.
+//
+//   pio test -e native -f test_sample_buffer
+
+#include <unity.h>
+#include <SPIFFS.h>
+#include "sample_buffer.h"
+
+#define SPILL_CAPACITY (OFFLINE_FLASH_MAX_BYTES / sizeof(BufferedSample))
+
+static SampleBuffer buffer;
+static uint32_t added;
+
+static void addSamples(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        BufferedSample sample;
+        sample.capturedAt = ++added;
+        sample.channels[SENSOR_CHANNEL_Touch] = added & 1;
+        sample.channels[SENSOR_CHANNEL_BatteryVoltage] = 36300; // 11:1 divider full scale, in mV
+        sample.channels[SENSOR_CHANNEL_BatteryPercent] = -5;
+        buffer.add(sample);
+    }
+}
+
+// Replays everything in OFFLINE_BATCH_SIZE batches; returns the number of
+// samples and fails unless capture times only go up
+static uint32_t drain()
+{
+    BufferedSample batch[OFFLINE_BATCH_SIZE];
+    uint32_t replayed = 0;
+    uint32_t last = 0;
+    size_t n;
+    while ((n = buffer.peek(batch, OFFLINE_BATCH_SIZE)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            TEST_ASSERT_GREATER_THAN(last, batch[i].capturedAt);
+            TEST_ASSERT_EQUAL(36300, batch[i].channels[SENSOR_CHANNEL_BatteryVoltage]);
+            TEST_ASSERT_EQUAL(-5, batch[i].channels[SENSOR_CHANNEL_BatteryPercent]);
+            last = batch[i].capturedAt;
+        }
+        buffer.commit(n);
+        replayed += n;
+    }
+    TEST_ASSERT_TRUE(buffer.isEmpty());
+    return replayed;
+}
+
+void setUp()
+{
+    SPIFFS.files.clear();
+    buffer = SampleBuffer();
+    buffer.begin();
+    added = 0;
+}
+
+void tearDown() {}
+
+void test_ram_only()
+{
+    addSamples(10);
+    TEST_ASSERT_EQUAL(10, buffer.size());
+    TEST_ASSERT_FALSE(SPIFFS.exists(OFFLINE_SPILL_FILE));
+
+    BufferedSample batch[OFFLINE_BATCH_SIZE];
+    TEST_ASSERT_EQUAL(10, buffer.peek(batch, OFFLINE_BATCH_SIZE));
+    buffer.commit(4);
+    TEST_ASSERT_EQUAL(6, buffer.size());
+    // An unacknowledged batch is offered again unchanged
+    TEST_ASSERT_EQUAL(6, buffer.peek(batch, OFFLINE_BATCH_SIZE));
+    TEST_ASSERT_EQUAL(5, batch[0].capturedAt);
+    TEST_ASSERT_EQUAL(6, buffer.peek(batch, OFFLINE_BATCH_SIZE));
+    TEST_ASSERT_EQUAL(5, batch[0].capturedAt);
+    TEST_ASSERT_EQUAL(6, drain());
+}
+
+void test_spill_replays_oldest_first()
+{
+    addSamples(OFFLINE_RAM_SAMPLES * 3 + 7);
+    TEST_ASSERT_TRUE(SPIFFS.exists(OFFLINE_SPILL_FILE));
+    TEST_ASSERT_EQUAL(added, buffer.size());
+    TEST_ASSERT_EQUAL(0, buffer.getDroppedCount());
+
+    // Samples that arrive while replaying still come out in order
+    BufferedSample batch[OFFLINE_BATCH_SIZE];
+    size_t n = buffer.peek(batch, OFFLINE_BATCH_SIZE);
+    TEST_ASSERT_EQUAL(1, batch[0].capturedAt);
+    buffer.commit(n);
+    addSamples(OFFLINE_RAM_SAMPLES);
+
+    TEST_ASSERT_EQUAL(added - n, drain());
+    TEST_ASSERT_FALSE(SPIFFS.exists(OFFLINE_SPILL_FILE));
+}
+
+void test_flash_budget()
+{
+    uint32_t total = SPILL_CAPACITY + OFFLINE_RAM_SAMPLES * 4;
+    addSamples(total);
+    TEST_ASSERT_TRUE(SPIFFS.files[OFFLINE_SPILL_FILE]->size() <= OFFLINE_FLASH_MAX_BYTES);
+    TEST_ASSERT_GREATER_THAN(0, buffer.getDroppedCount());
+    TEST_ASSERT_EQUAL(total, buffer.size() + buffer.getDroppedCount());
+    TEST_ASSERT_EQUAL(total - buffer.getDroppedCount(), drain());
+}
+
+void test_lost_spill_file()
+{
+    addSamples(OFFLINE_RAM_SAMPLES + 1);
+    uint32_t spilled = OFFLINE_RAM_SAMPLES / 2;
+    SPIFFS.remove(OFFLINE_SPILL_FILE);
+
+    TEST_ASSERT_EQUAL(added - spilled, drain());
+    TEST_ASSERT_EQUAL(spilled, buffer.getDroppedCount());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ram_only);
+    RUN_TEST(test_spill_replays_oldest_first);
+    RUN_TEST(test_flash_budget);
+    RUN_TEST(test_lost_spill_file);
+    return UNITY_END();
+}
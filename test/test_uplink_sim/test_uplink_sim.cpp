@@ -0,0 +1,417 @@
+// Many clients sending to one aggregator, simulated in 1 ms steps.
+//
+// Rate: the real SendRateController against a FIFO aggregator whose service
+// time rises for a congested middle phase; a full queue answers 503 and
+// replies carry the same "bp=" hint as sendSensorAck(). Compares the fixed
+// SEND_INTERVAL against AIMD pacing.
+//
+// Slots: the real SlotAllocator and SlotScheduler on a shared channel.
+// Clients listen before sending and defer while it is busy; two that start
+// in the same millisecond collide and retry after a random backoff, like
+// the WiFi MAC. Each client has its own clock offset and drift. Compares
+// TDMA slots against unscheduled sending.
+//
+//   pio test -e native -f test_uplink_sim -v
+
+#include <unity.h>
+#include <algorithm>
+#include <deque>
+#include <stdio.h>
+#include <vector>
+#include "send_rate_controller.h"
+#include "slot_scheduler.h"
+
+#define SIM_CLIENTS 16
+#define SIM_SEND_INTERVAL 200 // SEND_INTERVAL in main.cpp
+#define SIM_DURATION 180000
+#define SIM_CONGESTED_FROM 60000
+#define SIM_CONGESTED_TO 120000
+#define SIM_SERVICE_MS 6       // per request while the link is clean
+#define SIM_CONGESTED_SERVICE_MS 25
+#define SIM_QUEUE_LIMIT 32     // requests the aggregator holds before answering 503
+#define SIM_NETWORK_MS 3       // each way, plus up to as much again of jitter
+#define SIM_RSSI -60
+
+#define SIM_AIR_MS 3         // one /sensor POST on air, headers and retransmits included
+#define SIM_MAC_RETRIES 4    // collisions before the send fails
+#define SIM_BACKOFF_MS 4     // contention window, doubled per collision
+#define SIM_AP_MS 4          // aggregator handling and the ack, after the POST is on air
+#define SIM_MAX_DRIFT_PPM 40 // crystal tolerance, either way
+
+struct SimClient
+{
+    SendRateController rate;
+    uint32_t lastSend;
+    uint32_t sentAt;
+    uint32_t replyAt;
+    bool waiting;
+    int code;
+    int backpressure;
+
+    SimClient() : rate(SIM_SEND_INTERVAL), lastSend(0), sentAt(0), replyAt(0), waiting(false), code(0), backpressure(-1) {}
+};
+
+// One phase's numbers
+struct SimStats
+{
+    uint32_t sent;
+    uint32_t delivered;
+    uint32_t timeouts;
+    uint32_t busy; // 503
+    std::vector<uint32_t> rtts;
+    uint64_t intervalSum; // controller interval, sampled every second per client
+    uint32_t intervalSamples;
+
+    SimStats() : sent(0), delivered(0), timeouts(0), busy(0), intervalSum(0), intervalSamples(0) {}
+
+    uint32_t percentile(int pct)
+    {
+        if (rtts.empty())
+            return 0;
+        std::sort(rtts.begin(), rtts.end());
+        return rtts[std::min(rtts.size() - 1, rtts.size() * pct / 100)];
+    }
+};
+
+struct SimResult
+{
+    SimStats phase[3]; // clean, congested, recovered
+};
+
+static uint32_t rngState;
+
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static int phaseAt(uint32_t now)
+{
+    return now < SIM_CONGESTED_FROM ? 0 : now < SIM_CONGESTED_TO ? 1 : 2;
+}
+
+static SimResult simulate(bool adaptive)
+{
+    rngState = 0x9E3779B9; // both policies see the same jitter sequence
+    std::vector<SimClient> clients(SIM_CLIENTS);
+    for (SimClient &client : clients)
+        client.lastSend = nextRandom() % SIM_SEND_INTERVAL; // own millis() phase
+
+    SimResult result;
+    std::deque<uint32_t> queue; // completion times of accepted requests
+    for (uint32_t now = SIM_SEND_INTERVAL; now < SIM_DURATION; now++)
+    {
+        uint32_t service = phaseAt(now) == 1 ? SIM_CONGESTED_SERVICE_MS : SIM_SERVICE_MS;
+        for (SimClient &client : clients)
+        {
+            SimStats &stats = result.phase[phaseAt(now)];
+            if (client.waiting && now >= client.replyAt)
+            {
+                uint32_t rtt = now - client.sentAt;
+                client.waiting = false;
+                if (client.code == 200)
+                {
+                    stats.delivered++;
+                    stats.rtts.push_back(rtt);
+                }
+                else if (client.code == 503)
+                    stats.busy++;
+                else
+                    stats.timeouts++;
+                if (adaptive)
+                    client.rate.onResult(client.code, rtt, SIM_RSSI, client.code > 0 ? client.backpressure : -1);
+            }
+            if (now % 1000 == 0)
+            {
+                stats.intervalSum += adaptive ? client.rate.getInterval() : SIM_SEND_INTERVAL;
+                stats.intervalSamples++;
+            }
+
+            // The client blocks in http.POST() until the reply or the timeout
+            bool due = adaptive ? client.rate.isDue(now, client.lastSend) : now - client.lastSend >= SIM_SEND_INTERVAL;
+            if (client.waiting || !due)
+                continue;
+            client.lastSend = now;
+            client.sentAt = now;
+            client.waiting = true;
+            stats.sent++;
+
+            uint32_t arrival = now + SIM_NETWORK_MS + nextRandom() % (SIM_NETWORK_MS + 1);
+            while (!queue.empty() && queue.front() <= arrival)
+                queue.pop_front();
+            uint32_t queued = queue.size();
+            uint32_t back = SIM_NETWORK_MS + nextRandom() % (SIM_NETWORK_MS + 1);
+            if (queued >= SIM_QUEUE_LIMIT)
+            {
+                client.code = 503;
+                client.replyAt = arrival + back;
+                continue;
+            }
+            uint32_t done = (queue.empty() ? arrival : std::max(queue.back(), arrival)) + service;
+            queue.push_back(done);
+            int fill = queued * 100 / SIM_QUEUE_LIMIT;
+            client.backpressure = fill < BACKPRESSURE_QUEUE_PERCENT ? 0 : fill;
+            client.code = 200;
+            client.replyAt = done + back;
+            if (client.replyAt - now > UPLINK_HTTP_TIMEOUT)
+            {
+                client.code = -11; // HTTPC_ERROR_READ_TIMEOUT; the aggregator still does the work
+                client.replyAt = now + UPLINK_HTTP_TIMEOUT;
+            }
+        }
+    }
+    return result;
+}
+
+static void report(const char *name, SimResult &result)
+{
+    static const char *const phases[] = {"clean", "congested", "recovered"};
+    for (int p = 0; p < 3; p++)
+    {
+        SimStats &s = result.phase[p];
+        double seconds = (p == 0 ? SIM_CONGESTED_FROM - SIM_SEND_INTERVAL : p == 1 ? SIM_CONGESTED_TO - SIM_CONGESTED_FROM
+                                                                                   : SIM_DURATION - SIM_CONGESTED_TO) / 1000.0;
+        char line[160];
+        snprintf(line, sizeof(line), "%-5s %-9s: %6.1f delivered/s, rtt p50 %4lu p99 %4lu ms, %5lu timeouts, %5lu busy, interval %4lu ms",
+                 name, phases[p], s.delivered / seconds, (unsigned long)s.percentile(50), (unsigned long)s.percentile(99),
+                 (unsigned long)s.timeouts, (unsigned long)s.busy,
+                 (unsigned long)(s.intervalSamples ? s.intervalSum / s.intervalSamples : 0));
+        TEST_MESSAGE(line);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_aimd_against_fixed_interval()
+{
+    SimResult fixed = simulate(false);
+    SimResult aimd = simulate(true);
+    report("fixed", fixed);
+    report("aimd", aimd);
+
+    // While congested, AIMD keeps the aggregator's queue short
+    TEST_ASSERT_LESS_THAN(fixed.phase[1].percentile(50) / 2, aimd.phase[1].percentile(50));
+    // without giving up much of what the aggregator can take
+    TEST_ASSERT_GREATER_THAN(fixed.phase[1].delivered * 8 / 10, aimd.phase[1].delivered);
+    // and it returns to the fastest interval once the link recovers
+    TEST_ASSERT_GREATER_THAN(fixed.phase[2].delivered * 9 / 10, aimd.phase[2].delivered);
+    TEST_ASSERT_LESS_THAN(SIM_SEND_INTERVAL * 3 / 2, aimd.phase[2].intervalSum / aimd.phase[2].intervalSamples);
+}
+
+void test_controller_steps()
+{
+    SendRateController rate(SIM_SEND_INTERVAL);
+    rate.onResult(-1, UPLINK_HTTP_TIMEOUT, SIM_RSSI, -1);
+    TEST_ASSERT_EQUAL(SIM_SEND_INTERVAL * 2, rate.getInterval());
+    rate.onResult(502, 20, SIM_RSSI, -1);
+    TEST_ASSERT_EQUAL(SIM_SEND_INTERVAL * 4, rate.getInterval());
+    rate.onResult(404, 20, SIM_RSSI, -1); // neutral
+    TEST_ASSERT_EQUAL(SIM_SEND_INTERVAL * 4, rate.getInterval());
+    rate.onResult(200, 20, SIM_RSSI, 0);
+    TEST_ASSERT_EQUAL(SIM_SEND_INTERVAL * 4 - RATE_ADDITIVE_STEP, rate.getInterval());
+    rate.onResult(200, 20, SIM_RSSI, RATE_BACKPRESSURE_LIMIT);
+    TEST_ASSERT_EQUAL((SIM_SEND_INTERVAL * 4 - RATE_ADDITIVE_STEP) * 2, rate.getInterval());
+    for (int i = 0; i < 100; i++)
+        rate.onResult(200, 20, SIM_RSSI, 0);
+    TEST_ASSERT_EQUAL(SIM_SEND_INTERVAL, rate.getInterval());
+    rate.onResult(200, 20, RATE_WEAK_RSSI - 1, 0);
+    TEST_ASSERT_EQUAL(SIM_SEND_INTERVAL * 2, rate.getInterval());
+
+    TEST_ASSERT_EQUAL(40, SendRateController::parseBackpressure("OK;t=123;bp=40;slot=2"));
+    TEST_ASSERT_EQUAL(-1, SendRateController::parseBackpressure("OK"));
+}
+
+// ========================= SLOTTED SENDING =========================
+
+struct AirClient
+{
+    SlotScheduler scheduler;
+    uint32_t clockOffset;
+    int32_t driftPpm;
+    uint32_t lastSend; // local clock
+    uint32_t sentAt;   // simulation time
+    uint32_t sentAtLocal;
+    uint32_t txAt;     // next attempt to go on air
+    uint32_t replyAt;
+    uint8_t attempt;
+    bool pending;  // waiting for air
+    bool waiting;  // on air or waiting for the ack
+    bool deferred; // found the channel busy
+    bool failed;
+
+    AirClient() : clockOffset(0), driftPpm(0), lastSend(0), sentAt(0), sentAtLocal(0), txAt(0), replyAt(0),
+                  attempt(0), pending(false), waiting(false), deferred(false), failed(false) {}
+
+    uint32_t localTime(uint32_t now) const { return clockOffset + now + (int32_t)((int64_t)now * driftPpm / 1000000); }
+};
+
+struct AirStats
+{
+    uint32_t sends;
+    uint32_t deferred;  // found the channel busy at least once
+    uint32_t collided;  // collided at least once
+    uint32_t macRetries;
+    uint32_t failed;
+    std::vector<uint32_t> ackMs;
+
+    AirStats() : sends(0), deferred(0), collided(0), macRetries(0), failed(0) {}
+};
+
+static uint32_t backoff(uint8_t attempt)
+{
+    return 1 + nextRandom() % (SIM_BACKOFF_MS << attempt);
+}
+
+static AirStats simulateAir(bool tdma)
+{
+    rngState = 0x85EBCA6B;
+    std::vector<AirClient> clients(SIM_CLIENTS);
+    for (AirClient &client : clients)
+    {
+        client.clockOffset = nextRandom();
+        client.driftPpm = (int32_t)(nextRandom() % (2 * SIM_MAX_DRIFT_PPM + 1)) - SIM_MAX_DRIFT_PPM;
+        client.lastSend = client.localTime(0) - nextRandom() % SIM_SEND_INTERVAL;
+    }
+    SlotAllocator allocator;
+    AirStats stats;
+    uint32_t airBusyUntil = 0;
+    uint32_t warmup = SIM_DURATION / 10; // first acks hand out the slots
+
+    for (uint32_t now = 0; now < SIM_DURATION; now++)
+    {
+        // Everyone whose attempt falls on this millisecond senses the same idle channel
+        std::vector<size_t> starting;
+        for (size_t i = 0; i < clients.size(); i++)
+        {
+            AirClient &client = clients[i];
+            bool counted = now >= warmup;
+
+            if (client.waiting && !client.pending && now >= client.replyAt)
+            {
+                client.waiting = false;
+                if (client.failed)
+                {
+                    client.scheduler.onFailure();
+                    stats.failed += counted;
+                }
+                else
+                {
+                    // The aggregator stamps its ack like sendSensorAck()
+                    uint32_t stampedAt = client.replyAt - SIM_AP_MS / 2;
+                    int slot = allocator.assign(i + 1, tdma ? (int)i : -1, stampedAt);
+                    allocator.recordArrival(i + 1, slot, stampedAt);
+                    char reply[64];
+                    int len = snprintf(reply, sizeof(reply), "OK;t=%lu;bp=0", (unsigned long)stampedAt);
+                    if (tdma && slot >= 0)
+                        snprintf(reply + len, sizeof(reply) - len, ";slot=%d;frame=%d;sw=%d", slot, TDMA_FRAME_MS, TDMA_SLOT_WIDTH);
+                    uint32_t rtt = client.localTime(now) - client.sentAtLocal;
+                    client.scheduler.onAck(String(reply), client.sentAtLocal, rtt);
+                    if (counted)
+                        stats.ackMs.push_back(now - client.sentAt);
+                }
+            }
+
+            if (client.pending && now >= client.txAt)
+            {
+                if (now < airBusyUntil)
+                {
+                    if (!client.deferred)
+                        stats.deferred += counted;
+                    client.deferred = true;
+                    client.txAt = airBusyUntil + backoff(0);
+                    continue;
+                }
+                starting.push_back(i);
+                continue;
+            }
+
+            uint32_t local = client.localTime(now);
+            if (client.waiting || !client.scheduler.isDue(local, client.lastSend, SIM_SEND_INTERVAL))
+                continue;
+            client.lastSend = local;
+            client.sentAt = now;
+            client.sentAtLocal = local;
+            client.txAt = now;
+            client.attempt = 0;
+            client.pending = true;
+            client.waiting = true;
+            client.deferred = false;
+            client.failed = false;
+            stats.sends += counted;
+            i--; // may go on air in this same millisecond
+        }
+
+        if (starting.empty())
+            continue;
+        airBusyUntil = now + SIM_AIR_MS;
+        bool collision = starting.size() > 1;
+        for (size_t i : starting)
+        {
+            AirClient &client = clients[i];
+            bool counted = client.sentAt >= warmup;
+            if (!collision)
+            {
+                client.pending = false;
+                client.replyAt = now + SIM_AIR_MS + SIM_AP_MS + nextRandom() % 3;
+                continue;
+            }
+            if (client.attempt == 0)
+                stats.collided += counted;
+            stats.macRetries += counted;
+            if (++client.attempt > SIM_MAC_RETRIES)
+            {
+                client.pending = false;
+                client.failed = true;
+                client.replyAt = now + SIM_AIR_MS;
+                continue;
+            }
+            client.txAt = now + SIM_AIR_MS + backoff(client.attempt);
+        }
+    }
+    return stats;
+}
+
+static uint32_t percentileOf(std::vector<uint32_t> &values, int pct)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, values.size() * pct / 100)];
+}
+
+static void reportAir(const char *name, AirStats &s)
+{
+    char line[160];
+    snprintf(line, sizeof(line), "%-11s: %6lu sends, %5.1f%% deferred, %5.2f%% collided, %4lu MAC retries, %3lu failed, ack p50 %2lu p99 %2lu ms",
+             name, (unsigned long)s.sends, s.deferred * 100.0 / s.sends, s.collided * 100.0 / s.sends,
+             (unsigned long)s.macRetries, (unsigned long)s.failed,
+             (unsigned long)percentileOf(s.ackMs, 50), (unsigned long)percentileOf(s.ackMs, 99));
+    TEST_MESSAGE(line);
+}
+
+void test_slots_against_unscheduled()
+{
+    AirStats unscheduled = simulateAir(false);
+    AirStats slotted = simulateAir(true);
+    reportAir("unscheduled", unscheduled);
+    reportAir("tdma", slotted);
+
+    // Same offered load, far less contention
+    TEST_ASSERT_GREATER_THAN(unscheduled.sends * 9 / 10, slotted.sends);
+    TEST_ASSERT_LESS_THAN(unscheduled.collided / 4 + 1, slotted.collided);
+    TEST_ASSERT_LESS_THAN(unscheduled.deferred / 4 + 1, slotted.deferred);
+    TEST_ASSERT_LESS_THAN(percentileOf(unscheduled.ackMs, 99) + 1, percentileOf(slotted.ackMs, 99));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_controller_steps);
+    RUN_TEST(test_aimd_against_fixed_interval);
+    RUN_TEST(test_slots_against_unscheduled);
+    return UNITY_END();
+}
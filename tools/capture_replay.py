@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""Replays a traffic capture (CAPTURE_ENABLED in include/config.h) against an aggregator.
+
+Sends the recorded /sensor and /sensorBatch requests in their original
+order at 1x, 10x (or any factor) or maximum speed, then reports throughput
+and latency and reads back /sensorData. Results can be saved and compared
+with an earlier run, so a behaviour change or slowdown between two builds
+shows up against real traffic.
+
+The target must know which sender each request came from: build it with
+CAPTURE_REPLAY_HEADER so the captured address travels in X-Replay-From.
+Restart the target between runs so both start from an empty table.
+
+    curl -o capture.bin http://192.168.1.200/capture.bin
+    python3 tools/capture_replay.py capture.bin --target 192.168.1.201 --speed max --save base.json
+    python3 tools/capture_replay.py capture.bin --target 192.168.1.201 --speed max --compare base.json
+"""
+
+import argparse
+import http.client
+import json
+import socket
+import struct
+import sys
+import time
+
+HEADER = struct.Struct("<HBBI")
+RECORD = struct.Struct("<IIBH")
+MAGIC = 0x4354
+VERSION = 1
+PATHS = {1: "/sensor", 2: "/sensorBatch"}
+
+# Reply fields that depend on the clock or on load rather than on the input
+VOLATILE_FIELDS = ("t=", "bp=", "retry=")
+
+
+def read_capture(path):
+    """Returns (started millis, list of (offset ms, ip string, path, body bytes))."""
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, _flags, started = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("%s: not a version %d capture" % (path, VERSION))
+    offset = HEADER.size
+    records = []
+    while offset + RECORD.size <= len(data):
+        at, ip, kind, length = RECORD.unpack_from(data, offset)
+        offset += RECORD.size
+        body = data[offset:offset + length]
+        if len(body) < length:
+            break  # truncated by a power cut while recording
+        offset += length
+        records.append((at, socket.inet_ntoa(struct.pack("<I", ip)), PATHS.get(kind, "?"), body))
+    return started, records
+
+
+def normalize(status, body):
+    """Response text with the clock and load dependent parts removed."""
+    text = body.decode("utf-8", "replace")
+    text = ";".join(f for f in text.split(";") if not f.startswith(VOLATILE_FIELDS))
+    return "%d %s" % (status, text)
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return 0.0
+    return sorted_values[min(len(sorted_values) - 1, int(len(sorted_values) * pct / 100))]
+
+
+class Target:
+    def __init__(self, host, port, timeout):
+        self.host = host
+        self.port = port
+        self.timeout = timeout
+        self.conn = None
+
+    def request(self, method, path, body=None, sender=None):
+        headers = {}
+        if body is not None:
+            headers["Content-Type"] = "application/x-www-form-urlencoded"
+        if sender:
+            headers["X-Replay-From"] = sender
+        if self.conn is None:
+            self.conn = http.client.HTTPConnection(self.host, self.port, timeout=self.timeout)
+        try:
+            self.conn.request(method, path, body=body, headers=headers)
+            response = self.conn.getresponse()
+            reply = response.read()
+            if response.getheader("Connection", "").lower() == "close":
+                self.close()
+            return response.status, reply
+        except (OSError, http.client.HTTPException):
+            self.close()
+            return 0, b""
+
+    def close(self):
+        self.conn.close()
+        self.conn = None
+
+
+def replay(records, target, speed):
+    outcomes = []
+    latencies = []
+    late = 0
+    samples = 0
+    started = time.monotonic()
+    for at, ip, path, body in records:
+        if speed:
+            due = started + at / 1000.0 / speed
+            wait = due - time.monotonic()
+            if wait > 0:
+                time.sleep(wait)
+            elif wait < -0.05:
+                late += 1
+        sent = time.monotonic()
+        status, reply = target.request("POST", path, body, ip)
+        latencies.append((time.monotonic() - sent) * 1000.0)
+        outcomes.append(normalize(status, reply))
+        if status == 200:
+            samples += body.count(b";") + 1 if path == "/sensorBatch" else 1
+    elapsed = max(time.monotonic() - started, 1e-6)
+
+    latencies.sort()
+    return {
+        "requests": len(records),
+        "samples": samples,
+        "seconds": round(elapsed, 3),
+        "requestsPerSecond": round(len(records) / elapsed, 1),
+        "samplesPerSecond": round(samples / elapsed, 1),
+        "latencyMs": {
+            "p50": round(percentile(latencies, 50), 2),
+            "p99": round(percentile(latencies, 99), 2),
+            "max": round(latencies[-1] if latencies else 0.0, 2),
+        },
+        "late": late,
+        "outcomes": outcomes,
+    }
+
+
+def read_table(target):
+    # Let the aggregator's ingest job apply what is still queued
+    time.sleep(0.2)
+    status, body = target.request("GET", "/sensorData")
+    if status != 200:
+        return {"error": status}
+    return json.loads(body)
+
+
+def diff_runs(base, run, limit):
+    """Prints what changed against a saved run; returns the number of differences."""
+    differences = 0
+    if base["requests"] != run["requests"]:
+        print("request count: %d -> %d (different capture?)" % (base["requests"], run["requests"]))
+        differences += 1
+
+    changed = [i for i, (a, b) in enumerate(zip(base["outcomes"], run["outcomes"])) if a != b]
+    for i in changed[:limit]:
+        print("request %d: %s -> %s" % (i, base["outcomes"][i], run["outcomes"][i]))
+    if len(changed) > limit:
+        print("... %d more changed responses" % (len(changed) - limit))
+    differences += len(changed)
+
+    before, after = base["table"], run["table"]
+    for ip in sorted(set(before) | set(after)):
+        if before.get(ip) != after.get(ip):
+            print("table %s: %s -> %s" % (ip, before.get(ip), after.get(ip)))
+            differences += 1
+
+    print("throughput: %.1f -> %.1f requests/s, p99 %.2f -> %.2f ms" % (
+        base["requestsPerSecond"], run["requestsPerSecond"], base["latencyMs"]["p99"], run["latencyMs"]["p99"]))
+    return differences
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="file downloaded from /capture.bin")
+    parser.add_argument("--target", required=True, help="aggregator host[:port]")
+    parser.add_argument("--speed", default="1", help="time scale, e.g. 1 or 10, or max for no pacing")
+    parser.add_argument("--timeout", type=float, default=5.0)
+    parser.add_argument("--save", help="write the results here for a later --compare")
+    parser.add_argument("--compare", help="results saved by an earlier run")
+    parser.add_argument("--show", type=int, default=10, help="changed responses to print")
+    args = parser.parse_args()
+
+    speed = 0.0 if args.speed == "max" else float(args.speed)
+    host, _, port = args.target.partition(":")
+    started, records = read_capture(args.capture)
+    span = records[-1][0] / 1000.0 if records else 0.0
+    print("%d requests over %.1f s from %d senders (recorded at millis %d)" % (
+        len(records), span, len({r[1] for r in records}), started))
+
+    target = Target(host, int(port or 80), args.timeout)
+    run = replay(records, target, speed)
+    run["table"] = read_table(target)
+
+    codes = {}
+    for outcome in run["outcomes"]:
+        code = outcome.split(" ", 1)[0]
+        codes[code] = codes.get(code, 0) + 1
+    print("%d requests, %d samples in %.2f s: %.1f requests/s, %.1f samples/s" % (
+        run["requests"], run["samples"], run["seconds"], run["requestsPerSecond"], run["samplesPerSecond"]))
+    print("latency p50 %.2f ms, p99 %.2f ms, max %.2f ms; %d requests sent late" % (
+        run["latencyMs"]["p50"], run["latencyMs"]["p99"], run["latencyMs"]["max"], run["late"]))
+    print("responses: " + ", ".join("%s x%d" % (code, n) for code, n in sorted(codes.items())))
+    print("table: %d senders" % len(run["table"]))
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(run, f, indent=1)
+    if args.compare:
+        with open(args.compare) as f:
+            base = json.load(f)
+        differences = diff_runs(base, run, args.show)
+        print("%d differences" % differences)
+        sys.exit(1 if differences else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Test receiver for gateway mode (GATEWAY_ENABLED in include/config.h).
+
+Listens for the aggregator's persistent TCP connection, decodes each
+length-prefixed sensor frame and keeps the merged table.
+
+    python3 tools/gateway_receiver.py --port 9100
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+HEADER = struct.Struct("<HBBIIB")
+ENTRY = struct.Struct("<IhHHHB")
+MAGIC = 0x4653
+FLAG_FULL = 0x01
+
+
+def decode_frame(data):
+    """Returns (header dict, list of entries) for one sensor frame."""
+    magic, version, flags, seq, millis, count = HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError("bad magic 0x%04x" % magic)
+    offset = HEADER.size
+    entries = []
+    for _ in range(count):
+        ip, touch, millivolts, percent10, age, id_len = ENTRY.unpack_from(data, offset)
+        offset += ENTRY.size
+        client_id = data[offset:offset + id_len].decode("ascii", "replace")
+        offset += id_len
+        entries.append({
+            "ip": socket.inet_ntoa(struct.pack("<I", ip)),
+            "clientId": client_id,
+            "touch": touch,
+            "batteryVoltage": millivolts / 1000.0,
+            "batteryPercent": percent10 / 10.0,
+            "ageMs": age,
+        })
+    header = {"version": version, "full": bool(flags & FLAG_FULL), "seq": seq, "millis": millis}
+    return header, entries
+
+
+def read_exact(conn, n):
+    buf = b""
+    while len(buf) < n:
+        chunk = conn.recv(n - len(buf))
+        if not chunk:
+            return None
+        buf += chunk
+    return buf
+
+
+def serve(conn, quiet):
+    table = {}
+    frames = 0
+    total_bytes = 0
+    last_seq = None
+    gaps = 0
+    started = time.time()
+    while True:
+        prefix = read_exact(conn, 2)
+        if prefix is None:
+            break
+        length = struct.unpack("<H", prefix)[0]
+        data = read_exact(conn, length)
+        if data is None:
+            break
+        header, entries = decode_frame(data)
+        if last_seq is not None and header["seq"] != last_seq + 1:
+            gaps += 1
+        last_seq = header["seq"]
+        if header["full"]:
+            table = {}
+        for entry in entries:
+            table[entry["ip"]] = entry
+        frames += 1
+        total_bytes += length + 2
+        if not quiet:
+            kind = "full" if header["full"] else "delta"
+            print("#%d %s: %d changed, %d tracked, %d bytes" % (header["seq"], kind, len(entries), len(table), length))
+            for entry in entries:
+                print("  %(ip)s id=%(clientId)s touch=%(touch)d %(batteryVoltage).3fV %(batteryPercent).1f%% age=%(ageMs)dms" % entry)
+    elapsed = max(time.time() - started, 1e-6)
+    print("connection closed: %d frames, %d bytes, %.1f frames/s, %d sequence gaps" % (frames, total_bytes, frames / elapsed, gaps))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=9100)
+    parser.add_argument("--quiet", action="store_true", help="only print per-connection totals")
+    args = parser.parse_args()
+
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind(("", args.port))
+    listener.listen(1)
+    print("waiting for aggregator on port %d" % args.port)
+    while True:
+        conn, addr = listener.accept()
+        print("aggregator connected from %s:%d" % addr)
+        with conn:
+            serve(conn, args.quiet)
+
+
+if __name__ == "__main__":
+    main()
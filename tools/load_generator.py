@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Concurrent /sensor load against an aggregator, with slow downloads alongside.
+
+Each client thread keeps one connection alive and POSTs /sensor at a fixed
+rate, like a sender board. Slow readers fetch a large response a few bytes
+at a time, the case that used to hold up every other request. Reports
+throughput, response codes and latency percentiles for the /sensor POSTs.
+
+All clients share this host's address, so the aggregator's per-sender
+admission limit (ADMISSION_RATE) rejects most of them with 429. Either turn
+ADMISSION_ENABLED off on the target, or build it with CAPTURE_REPLAY_HEADER
+and pass --replay-header so each client sends as 10.77.0.<n>.
+
+    python3 tools/load_generator.py --target 192.168.1.200 --clients 16 --rate 5 --slow-readers 2
+"""
+
+import argparse
+import http.client
+import socket
+import threading
+import time
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return 0.0
+    return sorted_values[min(len(sorted_values) - 1, int(len(sorted_values) * pct / 100))]
+
+
+class Results:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = []
+        self.codes = {}
+        self.slow_bytes = 0
+        self.slow_done = 0
+
+    def add(self, status, latency_ms):
+        with self.lock:
+            self.codes[status] = self.codes.get(status, 0) + 1
+            if status == 200:
+                self.latencies.append(latency_ms)
+
+
+def sensor_client(args, host, port, index, stop, results):
+    headers = {"Content-Type": "application/x-www-form-urlencoded"}
+    if args.replay_header:
+        headers["X-Replay-From"] = "10.77.0.%d" % (index + 1)
+    conn = None
+    seq = index << 24
+    interval = 1.0 / args.rate
+    # Spread the clients over one interval, as boards booted at different times are
+    next_send = time.monotonic() + interval * index / args.clients
+    while not stop.is_set():
+        wait = next_send - time.monotonic()
+        if wait > 0:
+            time.sleep(wait)
+        next_send += interval
+
+        seq += 1
+        now_ms = int(time.monotonic() * 1000) & 0xFFFFFFFF
+        body = "clientId=%d&touch=%d&batteryVoltage=3.712&batteryPercent=87.5&capturedAt=%d&sentAt=%d&seq=%d" % (
+            index % 16, seq & 1, now_ms, now_ms, seq)
+        started = time.monotonic()
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(host, port, timeout=args.timeout)
+            conn.request("POST", "/sensor", body=body, headers=headers)
+            response = conn.getresponse()
+            response.read()
+            status = response.status
+            if response.getheader("Connection", "").lower() == "close":
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException):
+            status = 0  # timeout or connection error
+            if conn is not None:
+                conn.close()
+            conn = None
+        results.add(status, (time.monotonic() - started) * 1000.0)
+    if conn is not None:
+        conn.close()
+
+
+def slow_reader(args, host, port, stop, results):
+    """Downloads --slow-path over and over at --read-rate bytes/s."""
+    request = ("GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n" % (args.slow_path, host)).encode()
+    chunk = 64
+    pause = chunk / float(args.read_rate)
+    while not stop.is_set():
+        try:
+            sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+            # A small window makes the aggregator's send buffer back up
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1024)
+            sock.settimeout(args.timeout * 10)
+            sock.connect((host, port))
+            sock.sendall(request)
+            while not stop.is_set():
+                data = sock.recv(chunk)
+                if not data:
+                    with results.lock:
+                        results.slow_done += 1
+                    break
+                with results.lock:
+                    results.slow_bytes += len(data)
+                time.sleep(pause)
+        except OSError:
+            time.sleep(0.5)
+        finally:
+            sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--target", required=True, help="aggregator host[:port]")
+    parser.add_argument("--clients", type=int, default=16, help="concurrent /sensor senders")
+    parser.add_argument("--rate", type=float, default=5.0, help="POSTs per second per client")
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds")
+    parser.add_argument("--slow-readers", type=int, default=0, help="concurrent slow downloads")
+    parser.add_argument("--slow-path", default="/styles.css", help="what the slow readers fetch, e.g. /list")
+    parser.add_argument("--read-rate", type=int, default=2048, help="bytes/s per slow reader")
+    parser.add_argument("--replay-header", action="store_true",
+                        help="send X-Replay-From so each client counts as its own sender")
+    parser.add_argument("--timeout", type=float, default=2.0)
+    args = parser.parse_args()
+
+    host, _, port = args.target.partition(":")
+    port = int(port or 80)
+    results = Results()
+    stop = threading.Event()
+    threads = [threading.Thread(target=slow_reader, args=(args, host, port, stop, results), daemon=True)
+               for _ in range(args.slow_readers)]
+    threads += [threading.Thread(target=sensor_client, args=(args, host, port, i, stop, results), daemon=True)
+                for i in range(args.clients)]
+    for thread in threads:
+        thread.start()
+    started = time.monotonic()
+    time.sleep(args.duration)
+    stop.set()
+    for thread in threads:
+        thread.join(args.timeout * 2)
+    elapsed = time.monotonic() - started
+
+    latencies = sorted(results.latencies)
+    total = sum(results.codes.values())
+    print("%d clients at %.1f/s, %d slow readers of %s, %.1f s" % (
+        args.clients, args.rate, args.slow_readers, args.slow_path, elapsed))
+    print("%d requests, %.1f/s offered, %.1f/s answered 200" % (
+        total, args.clients * args.rate, len(latencies) / elapsed))
+    print("responses: " + ", ".join("%s x%d" % (code or "error", n) for code, n in sorted(results.codes.items())))
+    print("latency p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms" % (
+        percentile(latencies, 50), percentile(latencies, 95), percentile(latencies, 99),
+        latencies[-1] if latencies else 0.0))
+    if args.slow_readers:
+        print("slow readers: %.0f bytes/s in total, %d downloads finished" % (
+            results.slow_bytes / elapsed, results.slow_done))
+
+
+if __name__ == "__main__":
+    main()
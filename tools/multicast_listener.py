@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Listener for the aggregator's UDP multicast table (MULTICAST_ENABLED).
+
+Joins the group, applies full and delta frames to a local copy of the
+table and prints it, with datagram rate and sequence gaps.
+
+    python3 tools/multicast_listener.py --group 239.255.42.1 --port 9101
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+from gateway_receiver import decode_frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--group", default="239.255.42.1")
+    parser.add_argument("--port", type=int, default=9101)
+    parser.add_argument("--interface", default="0.0.0.0", help="local address of the interface to join on")
+    parser.add_argument("--quiet", action="store_true", help="print only the periodic summary")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", args.port))
+    membership = struct.pack("4s4s", socket.inet_aton(args.group), socket.inet_aton(args.interface))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    print("listening on %s:%d" % (args.group, args.port))
+
+    tables = {}  # per publishing aggregator
+    last_seq = {}
+    datagrams = 0
+    gaps = 0
+    synced = set()
+    window_start = time.time()
+    while True:
+        data, (sender, _) = sock.recvfrom(2048)
+        try:
+            header, entries = decode_frame(data)
+        except (ValueError, struct.error) as err:
+            print("%s: undecodable datagram (%s)" % (sender, err))
+            continue
+
+        seq = last_seq.get(sender)
+        if seq is not None and header["seq"] != seq + 1:
+            gaps += 1
+        last_seq[sender] = header["seq"]
+        datagrams += 1
+
+        # Deltas are only meaningful on top of a full frame
+        table = tables.setdefault(sender, {})
+        if header["full"]:
+            table.clear()
+            synced.add(sender)
+        for entry in entries:
+            table[entry["ip"]] = entry
+
+        if not args.quiet:
+            kind = "full" if header["full"] else "delta"
+            state = "" if sender in synced else " (waiting for full frame)"
+            print("%s #%d %s: %d changed, %d tracked%s" % (sender, header["seq"], kind, len(entries), len(table), state))
+            for entry in entries:
+                print("  %(ip)s id=%(clientId)s touch=%(touch)d %(batteryPercent).1f%% age=%(ageMs)dms" % entry)
+
+        elapsed = time.time() - window_start
+        if elapsed >= 5:
+            print("-- %.1f datagrams/s, %d sequence gaps, %d aggregators" % (datagrams / elapsed, gaps, len(tables)))
+            datagrams = 0
+            window_start = time.time()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Decoder for the binary UART export (UART_EXPORT_ENABLED in include/config.h).
+
+Splits the byte stream on 0x00, COBS-decodes each frame, checks the
+CRC-16/CCITT-FALSE trailer and decodes the sensor frame. Prints the merged
+table and frames/s. Reads a serial port (needs pyserial) or a capture file.
+
+    python3 tools/uart_decoder.py --device /dev/ttyUSB0 --baud 921600
+    python3 tools/uart_decoder.py --file capture.bin
+
+UartStreamDecoder can also be imported and fed bytes directly.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from gateway_receiver import decode_frame
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("bad COBS block")
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class UartStreamDecoder:
+    """Feed raw bytes; yields (header, entries) for every valid frame."""
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.frames = 0
+        self.crc_errors = 0
+        self.decode_errors = 0
+        self.synced = False  # the first chunk may start mid-frame
+
+    def feed(self, data):
+        self.pending += data
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                return
+            raw = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if not self.synced:
+                self.synced = True
+                continue
+            if not raw:
+                continue
+            try:
+                frame = cobs_decode(raw)
+            except ValueError:
+                self.decode_errors += 1
+                continue
+            if len(frame) < 3 or crc16(frame[:-2]) != struct.unpack_from("<H", frame, len(frame) - 2)[0]:
+                self.crc_errors += 1
+                continue
+            try:
+                header, entries = decode_frame(frame[:-2])
+            except (ValueError, struct.error):
+                self.decode_errors += 1
+                continue
+            self.frames += 1
+            yield header, entries
+
+
+def open_source(args):
+    if args.file:
+        return open(args.file, "rb")
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is required for --device (pip install pyserial)")
+    return serial.Serial(args.device, args.baud, timeout=0.1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--device", default="/dev/ttyUSB0")
+    parser.add_argument("--baud", type=int, default=921600)
+    parser.add_argument("--file", help="decode a captured stream instead of a serial port")
+    parser.add_argument("--quiet", action="store_true", help="print only the periodic summary")
+    args = parser.parse_args()
+
+    source = open_source(args)
+    decoder = UartStreamDecoder()
+    # A file has no partial first frame to skip
+    decoder.synced = bool(args.file)
+    table = {}
+    last_seq = None
+    gaps = 0
+    window_frames = 0
+    window_start = time.time()
+    while True:
+        chunk = source.read(4096)
+        if not chunk and args.file:
+            break
+        for header, entries in decoder.feed(chunk):
+            if last_seq is not None and header["seq"] != last_seq + 1:
+                gaps += 1
+            last_seq = header["seq"]
+            window_frames += 1
+            if header["full"]:
+                table.clear()
+            for entry in entries:
+                table[entry["ip"]] = entry
+            if not args.quiet:
+                kind = "full" if header["full"] else "delta"
+                print("#%d %s: %d changed, %d tracked" % (header["seq"], kind, len(entries), len(table)))
+
+        elapsed = time.time() - window_start
+        if elapsed >= 1:
+            print("-- %.1f frames/s, %d CRC errors, %d undecodable, %d sequence gaps" %
+                  (window_frames / elapsed, decoder.crc_errors, decoder.decode_errors, gaps))
+            window_frames = 0
+            window_start = time.time()
+
+    print("%d frames, %d CRC errors, %d undecodable, %d sequence gaps" %
+          (decoder.frames, decoder.crc_errors, decoder.decode_errors, gaps))
+    for entry in table.values():
+        print("  %(ip)s id=%(clientId)s touch=%(touch)d %(batteryPercent).1f%%" % entry)
+
+
+if __name__ == "__main__":
+    main()